@@ -0,0 +1,338 @@
+#ifndef FIFOHashMap_ConcurrentFIFOHashMap_HPP
+#define FIFOHashMap_ConcurrentFIFOHashMap_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include "FifoHashMap.hpp"
+
+/**
+ *Concurrent FIFO Hash Map
+
+A thread safe front-end for FIFOHashMap, for maps that are used by many threads at once.
+
+ Sharding:
+
+The key space is split across S shards by the hash of the key. Each shard is an independent FIFOHashMap of capacity N/S
+with its own lock, so threads working on different shards never wait for each other. The key is hashed once: the same
+hash selects the shard and is passed to the pre-hashed FIFOHashMap overloads.
+
+ Order of Eviction:
+
+The FIFO order is kept per shard - an element is evicted when N/S newer elements were inserted into its shard.
+With a well mixed hash the shards fill evenly, so the global order is approximately FIFO: an element is evicted after
+about N newer insertions overall. The deviation from N grows with the number of shards and shrinks, relative to N, as
+N/S grows - keep N/S in the thousands when the order matters.
+
+ Value Access:
+
+Lookups return copies of the values, since a reference could be invalidated by another thread as soon as the lock
+is released. To read or modify a value in place, pass a function to visit or update - it runs under the shard lock,
+so it should be short and must not access the map.
+
+ #include "ConcurrentFifoHashMap.hpp"
+
+ConcurrentFIFOHashMap<int, std::string, 1 << 20> concurrentMap;  // 16 shards of 65536 elements
+
+concurrentMap.insert({1, "one"});                                     // from any thread
+std::optional<std::string> value = concurrentMap.find(1);
+concurrentMap.update(2, [](std::string &value) { value += "two"; });  // like operator[]
+ */
+
+/**
+ *
+ * @tparam K - key
+ * @tparam V - Value
+ * @tparam N - The total capacity. Must be a multiple of S.
+ * @tparam S - The number of shards, a power of two.
+ * @tparam Allocator, Hash, KeyEqual, Policies - Same as FIFOHashMap. An eviction sink is called under the lock of the
+ * shard, by the thread that inserted. An eviction policy orders and evicts every shard on its own - with
+ * FIFOHashMapLruEviction, find, contains, visit and update promote the key under the lock of its shard.
+ */
+template<
+        class K,
+        class V,
+        size_t N,
+        size_t S = 16,
+        class Allocator = std::allocator<std::pair<const K, V>>,
+        class Hash = std::hash<K>,
+        class KeyEqual = std::equal_to<K>,
+        class... Policies
+>
+class ConcurrentFIFOHashMap {
+
+    static_assert((S > 0) && ((S & (S - 1)) == 0), "The number of shards must be a power of two");
+    static_assert(N != FIFOHashMapDynamicCapacity, "ConcurrentFIFOHashMap needs a compile time capacity");
+    static_assert((N % S == 0) && (N >= S), "The capacity must be a positive multiple of the number of shards");
+
+    using Map = FIFOHashMap<K, V, N / S, Allocator, Hash, KeyEqual, Policies...>;
+
+    /*Every shard starts on its own cache line, so locking one shard does not slow down the neighbouring ones*/
+    struct alignas(64) Shard {
+        std::mutex m_mutex;
+        Map m_map;
+    };
+
+    /*Members*/
+    std::array<Shard, S> m_shards;
+    Hash m_hasher;
+
+    /*Private methods*/
+    Shard &shardOf(size_t hash);
+
+    /*Methods*/
+public:
+    using value_type = std::pair<const K, V>;
+
+    ConcurrentFIFOHashMap() = default;
+    ConcurrentFIFOHashMap(const ConcurrentFIFOHashMap &other) = delete;
+    ConcurrentFIFOHashMap& operator=(const ConcurrentFIFOHashMap &other) = delete;
+
+    /**
+     * @brief Insert new element to the map. If the key is already exist - do nothing.
+     * If the shard of the key is full, its oldest element is evicted.
+     * @param value - (Key,Value) pair.
+     * @return true if insertion happened, false if it did not.
+     */
+    bool insert(const value_type &value);
+    bool insert(value_type &&value);
+
+    /**
+     * @brief If the key exists, assigns obj to its value. Otherwise inserts it like insert does.
+     * @return true if insertion took place and false if the assignment took place.
+     */
+    template<class M>
+    bool insert_or_assign(const K &key, M &&obj);
+
+    /**
+     * @brief Removes the element (if one exists) with the key equivalent to key.
+     * Not available with FIFOHashMapRingOrder.
+     * @return Number of elements removed (0 or 1).
+     */
+    size_t erase(const K &key);
+
+    /**
+     * @return A copy of the value mapped to key, or an empty optional if there is no such element.
+     */
+    std::optional<V> find(const K &key);
+
+    bool contains(const K &key);
+
+    /**
+     * @brief Calls f(value) with the value mapped to key, under the lock of its shard.
+     * @return false if there is no such element - f is not called.
+     */
+    template<class F>
+    bool visit(const K &key, F &&f);
+
+    /**
+     * @brief Calls f(value) with the value mapped to key, under the lock of its shard.
+     * Like operator[], a value-initialized element is inserted first if the key does not exist.
+     */
+    template<class F>
+    void update(const K &key, F &&f);
+
+    /**
+     * @brief Removes all the elements. Shards are cleared one at a time.
+     */
+    void clear();
+
+    /**
+     * @return Number of elements. Shards are counted one at a time, so while other threads modify the map
+     * this is only a snapshot.
+     */
+    size_t size();
+
+    /**
+     * @brief The counters of all the shards, summed - each shard counts under its own lock, so counting adds no
+     * contention. Needs the FIFOHashMapStats policy. The counts are those of the shard maps: insert_or_assign, erase,
+     * visit and update look the key up first, and count a hit or a miss too.
+     */
+    FIFOHashMapStatistics stats();
+
+    /**
+     * @brief Sets the counters of all the shards to 0, one shard at a time.
+     */
+    void reset_stats();
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    static constexpr size_t shard_count()
+    {
+        return S;
+    }
+
+};
+
+/*ConcurrentFIFOHashMap*/
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+bool ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::insert(const value_type &value)
+{
+    const size_t hash = m_hasher(value.first);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    return shard.m_map.insert(value, hash).second;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+bool ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::insert(value_type &&value)
+{
+    const size_t hash = m_hasher(value.first);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    return shard.m_map.insert(std::move(value), hash).second;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class M>
+bool ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::insert_or_assign(const K &key, M &&obj)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(key, hash);
+    if(it != shard.m_map.end())
+    {
+        it->second = std::forward<M>(obj);
+        return false;
+    }
+    shard.m_map.insert(value_type(key, std::forward<M>(obj)), hash);
+    return true;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::erase(const K &key)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(key, hash);
+    if(it == shard.m_map.end())
+    {
+        return 0;
+    }
+    shard.m_map.erase(it);
+    return 1;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::optional<V> ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::find(const K &key)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(key, hash);
+    if(it == shard.m_map.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+bool ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::contains(const K &key)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    return shard.m_map.find(key, hash) != shard.m_map.end();
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class F>
+bool ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::visit(const K &key, F &&f)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(key, hash);
+    if(it == shard.m_map.end())
+    {
+        return false;
+    }
+    f(it->second);
+    return true;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class F>
+void ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::update(const K &key, F &&f)
+{
+    const size_t hash = m_hasher(key);
+    Shard &shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(key, hash);
+    if(it == shard.m_map.end())
+    {
+        it = shard.m_map.insert(value_type(std::piecewise_construct, std::forward_as_tuple(key), std::tuple<>()),
+                                hash).first;
+    }
+    f(it->second);
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+void ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::clear()
+{
+    for(Shard &shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        shard.m_map.clear();
+    }
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::size()
+{
+    size_t total = 0;
+    for(Shard &shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        total += shard.m_map.size();
+    }
+    return total;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMapStatistics ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::stats()
+{
+    FIFOHashMapStatistics total;
+    for(Shard &shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        total += shard.m_map.stats();
+    }
+    return total;
+}
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+void ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::reset_stats()
+{
+    for(Shard &shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        shard.m_map.reset_stats();
+    }
+}
+
+/********************************************************************************/
+/*ConcurrentFIFOHashMap - private*/
+/********************************************************************************/
+
+template<class K, class V, size_t N, size_t S, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::Shard &
+ConcurrentFIFOHashMap<K, V, N, S, Allocator, Hash, KeyEqual, Policies...>::shardOf(size_t hash)
+{
+    /*A multiplicative hash, unrelated to the mixing the shard applies to pick a bucket -
+     *so the keys of one shard still spread over all of its buckets*/
+    const uint64_t mixed = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+    return m_shards[static_cast<size_t>(mixed >> 40) & (S - 1)];
+}
+
+#endif //FIFOHashMap_ConcurrentFIFOHashMap_HPP
@@ -5,8 +5,56 @@
 #ifndef FIFOHashMap_FIFOHashMap_HPP
 #define FIFOHashMap_FIFOHashMap_HPP
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+/*Snapshots are read through a memory mapping where POSIX provides one, and into a buffer elsewhere*/
+#if defined(__unix__) || defined(__APPLE__)
+#define FIFOHashMap_MMAP_SNAPSHOTS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+/*std::pmr support - FIFOHashMapPmr and FIFOHashMapPoolResource - where the standard library has it*/
+#if __has_include(<memory_resource>)
+#define FIFOHashMap_PMR
+#include <memory_resource>
+#endif
+/*Bucket groups are matched with SSE2 where it is available. Define FIFOHashMap_SCALAR_GROUPS to use the portable loop.*/
+#if !defined(FIFOHashMap_SCALAR_GROUPS) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define FIFOHashMap_SSE2_GROUPS
+#include <emmintrin.h>
+#endif
 
 /**
  *FIFO Hash Map
@@ -36,6 +84,111 @@ The first element inserted is the first to be removed when the maximum capacity
 When attempting to insert a new element beyond the maximum capacity, the FIFO Hash Map automatically evicts the oldest element.
 This eviction ensures that the map always maintains a fixed number of elements, preventing unbounded growth.
 
+ Storage:
+
+Since 'N' is known at compile time, all the storage is allocated once, when the map is constructed:
+ - A contiguous array of exactly N cells. Each cell holds one (Key,Value) pair and the 32-bit indices of its
+   neighbours in the FIFO order, so the queue is threaded through the array without any per-element allocation.
+ - An open-addressing (linear probing) bucket array, at most 87% full by default (see FIFOHashMapMaxLoad).
+   Buckets come in groups of 7 that fill one cache line, with a control byte each: 7 bits of the key hash, or empty.
+   A probe compares the control bytes of a whole group at once (with SSE2 where available), then the full 32-bit
+   hash kept in the bucket, and only then the key in the cell.
+Inserting, erasing and evicting never allocate or free memory on their own (the key and value types still may).
+An insertion into a full map assigns the new key and value over the element it evicts, in its cell, unless the
+evicted element is handed to a sink: a std::string keeps its buffer, so a map at capacity does not reallocate it.
+The key is stored once, inside the cell; memory_usage() and bytes_per_entry() report the resulting footprint.
+Maps that only insert and rely on automatic eviction can use FIFOHashMapRingOrder instead: the cell array becomes a
+circular buffer in insertion order and the cells carry no links at all.
+
+ Runtime Capacity:
+
+Passing N = FIFOHashMapDynamicCapacity makes the capacity a constructor argument, which set_capacity() can change:
+ - Shrinking evicts the oldest elements (to the eviction sink, if there is one) and compacts the rest into smaller
+   arrays in a single pass, using the cached hashes - nothing is looked up or hashed again.
+ - Growing moves the elements to a larger cell array at the same indices. When the bucket array has to grow too,
+   the entries are moved to the new one incrementally, a few clusters on every following find/insert/erase.
+Maps with a compile time N hold no state for this and generate the same code as before.
+
+ Evicted Elements:
+
+By default an element evicted to make room for a new one is destroyed. To consume it instead (flush it to a writer,
+aggregate it...), either pass a FIFOHashMapEvictionSink policy, which receives every such element by move,
+or use the insert overload that moves the evicted element out to the caller.
+pop(oldest) and drain(count, out) move the oldest elements out explicitly.
+
+ Eviction Policies:
+
+Which element a full map evicts is decided by its eviction policy. The default, FIFOHashMapFifoEviction, evicts the
+oldest element. FIFOHashMapLruEviction evicts the least recently used one instead: find, find_batch and operator[]
+move the element they find to the tail, in the same probe. That relinks the element on every hit; the policies below
+only mark it, and do the work when they evict:
+ - FIFOHashMapClockEviction - second chance: a visited head is moved to the tail instead of being evicted.
+ - FIFOHashMapSieveEviction - a hand skips the visited elements in place and evicts the first one that is not.
+ - FIFOHashMapS3FifoEviction - new elements pass through a small queue first, and only those hit there reach the
+   main queue; elements evicted from the small queue are remembered, by hash, and come back straight into the main one.
+Other policies plug in through the hooks described at FIFOHashMapFifoEviction; they see the map through
+FIFOHashMapEvictionOrder and need FIFOHashMapLinkedOrder.
+pop(), drain() and iteration still go from the head to the tail.
+
+ Expiry:
+
+With the FIFOHashMapExpiry policy every element is stamped with its insertion time, and set_ttl() bounds its age as
+well as capacity bounds the count. In insertion order the expired elements are all at the head, so expire(now) removes
+them from there and stops at the first live one - its cost is the number of expired elements, with no scan of the
+rest. Between calls lookups stay exact: find, operator[] and the inserts remove an expired element they come across
+and carry on as if it was not there. The clock is a member of the map and can be replaced in tests.
+
+ Statistics:
+
+With the FIFOHashMapStats policy the map counts hits and misses, insertions, inserts dropped as duplicates, evictions,
+erasures, moves, pops and probe lengths; stats() returns them and reset_stats() zeroes them.
+Without it there are no counters at all - the map is the same size and runs the same code.
+
+ Aggregates:
+
+A sliding window usually wants the count, sum, mean, min or max of its values. With the FIFOHashMapAggregates policy
+the map keeps them as elements are inserted, assigned (operator[] included), evicted, popped and erased, and
+aggregate<Aggregate>() returns them without a scan: count, sum and mean are undone in O(1) when an element leaves,
+min and max keep the values in a heap indexed by cell, which takes O(log n) for a change anywhere in the map.
+Aggregates are declared as monoids (see FIFOHashMapAggregates), so others plug in the same way:
+
+FIFOHashMap<uint64_t, double, N, std::allocator<std::pair<const uint64_t, double>>, std::hash<uint64_t>,
+            std::equal_to<uint64_t>, FIFOHashMapAggregates<FIFOHashMapMean<double>, FIFOHashMapMax<double>>> window;
+window.insert({id, latency});
+double peak = window.aggregate<FIFOHashMapMax<double>>();
+
+ Allocators:
+
+The Allocator allocates the cell and bucket arrays, and constructs the elements, like the allocator of a standard
+container: keys and values that take an allocator (std::pmr::string...) get the one of the map. Constructors take an
+allocator, a hash and a key comparator, and the copies of the map keep them.
+Since the arrays are only allocated by constructors and set_capacity(), only the elements themselves may allocate
+afterwards. FIFOHashMapPmr is a map with a std::pmr::polymorphic_allocator, and FIFOHashMapPoolResource a memory
+resource for its elements, that allocates all their memory up front - then inserting and evicting elements that
+allocate do not call malloc or free either:
+
+FIFOHashMapPoolResource pool(64, N);                          // a 64 byte block for each of the N values
+FIFOHashMapPmr<uint64_t, std::pmr::string, N> fifoMap(&pool);
+fifoMap.insert_or_assign(id, name);                           // the value is copied into a block of the pool
+
+ String Keys:
+
+With a transparent Hash and KeyEqual - FIFOHashMapStringHash and std::equal_to<> - find, erase, moveElementToTail and
+moveElementToHead take a key of any type that compares equal to the keys, so a std::string_view or a const char* out of
+a network buffer is looked up as it is, without building a std::string first. FIFOHashMapStringKeys is such a map.
+FIFOHashMapInlineStringKeys also replaces std::string with FIFOHashMapInlineString, which holds up to 31 characters
+(by default) inside itself - in the cell, next to the cached hash - and compares two of them with one fixed size
+comparison: after the bucket hashes match, a lookup of a short key reads no memory but the cell.
+
+ Traversal:
+
+The iterators are bidirectional, and const_iterator, cbegin() and cend() iterate a const map, so the standard
+algorithms work on the FIFO order. for_each(fn) calls fn(element, position) with the position of each element in
+the order, 0 being the oldest. for_each_parallel(fn, threads) does the same on several threads: in linked order a
+walk is a chain of cache misses, so the list is cut into sublists starting at cells spread over the array, measured
+on the threads, then walked again on them, each element still with its exact position. erase_if(pred, threads)
+erases what pred selects the same way - the predicate runs on the threads and the erasing on the caller.
+
  Usage Scenarios:
 
 Well-suited for scenarios where there is a need to maintain a sliding window of recent data.
@@ -61,570 +214,5444 @@ fifoMap.insert({6, "six"});  // Evicts the oldest element (1, "one") and inserts
  It combines the benefits of hash-based access with the simplicity of a first-in-first-out mechanism.
  */
 
-template<class K, class V>
-class FIFOHashMapCell
+/********************************************************************************/
+/*Policies*/
+/********************************************************************************/
+
+/*
+ * Optional behaviour is selected by passing policy types after KeyEqual, in any order:
+ *   FIFOHashMap<int, int, 1024, std::allocator<...>, std::hash<int>, std::equal_to<int>, FIFOHashMapRingOrder>
+ * Every policy declares the category it belongs to; a category that is not given gets its default.
+ */
+
+struct FIFOHashMapOrderPolicyTag {};
+
+/**
+ * @brief Default order policy - the FIFO order is a doubly linked list threaded through the cells.
+ * Supports erase, moveElementToHead and moveElementToTail.
+ */
+struct FIFOHashMapLinkedOrder
 {
-    template <class KK,class VV, size_t N, class Hash, class KeyEqual, class Allocator>
-    friend class FIFOHashMap;
-    K m_key;
-    V m_value;
-    std::pair<const K, V&> m_keyValPair = {m_key, m_value};
-    FIFOHashMapCell<K,V> *m_next = nullptr;
-    FIFOHashMapCell<K,V> *m_prev = nullptr;
+    using policy_category = FIFOHashMapOrderPolicyTag;
+    static constexpr bool isRing = false;
+};
+
+/**
+ * @brief Ring order policy for insert-only maps - the cell array itself is a circular buffer in insertion order.
+ * Cells carry no links, eviction overwrites the cell at the head and iteration walks the array sequentially.
+ * erase, moveElementToHead and moveElementToTail are not available in this mode.
+ */
+struct FIFOHashMapRingOrder
+{
+    using policy_category = FIFOHashMapOrderPolicyTag;
+    static constexpr bool isRing = true;
+};
+
+struct FIFOHashMapEvictionSinkPolicyTag {};
+
+/**
+ * @brief Default eviction sink - elements evicted at capacity are just destroyed.
+ */
+struct FIFOHashMapDiscardEvicted
+{
+    template<class Key, class Value>
+    void operator()(Key&&, Value&&) const
+    {
+    }
+};
+
+/**
+ * @brief Eviction sink policy. The map holds a Sink (see eviction_sink()) and calls sink(K&&, V&&) with every element
+ * it evicts to make room for a new one, just before the element is destroyed.
+ * Elements removed by erase, pop, drain or clear are not passed to the sink.
+ * The sink must not modify the map. If it throws, the map is left unchanged - nothing is evicted or inserted,
+ * though the element may already have been moved from.
+ * @tparam Sink - Default constructible callable, e.g. a functor holding a pointer to a writer,
+ * or std::function<void(K&&, V&&)>.
+ */
+template<class Sink>
+struct FIFOHashMapEvictionSink
+{
+    using policy_category = FIFOHashMapEvictionSinkPolicyTag;
+    using sink_type = Sink;
+};
+
+struct FIFOHashMapEvictionPolicyTag {};
+
+/**
+ * @brief Default eviction policy - a full map evicts its head, the oldest element, and lookups do not change the order.
+ *
+ * An eviction policy is a default constructible class that the map holds (see eviction_policy()) and calls with an
+ * order view of itself (see FIFOHashMapEvictionOrder) and the index of the cell of an element:
+ *  - on_insert(order, index) - the element was inserted, at the tail.
+ *  - on_access(order, index) - find, find_batch or operator[] found the element.
+ *  - on_erase(order, index) - the element is about to be removed, for whatever reason.
+ *  - victim(order) - the map is full: returns the index of the element to evict. It is removed right after,
+ *    with on_erase, so victim may look at and reorder elements but must not keep the index.
+ *  - on_rebuild(order) - the elements were renumbered (set_capacity shrank the map, or it was copied): per element
+ *    state has to start over from what order holds.
+ * Policies other than this one need FIFOHashMapLinkedOrder. Derive from it to override only some of the hooks.
+ */
+struct FIFOHashMapFifoEviction
+{
+    using policy_category = FIFOHashMapEvictionPolicyTag;
+
+    template<class Order>
+    void on_insert(Order&, uint32_t)
+    {
+    }
+
+    template<class Order>
+    void on_access(Order&, uint32_t)
+    {
+    }
+
+    template<class Order>
+    void on_erase(Order&, uint32_t)
+    {
+    }
+
+    template<class Order>
+    uint32_t victim(Order &order)
+    {
+        return order.head();
+    }
+
+    template<class Order>
+    void on_rebuild(Order&)
+    {
+    }
+};
+
+/**
+ * @brief Least recently used eviction - a lookup that finds an element moves it to the tail, in the same probe,
+ * so the head is the element used least recently.
+ */
+struct FIFOHashMapLruEviction : FIFOHashMapFifoEviction
+{
+    template<class Order>
+    void on_access(Order &order, uint32_t index)
+    {
+        order.move_to_tail(index);
+    }
+};
+
+/**
+ * @brief Base of the policies that only mark an element as visited when a lookup finds it, and do the work of keeping
+ * the popular elements when evicting. A hit writes a single byte, and none at all if the element is already marked,
+ * so repeated hits on the same elements leave their cache lines clean.
+ */
+class FIFOHashMapVisitedEviction : public FIFOHashMapFifoEviction
+{
+protected:
+    std::vector<uint8_t> m_visited;
 
 public:
-    FIFOHashMapCell() : m_key{}, m_value{} {}
-    FIFOHashMapCell(const K &key, const V &val) : m_key(key), m_value(val)  {}
-    explicit FIFOHashMapCell(const std::pair<const K, V> &pair): m_key(pair.first), m_value(pair.second){}
-    explicit FIFOHashMapCell(std::pair<const K, V> &&pair): m_key(pair.first), m_value(pair.second){}
-    FIFOHashMapCell(const FIFOHashMapCell & cell): m_key{cell.m_key}, m_value{cell.m_value}{}
-    FIFOHashMapCell( FIFOHashMapCell && cell) noexcept : m_key{cell.m_key}, m_value{cell.m_value}{}
-    FIFOHashMapCell& operator=(const FIFOHashMapCell &other)
+    template<class Order>
+    void on_insert(Order &order, uint32_t index)
     {
-        if(this == &other)
+        if(index >= m_visited.size())
         {
-            return *this;
+            /*Sized once, on the first insertion - and again when a dynamic capacity grows*/
+            m_visited.resize(order.capacity(), 0);
         }
+        m_visited[index] = 0;
+    }
 
-        m_key = other.m_key;
-        m_value = other.m_value;
-        return *this;
+    template<class Order>
+    void on_access(Order&, uint32_t index)
+    {
+        if(!m_visited[index])
+        {
+            m_visited[index] = 1;
+        }
     }
-    FIFOHashMapCell& operator=(FIFOHashMapCell &&other)noexcept
+
+    template<class Order>
+    void on_rebuild(Order &order)
     {
-        m_key = other.m_key;
-        m_value = other.m_value;
-        return *this;
+        m_visited.assign(order.capacity(), 0);
     }
 
-    K getKey() const;
+    /**
+     * @return Whether a lookup found the element since it was inserted or last passed over for eviction.
+     */
+    bool visited(uint32_t index) const
+    {
+        return (index < m_visited.size()) && m_visited[index];
+    }
+};
 
-    V getValue() const;
+/**
+ * @brief CLOCK (second chance) eviction. The head is evicted unless it was visited - then it is unmarked and moved to
+ * the tail, and the next element is tried.
+ */
+class FIFOHashMapClockEviction : public FIFOHashMapVisitedEviction
+{
+public:
+    template<class Order>
+    uint32_t victim(Order &order)
+    {
+        /*Ends within one round - every element it passes is unmarked*/
+        uint32_t index = order.head();
+        while(m_visited[index])
+        {
+            m_visited[index] = 0;
+            order.move_to_tail(index);
+            index = order.head();
+        }
+        return index;
+    }
+};
 
-    FIFOHashMapCell *getNext() const;
+/**
+ * @brief SIEVE eviction. A hand moves from the head towards the tail, unmarking the visited elements it passes and
+ * evicting the first one that is not marked. Unlike CLOCK the survivors keep their place, so nothing is relinked,
+ * and new elements - at the tail - are reached by the hand last.
+ */
+class FIFOHashMapSieveEviction : public FIFOHashMapVisitedEviction
+{
+    static constexpr uint32_t npos = UINT32_MAX;
+    uint32_t m_hand = npos;
 
-    FIFOHashMapCell *getPrev() const;
+public:
+    template<class Order>
+    void on_erase(Order &order, uint32_t index)
+    {
+        if(index == m_hand)
+        {
+            m_hand = order.next(index);
+        }
+    }
 
-    friend std::ostream &operator<<(std::ostream &os, const FIFOHashMapCell &cell) {
-        os << "(" << cell.m_key <<  " , " << cell.m_value << ")";
-        return os;
+    template<class Order>
+    uint32_t victim(Order &order)
+    {
+        uint32_t index = (m_hand == npos) ? order.head() : m_hand;
+        while(m_visited[index])
+        {
+            m_visited[index] = 0;
+            index = order.next(index);
+            if(index == npos)
+            {
+                index = order.head();
+            }
+        }
+        m_hand = index;
+        return index;
     }
 
-    ~FIFOHashMapCell() = default;
+    template<class Order>
+    void on_rebuild(Order &order)
+    {
+        FIFOHashMapVisitedEviction::on_rebuild(order);
+        m_hand = npos;
+    }
 };
 
 /**
- *
- * @tparam K - key
- * @tparam V - Value
- * @tparam N - The size of the array.
- * @tparam Hash - Hash function.
- * @tparam KeyEqual
- * @tparam Allocator
+ * @brief S3-FIFO eviction: a small FIFO queue that new elements enter, a main FIFO queue for the elements that proved
+ * popular, and a ghost queue that remembers the hashes of the elements recently evicted from the small queue.
+ *  - A lookup hit only counts the accesses of the element, up to 3.
+ *  - New elements enter the small queue, or the main queue if their hash is in the ghost queue.
+ *  - While the small queue holds at least SmallPercent of the capacity, its head is evicted, to the ghost queue -
+ *    unless it was accessed, then it moves to the main queue. Otherwise the head of the main queue is evicted,
+ *    unless it was accessed: then its count drops by one and it moves to the tail of the main queue.
+ * The queues are kept by the policy, in per-cell arrays that are allocated on the first insertion; the order of the
+ * map itself stays the insertion order. The ghost queue is a table of hashes with as many entries as the capacity
+ * (rounded up to a power of two), where a newer hash overwrites an older one that maps to the same entry -
+ * an approximation of a FIFO of keys that needs no allocation and no keys.
  */
-template<
-        class K,
-        class V,
-        size_t N,
-        class Allocator = std::allocator<std::pair<const K,  FIFOHashMapCell<K,V>>>,
-        class Hash = std::hash<K>,
-        class KeyEqual = std::equal_to<K>
->
-class FIFOHashMap {
-
-    class FIFOHashMapQueue {
-        friend class FIFOHashMap;
-        FIFOHashMapCell<K,V> *m_pHead = nullptr;
-        FIFOHashMapCell<K,V> *m_pTail = nullptr;
-
-    public:
-        FIFOHashMapQueue() = default;
-        ~FIFOHashMapQueue() = default;
+template<size_t SmallPercent = 10>
+class FIFOHashMapS3FifoEviction : public FIFOHashMapFifoEviction
+{
+    static_assert(SmallPercent > 0 && SmallPercent < 100, "The small queue holds a part of the capacity");
 
-        void addLast( FIFOHashMapCell<K,V>* pCell);
-        void removeLast();
-        void removeFirst();
-        void removeCell( FIFOHashMapCell<K,V> *cell);
+    static constexpr uint32_t npos = UINT32_MAX;
+    static constexpr uint8_t MAX_FREQUENCY = 3;
 
+    struct Node
+    {
+        uint32_t m_prev;
+        uint32_t m_next;
+        uint8_t m_frequency;
+        bool m_main;
     };
 
+    struct Queue
+    {
+        uint32_t m_head = npos;
+        uint32_t m_tail = npos;
+        size_t m_size = 0;
+    };
 
-    class FIFOHashMapIterator {
-        friend class FIFOHashMap;
-        using unordered_map =std::unordered_map<K,FIFOHashMapCell<K,V>,Hash, KeyEqual, Allocator>;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_ghost;
+    Queue m_small;
+    Queue m_main;
 
-    private:
-        FIFOHashMapCell<K,V> *m_pCurrCell;
-        unordered_map* m_pMap;
-        bool m_isReverse;
+    void pushBack(Queue &queue, uint32_t index)
+    {
+        Node &node = m_nodes[index];
+        node.m_prev = queue.m_tail;
+        node.m_next = npos;
+        if(queue.m_tail != npos)
+        {
+            m_nodes[queue.m_tail].m_next = index;
+        }
+        else
+        {
+            queue.m_head = index;
+        }
+        queue.m_tail = index;
+        queue.m_size++;
+    }
 
-    public:
-        FIFOHashMapIterator(FIFOHashMapCell<K,V> *pCellPtr, unordered_map *pMap, bool reverse = false);
-        ~FIFOHashMapIterator() = default;
-        std::pair<const K, V&>& operator*();
-        std::pair<const K, V&>* operator->();
-        FIFOHashMapIterator& operator++();
-        FIFOHashMapIterator& operator++(int);
-        FIFOHashMapIterator& operator--();
-        FIFOHashMapIterator& operator--(int);
-        bool operator==(const FIFOHashMapIterator &other);
-        bool operator!=(const FIFOHashMapIterator &other);
+    void unlink(Queue &queue, uint32_t index)
+    {
+        const Node &node = m_nodes[index];
+        (node.m_prev != npos ? m_nodes[node.m_prev].m_next : queue.m_head) = node.m_next;
+        (node.m_next != npos ? m_nodes[node.m_next].m_prev : queue.m_tail) = node.m_prev;
+        queue.m_size--;
+    }
 
-    };
+    /*0 marks an empty ghost entry, so the lowest bit - also part of the entry index - is always set*/
+    uint32_t &ghostEntry(uint32_t hash)
+    {
+        return m_ghost[hash & (m_ghost.size() - 1)];
+    }
 
-    /*Members*/
-    std::unordered_map<K, FIFOHashMapCell<K,V>,Hash, KeyEqual, Allocator> m_map;
-    FIFOHashMapQueue m_queue;
-    size_t m_size;
+    template<class Order>
+    void resize(Order &order)
+    {
+        size_t ghostSize = 1;
+        while(ghostSize < order.capacity())
+        {
+            ghostSize *= 2;
+        }
+        m_nodes.resize(order.capacity());
+        m_ghost.assign(ghostSize, 0);
+    }
 
-    /*Methods*/
 public:
-    FIFOHashMap();
-    FIFOHashMap(std::initializer_list<std::pair<const K, V>> initList);
+    template<class Order>
+    void on_insert(Order &order, uint32_t index)
+    {
+        if(index >= m_nodes.size())
+        {
+            resize(order);
+        }
+        uint32_t &ghost = ghostEntry(order.hash(index));
+        const bool wasEvicted = (ghost == (order.hash(index) | 1));
+        if(wasEvicted)
+        {
+            ghost = 0;
+        }
+        m_nodes[index].m_frequency = 0;
+        m_nodes[index].m_main = wasEvicted;
+        pushBack(wasEvicted ? m_main : m_small, index);
+    }
 
-    ~FIFOHashMap() = default;
+    template<class Order>
+    void on_access(Order&, uint32_t index)
+    {
+        if(m_nodes[index].m_frequency < MAX_FREQUENCY)
+        {
+            m_nodes[index].m_frequency++;
+        }
+    }
 
+    template<class Order>
+    void on_erase(Order&, uint32_t index)
+    {
+        unlink(m_nodes[index].m_main ? m_main : m_small, index);
+    }
 
-    using value_type = std::pair<const K, V>;
+    template<class Order>
+    uint32_t victim(Order &order)
+    {
+        const size_t smallTarget = std::max<size_t>(1, order.capacity() * SmallPercent / 100);
+        for(;;)
+        {
+            if((m_small.m_size >= smallTarget) || (m_main.m_size == 0))
+            {
+                const uint32_t index = m_small.m_head;
+                if(m_nodes[index].m_frequency == 0)
+                {
+                    ghostEntry(order.hash(index)) = order.hash(index) | 1;
+                    return index;
+                }
+                unlink(m_small, index);
+                m_nodes[index].m_frequency = 0;
+                m_nodes[index].m_main = true;
+                pushBack(m_main, index);
+            }
+            else
+            {
+                const uint32_t index = m_main.m_head;
+                if(m_nodes[index].m_frequency == 0)
+                {
+                    return index;
+                }
+                unlink(m_main, index);
+                m_nodes[index].m_frequency--;
+                pushBack(m_main, index);
+            }
+        }
+    }
 
-    /*Insert methods*/
-    /**
-     * @brief Insert new element to the hash map. If the key is already exist - do nothing.
-     * @param value - (Key,Value) pair.
-     * @return A std::pair consisting of an iterator to the inserted element
-     * (or to the element that prevented the insertion) and a bool denoting whether the insertion took place
-     * (true if insertion happened, false if it did not).
-     */
-    std::pair<FIFOHashMapIterator, bool> insert(const value_type& value);
-    std::pair<FIFOHashMapIterator,bool> insert( value_type&& value );
+    template<class Order>
+    void on_rebuild(Order &order)
+    {
+        /*Whatever was learned about the elements is lost - they all start over in the small queue*/
+        m_small = Queue{};
+        m_main = Queue{};
+        resize(order);
+        for(uint32_t index = order.head(); index != npos; index = order.next(index))
+        {
+            m_nodes[index].m_frequency = 0;
+            m_nodes[index].m_main = false;
+            pushBack(m_small, index);
+        }
+    }
 
-    /*Erase methods*/
-    /**
-     * @brief Removes the element at pos.
-     * @param pos - iterator to the element to remove.
-     * @return Iterator following the last removed element.
-     */
-    FIFOHashMapIterator erase( FIFOHashMapIterator pos );
     /**
-     * @brief  Removes the element (if one exists) with the key equivalent to key.
-     * @param key
-     * @return Number of elements removed (0 or 1).
+     * @return The number of elements in the small and in the main queue.
      */
-    size_t erase( const K& key );
+    std::pair<size_t, size_t> queue_sizes() const
+    {
+        return {m_small.m_size, m_main.m_size};
+    }
+};
+
+/**
+ * @brief The view of a map that its eviction policy gets: the elements by the index of their cell, in [0, capacity()),
+ * in the order of the map from the head to the tail.
+ */
+template<class Map>
+class FIFOHashMapEvictionOrder
+{
+    Map &m_map;
+
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit FIFOHashMapEvictionOrder(Map &map) : m_map(map)
+    {
+    }
 
     /**
-     * @brief Finds an element with key equivalent to key.
-     * @param key - key value of the element to search for
-     * @return An iterator to the requested element. If no such element is found,
-     * past-the-end (see end()) iterator is returned.
-     *
+     * @return The index of the first element, or npos if the map is empty.
      */
-    FIFOHashMapIterator find(const K& key);
+    uint32_t head() const
+    {
+        return m_map.headIndex();
+    }
 
-    /*Value access*/
     /**
-     * @brief Returns a reference to the value that is mapped to a key equivalent to key,
-     * performing an insertion if such key does not already exist.
-     * @param key - the key of the element to find
-     * @return A reference to the mapped value of the new element if no element with key key existed.
-     * Otherwise, a reference to the mapped value of the existing element whose key is equivalent to key.
+     * @return The index of the last element, or npos if the map is empty.
      */
-    V& operator[]( const K& key );
+    uint32_t tail() const
+    {
+        return m_map.tailIndex();
+    }
+
     /**
-     * @brief Returns a reference to the value that is mapped to a key equivalent to key,
-     * performing an insertion if such key does not already exist.
-     * @param key - the key of the element to find
-     * @return A reference to the mapped value of the new element if no element with key key existed.
-     * Otherwise, a reference to the mapped value of the existing element whose key is equivalent to key.
+     * @return The index of the element after index, or npos after the tail.
      */
-    V& operator[]( K&& key );
+    uint32_t next(uint32_t index) const
+    {
+        return m_map.nextIndex(index);
+    }
 
     /**
-     * @brief Popping the first element in the queue
+     * @return The index of the element before index, or npos before the head.
      */
-    void pop();
+    uint32_t prev(uint32_t index) const
+    {
+        return m_map.prevIndex(index);
+    }
+
+    void move_to_tail(uint32_t index)
+    {
+        m_map.m_queue.removeCell(m_map.m_cells.data(), index);
+        m_map.m_queue.addLast(m_map.m_cells.data(), index);
+    }
+
+    void move_to_head(uint32_t index)
+    {
+        m_map.m_queue.removeCell(m_map.m_cells.data(), index);
+        m_map.m_queue.addFirst(m_map.m_cells.data(), index);
+    }
 
     /**
-     * @brief Move the element to the end of the queue if existed. If not - do nothing
-     * @param key
+     * @return The 32-bit hash of the key of an element, as cached by the map.
      */
-    void moveElementToTail(const K& key);
+    uint32_t hash(uint32_t index) const
+    {
+        return m_map.cellHash(index);
+    }
 
     /**
-     * @brief Move the element to the beginning of the queue if existed. If not - do nothing
-     * @param key
+     * @return The (Key,Value) pair of an element.
      */
-    void moveElementToHead(const K& key);
+    typename Map::value_type &element(uint32_t index) const
+    {
+        return m_map.m_cells[index].keyValPair();
+    }
+
+    size_t size() const
+    {
+        return m_map.size();
+    }
+
+    size_t capacity() const
+    {
+        return m_map.capacity();
+    }
+};
+
+struct FIFOHashMapMaxLoadPolicyTag {};
+
+/**
+ * @brief Bucket load policy - the bucket array is the smallest power of two groups that keeps it at most Percent% full.
+ * The default is 87: control bytes keep probes short up to that load. A lower load buys shorter clusters for the
+ * backward shift of erase and eviction with memory.
+ */
+template<size_t Percent>
+struct FIFOHashMapMaxLoad
+{
+    static_assert((Percent >= 10) && (Percent <= 90), "The maximum bucket load must be in [10, 90] percent");
+    using policy_category = FIFOHashMapMaxLoadPolicyTag;
+    static constexpr size_t percent = Percent;
+};
+
+struct FIFOHashMapStatsPolicyTag {};
+
+/**
+ * @brief Default statistics policy - nothing is counted and the map holds no counters.
+ */
+struct FIFOHashMapNoStats
+{
+    using policy_category = FIFOHashMapStatsPolicyTag;
+    static constexpr bool enabled = false;
+};
+
+/**
+ * @brief Statistics policy - the map counts its lookups, insertions, evictions and so on (see FIFOHashMapStatistics),
+ * available through stats() and reset_stats(). The counters are plain integers of the instance, like the rest of its
+ * state. ConcurrentFIFOHashMap keeps them per shard and SingleWriterFIFOHashMap per reader thread.
+ */
+struct FIFOHashMapStats
+{
+    using policy_category = FIFOHashMapStatsPolicyTag;
+    static constexpr bool enabled = true;
+};
+
+/**
+ * @brief The counters of a map with the FIFOHashMapStats policy, since it was constructed or reset.
+ */
+struct FIFOHashMapStatistics
+{
+    /*Lookups by find, find_batch, contains_batch and operator[], by whether the key was there*/
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    /*Elements inserted, by any insert method or operator[]*/
+    uint64_t m_insertions = 0;
+    /*insert, emplace and try_emplace calls that did nothing because the key was there*/
+    uint64_t m_duplicates = 0;
+    /*Oldest elements removed to make room for new ones, or by a smaller capacity*/
+    uint64_t m_evictions = 0;
+    /*Elements removed by erase*/
+    uint64_t m_erasures = 0;
+    /*moveElementToTail and moveElementToHead calls that found their key*/
+    uint64_t m_movesToTail = 0;
+    uint64_t m_movesToHead = 0;
+    /*Elements removed by pop and drain*/
+    uint64_t m_pops = 0;
+    /*Elements removed because they were older than the time to live, by expire or by a lookup*/
+    uint64_t m_expirations = 0;
+    /*Key lookups in the bucket array, and the bucket groups they read in all - a key in its home group reads 1*/
+    uint64_t m_probes = 0;
+    uint64_t m_probeSteps = 0;
+
+    /**
+     * @return Hits out of all lookups, or 0 if there were none.
+     */
+    double hit_ratio() const
+    {
+        const uint64_t lookups = m_hits + m_misses;
+        return (lookups == 0) ? 0.0 : static_cast<double>(m_hits) / lookups;
+    }
+
+    /**
+     * @return Bucket groups read per key lookup, or 0 if there were none.
+     */
+    double average_probe_length() const
+    {
+        return (m_probes == 0) ? 0.0 : static_cast<double>(m_probeSteps) / m_probes;
+    }
+
+    FIFOHashMapStatistics &operator+=(const FIFOHashMapStatistics &other)
+    {
+        m_hits += other.m_hits;
+        m_misses += other.m_misses;
+        m_insertions += other.m_insertions;
+        m_duplicates += other.m_duplicates;
+        m_evictions += other.m_evictions;
+        m_erasures += other.m_erasures;
+        m_movesToTail += other.m_movesToTail;
+        m_movesToHead += other.m_movesToHead;
+        m_pops += other.m_pops;
+        m_expirations += other.m_expirations;
+        m_probes += other.m_probes;
+        m_probeSteps += other.m_probeSteps;
+        return *this;
+    }
+};
+
+/**
+ * @brief The counters held by a map - none, and every count compiles to nothing, unless statistics are enabled.
+ * A private base of the map, so the disabled counters take no space.
+ */
+template<bool Enabled>
+class FIFOHashMapCounters
+{
+protected:
+    void count(uint64_t FIFOHashMapStatistics::*, uint64_t = 1)
+    {
+    }
+};
+
+template<>
+class FIFOHashMapCounters<true>
+{
+protected:
+    FIFOHashMapStatistics m_stats;
+
+    void count(uint64_t FIFOHashMapStatistics::*counter, uint64_t amount = 1)
+    {
+        m_stats.*counter += amount;
+    }
+};
+
+struct FIFOHashMapExpiryPolicyTag {};
+
+/**
+ * @brief Default expiry policy - elements stay until they are evicted or removed, whatever their age.
+ */
+struct FIFOHashMapNoExpiry
+{
+    using policy_category = FIFOHashMapExpiryPolicyTag;
+    static constexpr bool enabled = false;
+    using clock_type = std::chrono::steady_clock;
+};
+
+/**
+ * @brief Expiry policy - the map stamps every element with the time it was inserted, and an element older than the
+ * time to live (see set_ttl()) is expired: lookups and inserts treat it as missing, and expire() removes the expired
+ * elements from the head.
+ * @tparam Clock - Provides now(), duration and time_point, like the std::chrono clocks. The map holds one (see
+ * clock()), so a clock with state - say, one that tests move forward by hand - works too.
+ */
+template<class Clock = std::chrono::steady_clock>
+struct FIFOHashMapExpiry
+{
+    using policy_category = FIFOHashMapExpiryPolicyTag;
+    static constexpr bool enabled = true;
+    using clock_type = Clock;
+};
+
+/**
+ * @brief The insertion times held by a map, by cell index, with the clock and the time to live - nothing at all
+ * unless expiry is enabled. A private base of the map, like FIFOHashMapCounters.
+ */
+template<class ExpiryPolicy, class Allocator>
+class FIFOHashMapTimestamps
+{
+protected:
+    explicit FIFOHashMapTimestamps(const Allocator &)
+    {
+    }
+};
+
+template<class Clock, class Allocator>
+class FIFOHashMapTimestamps<FIFOHashMapExpiry<Clock>, Allocator>
+{
+protected:
+    using TimePoint = typename Clock::time_point;
+    using TimePointAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<TimePoint>;
+
+    std::vector<TimePoint, TimePointAllocator> m_insertedAt;
+    typename Clock::duration m_ttl = Clock::duration::max();
+    Clock m_clock;
+
+    explicit FIFOHashMapTimestamps(const Allocator &allocator) : m_insertedAt(TimePointAllocator(allocator))
+    {
+    }
+
+    bool isExpired(uint32_t cellIndex, TimePoint now) const
+    {
+        /*A time to live of duration::max() never expires - the difference can not reach it*/
+        return (now > m_insertedAt[cellIndex]) && (now - m_insertedAt[cellIndex] >= m_ttl);
+    }
+};
+
+struct FIFOHashMapAggregatesPolicyTag {};
+
+/**
+ * @brief Default aggregates policy - the map keeps no aggregates of its values.
+ */
+struct FIFOHashMapNoAggregates
+{
+    using policy_category = FIFOHashMapAggregatesPolicyTag;
+};
+
+/**
+ * @brief Aggregates policy - the map keeps the given aggregates of its values up to date as elements are inserted,
+ * assigned by insert_or_assign or operator[], evicted, popped, erased and expired, and aggregate<Aggregate>() returns
+ * one of them.
+ *
+ * An aggregate is a monoid over the values, declared by a class with static members:
+ *  - state_type - the aggregated state, and identity() - the state of no values.
+ *  - lift(value) - the state of a single value.
+ *  - combine(first, second) - the state of two states together.
+ *  - result(state) - optional, what aggregate() returns for a state; the state itself otherwise.
+ * and, for the map to remove values from the state, one of:
+ *  - uncombine(total, removed) - undoes combine (count, sum): every change costs O(1).
+ *  - selects(older, newer) - true if combine(older, newer) is older, for combine returning one of its arguments
+ *    (min, max): the map keeps the values in a heap indexed by cell, so aggregate() costs O(1) and every change
+ *    O(log size()), wherever the element is - only renumbering the elements (set_capacity shrinking the map or
+ *    growing a ring order one) makes the next aggregate() rebuild the heap, in O(size()).
+ * A value written through the reference operator[] returns is seen from the next call on the map. Values changed
+ * through iterators, find() or for_each() are not seen; refresh_aggregates() recomputes everything.
+ */
+template<class... Aggregates>
+struct FIFOHashMapAggregates
+{
+    using policy_category = FIFOHashMapAggregatesPolicyTag;
+};
+
+/**
+ * @brief Aggregate: the number of elements.
+ */
+struct FIFOHashMapCount
+{
+    using state_type = size_t;
+
+    static size_t identity()
+    {
+        return 0;
+    }
+
+    template<class V>
+    static size_t lift(const V&)
+    {
+        return 1;
+    }
+
+    static size_t combine(size_t first, size_t second)
+    {
+        return first + second;
+    }
+
+    static size_t uncombine(size_t total, size_t removed)
+    {
+        return total - removed;
+    }
+};
+
+/**
+ * @brief Aggregate: the sum of the values, as T. Floating point sums drift by rounding as values come and go.
+ */
+template<class T>
+struct FIFOHashMapSum
+{
+    using state_type = T;
+
+    static T identity()
+    {
+        return T();
+    }
+
+    template<class V>
+    static T lift(const V &value)
+    {
+        return static_cast<T>(value);
+    }
+
+    static T combine(const T &first, const T &second)
+    {
+        return first + second;
+    }
+
+    static T uncombine(const T &total, const T &removed)
+    {
+        return total - removed;
+    }
+};
+
+/**
+ * @brief Aggregate: the mean of the values, as a double - NaN for an empty map. The sum is kept as T.
+ */
+template<class T>
+struct FIFOHashMapMean
+{
+    using state_type = std::pair<T, size_t>;
+
+    static state_type identity()
+    {
+        return {T(), 0};
+    }
+
+    template<class V>
+    static state_type lift(const V &value)
+    {
+        return {static_cast<T>(value), 1};
+    }
+
+    static state_type combine(const state_type &first, const state_type &second)
+    {
+        return {first.first + second.first, first.second + second.second};
+    }
+
+    static state_type uncombine(const state_type &total, const state_type &removed)
+    {
+        return {total.first - removed.first, total.second - removed.second};
+    }
+
+    static double result(const state_type &state)
+    {
+        return (state.second == 0) ? std::numeric_limits<double>::quiet_NaN()
+                                   : static_cast<double>(state.first) / static_cast<double>(state.second);
+    }
+};
+
+/**
+ * @brief Aggregate: the smallest value, as T - the largest T (or infinity) for an empty map.
+ */
+template<class T>
+struct FIFOHashMapMin
+{
+    using state_type = T;
+
+    static T identity()
+    {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+
+    template<class V>
+    static T lift(const V &value)
+    {
+        return static_cast<T>(value);
+    }
+
+    static T combine(const T &first, const T &second)
+    {
+        return selects(first, second) ? first : second;
+    }
+
+    static bool selects(const T &older, const T &newer)
+    {
+        /*An equal newer value outlives the older one, so it is the one kept*/
+        return older < newer;
+    }
+};
+
+/**
+ * @brief Aggregate: the largest value, as T - the lowest T (or minus infinity) for an empty map.
+ */
+template<class T>
+struct FIFOHashMapMax
+{
+    using state_type = T;
+
+    static T identity()
+    {
+        return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    }
+
+    template<class V>
+    static T lift(const V &value)
+    {
+        return static_cast<T>(value);
+    }
+
+    static T combine(const T &first, const T &second)
+    {
+        return selects(first, second) ? first : second;
+    }
+
+    static bool selects(const T &older, const T &newer)
+    {
+        return newer < older;
+    }
+};
+
+/**
+ * @brief True for aggregates with uncombine - the others are selective, see FIFOHashMapAggregates.
+ */
+template<class Aggregate, class = void>
+struct FIFOHashMapIsInvertible : std::false_type {};
+
+template<class Aggregate>
+struct FIFOHashMapIsInvertible<Aggregate, std::void_t<decltype(Aggregate::uncombine(
+        std::declval<const typename Aggregate::state_type&>(), std::declval<const typename Aggregate::state_type&>()))>>
+        : std::true_type {};
+
+/**
+ * @brief The state of one aggregate of a map. An invertible aggregate is a single total.
+ */
+template<class Aggregate, class Allocator, bool Invertible = FIFOHashMapIsInvertible<Aggregate>::value>
+class FIFOHashMapAggregateState
+{
+    using State = typename Aggregate::state_type;
+
+    State m_total = Aggregate::identity();
+    bool m_valid = true;
+
+public:
+    explicit FIFOHashMapAggregateState(const Allocator &)
+    {
+    }
+
+    bool valid() const
+    {
+        return m_valid;
+    }
+
+    const State &total() const
+    {
+        return m_total;
+    }
+
+    void reset()
+    {
+        m_total = Aggregate::identity();
+        m_valid = true;
+    }
+
+    void reserve(size_t)
+    {
+    }
+
+    void invalidate()
+    {
+        m_valid = false;
+    }
+
+    void insert(uint32_t, const State &value)
+    {
+        m_total = Aggregate::combine(m_total, value);
+    }
+
+    void erase(uint32_t, const State &value)
+    {
+        m_total = Aggregate::uncombine(m_total, value);
+    }
+
+    void assign(uint32_t, const State &oldValue, const State &newValue)
+    {
+        m_total = Aggregate::combine(Aggregate::uncombine(m_total, oldValue), newValue);
+    }
+};
+
+/**
+ * @brief The state of a selective aggregate: a binary heap of cells and their lifted values, where a value is selected
+ * over the values below it, and the position in the heap of every cell - so the top is the result, and any element
+ * can be removed or changed in O(log n).
+ */
+template<class Aggregate, class Allocator>
+class FIFOHashMapAggregateState<Aggregate, Allocator, false>
+{
+    using State = typename Aggregate::state_type;
+
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    struct Entry
+    {
+        uint32_t m_cell;
+        State m_value;
+    };
+    using EntryAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>;
+    using PositionAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint32_t>;
+
+    std::vector<Entry, EntryAllocator> m_heap;
+    /*By cell index - npos for a cell that is not in the heap*/
+    std::vector<uint32_t, PositionAllocator> m_positions;
+    bool m_valid = true;
+
+    void place(size_t position, Entry &&entry)
+    {
+        m_positions[entry.m_cell] = static_cast<uint32_t>(position);
+        m_heap[position] = std::move(entry);
+    }
+
+    void siftUp(size_t position)
+    {
+        Entry entry = std::move(m_heap[position]);
+        while(position != 0)
+        {
+            const size_t parent = (position - 1) / 2;
+            if(!Aggregate::selects(entry.m_value, m_heap[parent].m_value))
+            {
+                break;
+            }
+            place(position, std::move(m_heap[parent]));
+            position = parent;
+        }
+        place(position, std::move(entry));
+    }
+
+    void siftDown(size_t position)
+    {
+        Entry entry = std::move(m_heap[position]);
+        for(;;)
+        {
+            size_t child = 2 * position + 1;
+            if(child >= m_heap.size())
+            {
+                break;
+            }
+            if((child + 1 < m_heap.size()) && Aggregate::selects(m_heap[child + 1].m_value, m_heap[child].m_value))
+            {
+                child++;
+            }
+            if(!Aggregate::selects(m_heap[child].m_value, entry.m_value))
+            {
+                break;
+            }
+            place(position, std::move(m_heap[child]));
+            position = child;
+        }
+        place(position, std::move(entry));
+    }
+
+    /*After the value at position changed either way*/
+    void fix(size_t position)
+    {
+        if((position != 0) && Aggregate::selects(m_heap[position].m_value, m_heap[(position - 1) / 2].m_value))
+        {
+            siftUp(position);
+        }
+        else
+        {
+            siftDown(position);
+        }
+    }
+
+public:
+    explicit FIFOHashMapAggregateState(const Allocator &allocator) :
+            m_heap(EntryAllocator(allocator)), m_positions(PositionAllocator(allocator))
+    {
+    }
+
+    bool valid() const
+    {
+        return m_valid;
+    }
+
+    State total() const
+    {
+        return m_heap.empty() ? Aggregate::identity() : m_heap.front().m_value;
+    }
+
+    void reset()
+    {
+        for(const Entry &entry : m_heap)
+        {
+            m_positions[entry.m_cell] = npos;
+        }
+        m_heap.clear();
+        m_valid = true;
+    }
+
+    void reserve(size_t capacity)
+    {
+        /*Holds at most one entry per cell, so a heap as large as the map never reallocates*/
+        if(capacity > m_positions.size())
+        {
+            m_positions.resize(capacity, npos);
+            m_heap.reserve(capacity);
+        }
+    }
+
+    void invalidate()
+    {
+        m_valid = false;
+    }
+
+    void insert(uint32_t cellIndex, const State &value)
+    {
+        if(!m_valid)
+        {
+            return;
+        }
+        m_heap.push_back(Entry{cellIndex, value});
+        siftUp(m_heap.size() - 1);
+    }
+
+    void erase(uint32_t cellIndex, const State &)
+    {
+        if(!m_valid)
+        {
+            return;
+        }
+        const size_t position = m_positions[cellIndex];
+        m_positions[cellIndex] = npos;
+        if(position + 1 != m_heap.size())
+        {
+            place(position, std::move(m_heap.back()));
+            m_heap.pop_back();
+            fix(position);
+        }
+        else
+        {
+            m_heap.pop_back();
+        }
+    }
+
+    void assign(uint32_t cellIndex, const State &, const State &newValue)
+    {
+        if(!m_valid)
+        {
+            return;
+        }
+        const size_t position = m_positions[cellIndex];
+        m_heap[position].m_value = newValue;
+        fix(position);
+    }
+};
+
+/**
+ * @brief The aggregates held by a map - nothing at all unless there is a FIFOHashMapAggregates policy.
+ * A private base of the map, like FIFOHashMapCounters. Lifted is the tuple of the states of a single value, taken
+ * before an element is removed, since the eviction sinks and pop may move the value out first.
+ */
+template<class AggregatesPolicy, class V, class Allocator>
+class FIFOHashMapAggregateSet
+{
+protected:
+    struct Lifted {};
+
+    explicit FIFOHashMapAggregateSet(const Allocator &)
+    {
+    }
+
+    static Lifted liftAggregates(const V&)
+    {
+        return {};
+    }
+
+    void reserveAggregates(size_t)
+    {
+    }
+
+    void invalidateAggregates()
+    {
+    }
+
+    void settleAggregates()
+    {
+    }
+
+    void insertAggregated(uint32_t, const V&)
+    {
+    }
+
+    void eraseAggregated(uint32_t, const Lifted&)
+    {
+    }
+
+    void assignAggregated(uint32_t, const Lifted&, const V&)
+    {
+    }
+
+    void detachAggregated(uint32_t, const V&)
+    {
+    }
+};
+
+template<class... Aggregates, class V, class Allocator>
+class FIFOHashMapAggregateSet<FIFOHashMapAggregates<Aggregates...>, V, Allocator>
+{
+protected:
+    using Lifted = std::tuple<typename Aggregates::state_type...>;
+
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    std::tuple<FIFOHashMapAggregateState<Aggregates, Allocator>...> m_aggregates;
+    /*The element operator[] returned last, which is out of the aggregates until the next change - it may be written
+     *through the reference until then*/
+    uint32_t m_detachedCell = npos;
+    const V *m_detachedValue = nullptr;
+
+    explicit FIFOHashMapAggregateSet(const Allocator &allocator) :
+            m_aggregates(FIFOHashMapAggregateState<Aggregates, Allocator>(allocator)...)
+    {
+    }
+
+    static Lifted liftAggregates(const V &value)
+    {
+        return Lifted(Aggregates::lift(value)...);
+    }
+
+    template<class Aggregate>
+    FIFOHashMapAggregateState<Aggregate, Allocator> &aggregateState()
+    {
+        return std::get<FIFOHashMapAggregateState<Aggregate, Allocator>>(m_aggregates);
+    }
+
+    template<class Function>
+    void forEachAggregate(Function &&function)
+    {
+        std::apply([&function](auto &... states) { (function(states), ...); }, m_aggregates);
+    }
+
+    void reserveAggregates(size_t capacity)
+    {
+        forEachAggregate([capacity](auto &state) { state.reserve(capacity); });
+    }
+
+    void invalidateAggregates()
+    {
+        m_detachedCell = npos;
+        forEachAggregate([](auto &state) { state.invalidate(); });
+    }
+
+    /**
+     * @brief Puts the element operator[] detached back, with the value it was given.
+     */
+    void settleAggregates()
+    {
+        if(m_detachedCell != npos)
+        {
+            const uint32_t cellIndex = m_detachedCell;
+            m_detachedCell = npos;
+            (aggregateState<Aggregates>().insert(cellIndex, Aggregates::lift(*m_detachedValue)), ...);
+        }
+    }
+
+    void insertAggregated(uint32_t cellIndex, const V &value)
+    {
+        settleAggregates();
+        (aggregateState<Aggregates>().insert(cellIndex, Aggregates::lift(value)), ...);
+    }
+
+    void eraseAggregated(uint32_t cellIndex, const Lifted &lifted)
+    {
+        if(cellIndex == m_detachedCell)
+        {
+            /*Already out*/
+            m_detachedCell = npos;
+            return;
+        }
+        settleAggregates();
+        std::apply([this, cellIndex](const auto &... values)
+                   {
+                       (aggregateState<Aggregates>().erase(cellIndex, values), ...);
+                   }, lifted);
+    }
+
+    void assignAggregated(uint32_t cellIndex, const Lifted &lifted, const V &value)
+    {
+        if(cellIndex == m_detachedCell)
+        {
+            m_detachedCell = npos;
+            (aggregateState<Aggregates>().insert(cellIndex, Aggregates::lift(value)), ...);
+            return;
+        }
+        settleAggregates();
+        std::apply([this, cellIndex, &value](const auto &... oldValues)
+                   {
+                       (aggregateState<Aggregates>().assign(cellIndex, oldValues, Aggregates::lift(value)), ...);
+                   }, lifted);
+    }
+
+    /**
+     * @brief Takes the element out of the aggregates until the next change, for operator[] - which returns a reference
+     * to value, so the aggregates can not see what it is set to before then.
+     */
+    void detachAggregated(uint32_t cellIndex, const V &value)
+    {
+        if(cellIndex != m_detachedCell)
+        {
+            settleAggregates();
+            eraseAggregated(cellIndex, liftAggregates(value));
+            m_detachedCell = cellIndex;
+            m_detachedValue = &value;
+        }
+    }
+};
+
+/**
+ * @return What aggregate() returns for state - Aggregate::result(state) if there is one, state otherwise.
+ */
+template<class Aggregate, class State>
+auto FIFOHashMapAggregateResult(const State &state, int) -> decltype(Aggregate::result(state))
+{
+    return Aggregate::result(state);
+}
+
+template<class Aggregate, class State>
+State FIFOHashMapAggregateResult(const State &state, long)
+{
+    return state;
+}
+
+/**
+ * @brief Selects the policy of the given category from Policies, or Default if there is none.
+ */
+template<class Category, class Default, class... Policies>
+struct FIFOHashMapSelectPolicy
+{
+    using type = Default;
+};
+
+template<class Category, class Default, class First, class... Rest>
+struct FIFOHashMapSelectPolicy<Category, Default, First, Rest...>
+{
+    using type = typename std::conditional<std::is_same<typename First::policy_category, Category>::value,
+                                           First,
+                                           typename FIFOHashMapSelectPolicy<Category, Default, Rest...>::type>::type;
+};
+
+/**
+ * @brief True for std::pair types whose first member is a Key - emplace can find the key without building the pair.
+ */
+template<class T, class Key>
+struct FIFOHashMapIsKeyedPair : std::false_type {};
+
+template<class First, class Second, class Key>
+struct FIFOHashMapIsKeyedPair<std::pair<First, Second>, Key> : std::is_same<typename std::decay<First>::type, Key> {};
+
+/**
+ * @brief Assigns the arguments of an insertion to an existing element, instead of constructing it from them - for the
+ * forms the inserts pass: (key, value), a pair, and piecewise tuples of a key and zero or one value.
+ * Each assign overload is only there if the key and the value can be assigned from those arguments.
+ */
+template<class K, class V>
+struct FIFOHashMapRecycler
+{
+    /*The element with its key still mutable, see FIFOHashMapCell*/
+    using value_type = std::pair<K, V>;
+
+    template<class KeyArg, class ValueArg>
+    static auto assign(value_type &element, KeyArg &&key, ValueArg &&value)
+            -> decltype(std::declval<K&>() = std::forward<KeyArg>(key), std::declval<V&>() = std::forward<ValueArg>(value), void())
+    {
+        element.first = std::forward<KeyArg>(key);
+        element.second = std::forward<ValueArg>(value);
+    }
+
+    template<class First, class Second>
+    static auto assign(value_type &element, const std::pair<First, Second> &pair)
+            -> decltype(std::declval<K&>() = pair.first, std::declval<V&>() = pair.second, void())
+    {
+        element.first = pair.first;
+        element.second = pair.second;
+    }
+
+    template<class First, class Second>
+    static auto assign(value_type &element, std::pair<First, Second> &&pair)
+            -> decltype(std::declval<K&>() = std::move(pair.first), std::declval<V&>() = std::move(pair.second), void())
+    {
+        element.first = std::move(pair.first);
+        element.second = std::move(pair.second);
+    }
+
+    template<class KeyArg>
+    static auto assign(value_type &element, std::piecewise_construct_t, std::tuple<KeyArg> key, std::tuple<>)
+            -> decltype(std::declval<K&>() = std::forward<KeyArg>(std::get<0>(key)), std::declval<V&>() = V(), void())
+    {
+        element.first = std::forward<KeyArg>(std::get<0>(key));
+        element.second = V();
+    }
+
+    template<class KeyArg, class ValueArg>
+    static auto assign(value_type &element, std::piecewise_construct_t, std::tuple<KeyArg> key, std::tuple<ValueArg> value)
+            -> decltype(std::declval<K&>() = std::forward<KeyArg>(std::get<0>(key)),
+                        std::declval<V&>() = std::forward<ValueArg>(std::get<0>(value)), void())
+    {
+        element.first = std::forward<KeyArg>(std::get<0>(key));
+        element.second = std::forward<ValueArg>(std::get<0>(value));
+    }
+};
+
+/**
+ * @brief True if FIFOHashMapRecycler<K, V> can assign Args (a std::tuple of the argument types) to an element.
+ */
+template<class Recycler, class Args, class = void>
+struct FIFOHashMapCanRecycle : std::false_type {};
+
+template<class Recycler, class... Args>
+struct FIFOHashMapCanRecycle<Recycler, std::tuple<Args...>,
+        std::void_t<decltype(Recycler::assign(std::declval<typename Recycler::value_type&>(), std::declval<Args>()...))>>
+        : std::true_type {};
+
+/**
+ * @brief True for types with an iterator category - tells insert(first, last) apart from the other two argument inserts.
+ */
+template<class T, class = void>
+struct FIFOHashMapIsIterator : std::false_type {};
+
+template<class T>
+struct FIFOHashMapIsIterator<T, std::void_t<typename std::iterator_traits<T>::iterator_category>> : std::true_type {};
+
+/**
+ * @brief Starts loading the cache line of address, without waiting for it. A no-op where there is no intrinsic.
+ */
+inline void FIFOHashMapPrefetch(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+/**
+ * @return The index of the lowest set bit of mask, which is not 0.
+ */
+inline uint32_t FIFOHashMapLowestBit(uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<uint32_t>(index);
+#else
+    uint32_t index = 0;
+    while((mask & 1) == 0)
+    {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/********************************************************************************/
+/*FIFOHashMapCapacity*/
+/********************************************************************************/
+
+/**
+ * @brief Pass as N to set the capacity at run time, see FIFOHashMap(size_t capacity) and set_capacity().
+ */
+constexpr size_t FIFOHashMapDynamicCapacity = 0;
+
+/**
+ * @brief An open-addressing bucket. m_cell is UINT32_MAX for an empty bucket.
+ */
+struct FIFOHashMapBucket {
+    uint32_t m_hash = 0;
+    uint32_t m_cell = UINT32_MAX;
+};
+
+/**
+ * @brief Number of buckets for a capacity.
+ * Buckets are kept at most half full - linear probing degrades quickly above that.
+ */
+constexpr size_t FIFOHashMapBucketCount(size_t capacity)
+{
+    size_t count = 1;
+    while(count < 2 * capacity)
+    {
+        count <<= 1;
+    }
+    return count;
+}
+
+/**
+ * @brief WIDTH buckets and a control byte for each of them, in one cache line.
+ * A control byte is EMPTY, or 7 bits of the hash in the bucket. A lookup compares all the control bytes of a group
+ * with the tag of its key at once, with SSE2 or a 64-bit word elsewhere, and only reads the buckets that match.
+ */
+struct alignas(64) FIFOHashMapBucketGroup {
+    static constexpr size_t WIDTH = 7;
+    static constexpr uint8_t EMPTY = 0x80;
+    /*Bit i for bucket i - the last control byte is padding and always EMPTY*/
+    static constexpr uint32_t ALL = (1u << WIDTH) - 1;
+
+    uint8_t m_control[WIDTH + 1];
+    FIFOHashMapBucket m_buckets[WIDTH];
+
+    FIFOHashMapBucketGroup()
+    {
+        std::fill(m_control, m_control + WIDTH + 1, EMPTY);
+    }
+
+    /**
+     * @return The control byte of a hash - its top 7 bits, since the low bits pick the group.
+     */
+    static uint8_t tag(uint32_t hash)
+    {
+        return static_cast<uint8_t>(hash >> 25);
+    }
+
+    /**
+     * @return Bit i is set if control byte i is tag.
+     */
+    uint32_t match(uint8_t tag) const
+    {
+#ifdef FIFOHashMap_SSE2_GROUPS
+        const __m128i control = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(m_control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(tag))))) & ALL;
+#else
+        /*The bytes that equal tag are the zero bytes of word ^ tag - their top bit is set, and only theirs*/
+        const uint64_t bytes = word() ^ (0x0101010101010101ULL * tag);
+        return gather(~(((bytes & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | bytes) & 0x8080808080808080ULL) & ALL;
+#endif
+    }
+
+    /**
+     * @return Bit i is set if bucket i is empty.
+     */
+    uint32_t matchEmpty() const
+    {
+        /*EMPTY is the only control byte with the top bit set*/
+#ifdef FIFOHashMap_SSE2_GROUPS
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(m_control)))) & ALL;
+#else
+        return gather(word() & 0x8080808080808080ULL) & ALL;
+#endif
+    }
+
+#ifndef FIFOHashMap_SSE2_GROUPS
+private:
+    /**
+     * @return The control bytes as a word, control byte i in byte i from the bottom whatever the byte order.
+     */
+    uint64_t word() const
+    {
+        uint64_t word;
+        std::memcpy(&word, m_control, sizeof(word));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    /**
+     * @return Bit i set for every byte i of bytes that has its top bit set - all the other bits of bytes are 0.
+     */
+    static uint32_t gather(uint64_t bytes)
+    {
+        return static_cast<uint32_t>(((bytes >> 7) * 0x0102040810204080ULL) >> 56);
+    }
+#endif
+};
+
+/**
+ * @brief Number of bucket groups for a capacity and a FIFOHashMapMaxLoad percent - a power of two.
+ */
+constexpr size_t FIFOHashMapGroupCount(size_t capacity, size_t maxLoadPercent)
+{
+    size_t count = 1;
+    while(count * FIFOHashMapBucketGroup::WIDTH * maxLoadPercent < capacity * 100)
+    {
+        count <<= 1;
+    }
+    return count;
+}
+
+/**
+ * @brief The bucket array of a FIFOHashMap. A bucket is addressed by its group and its position in the group,
+ * as group * 8 + position. Buckets are only written through set, setCell and clear, which keep the control bytes in step.
+ */
+template<class Allocator>
+class FIFOHashMapBuckets
+{
+    using Group = FIFOHashMapBucketGroup;
+    using GroupAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Group>;
+
+    std::vector<Group, GroupAllocator> m_groups;
+
+public:
+    using allocator_type = GroupAllocator;
+
+    static constexpr size_t POSITION_BITS = 3;
+
+    FIFOHashMapBuckets() = default;
+
+    /**
+     * @brief No groups, allocated with allocator later.
+     */
+    explicit FIFOHashMapBuckets(const GroupAllocator &allocator) : m_groups(allocator)
+    {
+    }
+
+    /**
+     * @param groupCount - Number of groups, a power of two. All the buckets are empty.
+     */
+    FIFOHashMapBuckets(size_t groupCount, const GroupAllocator &allocator) : m_groups(groupCount, allocator)
+    {
+    }
+
+    GroupAllocator get_allocator() const
+    {
+        return m_groups.get_allocator();
+    }
+
+    static size_t index(size_t groupIndex, uint32_t position)
+    {
+        return (groupIndex << POSITION_BITS) | position;
+    }
+
+    static size_t groupOf(size_t index)
+    {
+        return index >> POSITION_BITS;
+    }
+
+    size_t groupCount() const
+    {
+        return m_groups.size();
+    }
+
+    /**
+     * @return Bytes allocated for the groups.
+     */
+    size_t memory_usage() const
+    {
+        return m_groups.capacity() * sizeof(Group);
+    }
+
+    const FIFOHashMapBucket &operator[](size_t index) const
+    {
+        return m_groups[index >> POSITION_BITS].m_buckets[index & ((1u << POSITION_BITS) - 1)];
+    }
+
+    const Group &group(size_t groupIndex) const
+    {
+        return m_groups[groupIndex];
+    }
+
+    void set(size_t index, FIFOHashMapBucket bucket)
+    {
+        Group &group = m_groups[index >> POSITION_BITS];
+        group.m_control[index & ((1u << POSITION_BITS) - 1)] = Group::tag(bucket.m_hash);
+        group.m_buckets[index & ((1u << POSITION_BITS) - 1)] = bucket;
+    }
+
+    void setCell(size_t index, uint32_t cell)
+    {
+        m_groups[index >> POSITION_BITS].m_buckets[index & ((1u << POSITION_BITS) - 1)].m_cell = cell;
+    }
+
+    void clear(size_t index)
+    {
+        Group &group = m_groups[index >> POSITION_BITS];
+        group.m_control[index & ((1u << POSITION_BITS) - 1)] = Group::EMPTY;
+        group.m_buckets[index & ((1u << POSITION_BITS) - 1)].m_cell = UINT32_MAX;
+    }
+
+    void prefetch(size_t groupIndex) const
+    {
+        FIFOHashMapPrefetch(&m_groups[groupIndex]);
+    }
+
+    void swap(FIFOHashMapBuckets &other)
+    {
+        m_groups.swap(other.m_groups);
+    }
+};
+
+/**
+ * @brief Mixes a hash before its low bits pick a bucket - std::hash is the identity for integers on common implementations.
+ */
+inline uint32_t FIFOHashMapMixHash(size_t hash)
+{
+    uint64_t mixed = static_cast<uint64_t>(hash);
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdULL;
+    mixed ^= mixed >> 33;
+    return static_cast<uint32_t>(mixed);
+}
+
+/**
+ * @brief Capacity of a map with a compile time N - everything is a constant and there is no state.
+ */
+template<size_t N, class Buckets, class MaxLoad>
+class FIFOHashMapCapacity
+{
+public:
+    explicit FIFOHashMapCapacity(const typename Buckets::allocator_type &)
+    {
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    static constexpr size_t bucket_count()
+    {
+        return FIFOHashMapGroupCount(N, MaxLoad::percent) * FIFOHashMapBucketGroup::WIDTH;
+    }
+
+protected:
+    static constexpr size_t groupMask()
+    {
+        return FIFOHashMapGroupCount(N, MaxLoad::percent) - 1;
+    }
+};
+
+/**
+ * @brief Capacity of a runtime-capacity map, and the bucket array it is migrating from after growing.
+ */
+template<class Buckets, class MaxLoad>
+class FIFOHashMapCapacity<FIFOHashMapDynamicCapacity, Buckets, MaxLoad>
+{
+public:
+    explicit FIFOHashMapCapacity(const typename Buckets::allocator_type &allocator) : m_oldBuckets(allocator)
+    {
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    size_t bucket_count() const
+    {
+        return (m_groupMask + 1) * FIFOHashMapBucketGroup::WIDTH;
+    }
+
+protected:
+    size_t groupMask() const
+    {
+        return m_groupMask;
+    }
+
+    bool isMigrating() const
+    {
+        return (m_migrateRemaining != 0);
+    }
+
+    size_t m_capacity = 0;
+    size_t m_groupMask = 0;
+    /*The previous bucket array. Every group before m_migrateCursor has been moved to the current one*/
+    Buckets m_oldBuckets;
+    size_t m_migrateCursor = 0;
+    size_t m_migrateRemaining = 0;
+};
+
+/********************************************************************************/
+/*String keys*/
+/********************************************************************************/
+
+/**
+ * @brief Transparent hash of strings: a std::string, a std::string_view, a const char* or a FIFOHashMapInlineString
+ * with the same characters hash the same. With std::equal_to<> as KeyEqual, find, erase and the moves of a map with
+ * string keys take any of them, without building a key for the lookup (see FIFOHashMapStringKeys).
+ */
+struct FIFOHashMapStringHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const noexcept
+    {
+        return std::hash<std::string_view>{}(text);
+    }
+};
+
+/**
+ * @brief True if Hash and KeyEqual are both transparent - the map then looks up keys of other types than K.
+ */
+template<class Hash, class KeyEqual, class = void>
+struct FIFOHashMapIsTransparent : std::false_type {};
+
+template<class Hash, class KeyEqual>
+struct FIFOHashMapIsTransparent<Hash, KeyEqual, std::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>>
+        : std::true_type {};
+
+/**
+ * @brief True if the map looks up KeyLike keys as they are: Hash and KeyEqual are transparent, and KeyLike is neither K
+ * nor an iterator - for erase.
+ */
+template<class KeyLike, class K, class Hash, class KeyEqual>
+struct FIFOHashMapIsHeterogeneousKey : std::integral_constant<bool, FIFOHashMapIsTransparent<Hash, KeyEqual>::value &&
+        !std::is_same<KeyLike, K>::value && !(std::is_class<KeyLike>::value && FIFOHashMapIsIterator<KeyLike>::value)> {};
+
+/**
+ * @brief A string key that keeps up to Size - 1 characters inside itself, and longer ones on the heap.
+ * In a FIFOHashMap the key is stored in the cell, next to its cached hash, so a short key is compared without reading
+ * any other memory: two short keys are equal if their inline bytes, zero padded, are - a fixed size comparison.
+ * Size is also sizeof: 32 holds keys of up to 31 characters, where std::string keeps 15 (libstdc++) or 22 (libc++).
+ * Converts from and to std::string_view, and compares with anything that converts to it.
+ */
+template<size_t Size = 32>
+class FIFOHashMapInlineString
+{
+    static_assert((Size >= 24) && (Size <= 128), "FIFOHashMapInlineString holds from 24 to 128 bytes");
+
+    static constexpr size_t INLINE_CAPACITY = Size - 1;
+    static constexpr uint8_t ON_HEAP = 0xFF;
+
+    struct Heap
+    {
+        char *m_data;
+        size_t m_size;
+    };
+
+    /*The characters of a short string, zero padded - or the Heap of a long one*/
+    char m_chars[INLINE_CAPACITY];
+    /*The length of a short string, or ON_HEAP*/
+    uint8_t m_tag;
+
+    Heap heap() const
+    {
+        Heap heap;
+        std::memcpy(&heap, m_chars, sizeof(heap));
+        return heap;
+    }
+
+    void init(std::string_view text)
+    {
+        std::memset(m_chars, 0, INLINE_CAPACITY);
+        if(text.size() <= INLINE_CAPACITY)
+        {
+            std::memcpy(m_chars, text.data(), text.size());
+            m_tag = static_cast<uint8_t>(text.size());
+        }
+        else
+        {
+            Heap heap{new char[text.size()], text.size()};
+            std::memcpy(heap.m_data, text.data(), text.size());
+            std::memcpy(m_chars, &heap, sizeof(heap));
+            m_tag = ON_HEAP;
+        }
+    }
+
+    void release()
+    {
+        if(m_tag == ON_HEAP)
+        {
+            delete[] heap().m_data;
+        }
+    }
+
+    void adopt(FIFOHashMapInlineString &other)
+    {
+        /*A long string moves its pointer - other is left empty*/
+        std::memcpy(m_chars, other.m_chars, INLINE_CAPACITY);
+        m_tag = other.m_tag;
+        std::memset(other.m_chars, 0, INLINE_CAPACITY);
+        other.m_tag = 0;
+    }
+
+public:
+    FIFOHashMapInlineString() : m_chars{}, m_tag{0}
+    {
+    }
+
+    FIFOHashMapInlineString(std::string_view text)
+    {
+        init(text);
+    }
+
+    FIFOHashMapInlineString(const char *text)
+    {
+        init(text);
+    }
+
+    FIFOHashMapInlineString(const std::string &text)
+    {
+        init(text);
+    }
+
+    FIFOHashMapInlineString(const FIFOHashMapInlineString &other)
+    {
+        init(other.view());
+    }
+
+    FIFOHashMapInlineString(FIFOHashMapInlineString &&other) noexcept
+    {
+        adopt(other);
+    }
+
+    FIFOHashMapInlineString &operator=(const FIFOHashMapInlineString &other)
+    {
+        if(this != &other)
+        {
+            FIFOHashMapInlineString copy(other);
+            release();
+            adopt(copy);
+        }
+        return *this;
+    }
+
+    FIFOHashMapInlineString &operator=(FIFOHashMapInlineString &&other) noexcept
+    {
+        if(this != &other)
+        {
+            release();
+            adopt(other);
+        }
+        return *this;
+    }
+
+    ~FIFOHashMapInlineString()
+    {
+        release();
+    }
+
+    const char *data() const
+    {
+        return (m_tag == ON_HEAP) ? heap().m_data : m_chars;
+    }
+
+    size_t size() const
+    {
+        return (m_tag == ON_HEAP) ? heap().m_size : m_tag;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @return Whether the characters are inside the key, rather than on the heap.
+     */
+    bool is_inline() const
+    {
+        return m_tag != ON_HEAP;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(data(), size());
+    }
+
+    operator std::string_view() const
+    {
+        return view();
+    }
+
+    friend bool operator==(const FIFOHashMapInlineString &first, const FIFOHashMapInlineString &second)
+    {
+        if(first.m_tag != second.m_tag)
+        {
+            return false;
+        }
+        if(first.m_tag != ON_HEAP)
+        {
+            return std::memcmp(first.m_chars, second.m_chars, INLINE_CAPACITY) == 0;
+        }
+        return first.view() == second.view();
+    }
+
+    friend bool operator!=(const FIFOHashMapInlineString &first, const FIFOHashMapInlineString &second)
+    {
+        return !(first == second);
+    }
+
+    template<class Text, typename std::enable_if<std::is_convertible<const Text&, std::string_view>::value &&
+                                                 !std::is_same<Text, FIFOHashMapInlineString>::value, int>::type = 0>
+    friend bool operator==(const FIFOHashMapInlineString &first, const Text &second)
+    {
+        return first.view() == std::string_view(second);
+    }
+
+    template<class Text, typename std::enable_if<std::is_convertible<const Text&, std::string_view>::value &&
+                                                 !std::is_same<Text, FIFOHashMapInlineString>::value, int>::type = 0>
+    friend bool operator==(const Text &first, const FIFOHashMapInlineString &second)
+    {
+        return std::string_view(first) == second.view();
+    }
+
+    template<class Text, typename std::enable_if<std::is_convertible<const Text&, std::string_view>::value &&
+                                                 !std::is_same<Text, FIFOHashMapInlineString>::value, int>::type = 0>
+    friend bool operator!=(const FIFOHashMapInlineString &first, const Text &second)
+    {
+        return !(first == second);
+    }
+
+    template<class Text, typename std::enable_if<std::is_convertible<const Text&, std::string_view>::value &&
+                                                 !std::is_same<Text, FIFOHashMapInlineString>::value, int>::type = 0>
+    friend bool operator!=(const Text &first, const FIFOHashMapInlineString &second)
+    {
+        return !(first == second);
+    }
+};
+
+namespace std
+{
+/**
+ * @brief Hashes like the std::string_view of the characters, as FIFOHashMapStringHash does.
+ */
+template<size_t Size>
+struct hash<FIFOHashMapInlineString<Size>>
+{
+    size_t operator()(const FIFOHashMapInlineString<Size> &text) const noexcept
+    {
+        return std::hash<std::string_view>{}(text.view());
+    }
+};
+}
+
+/********************************************************************************/
+/*Snapshots*/
+/********************************************************************************/
+
+/**
+ * @brief Buffered writer of a snapshot file, see FIFOHashMap::save().
+ */
+class FIFOHashMapSnapshotWriter
+{
+    static constexpr size_t BUFFER_SIZE = size_t(1) << 20;
+
+    std::FILE *m_file;
+    std::vector<char> m_buffer;
+    size_t m_used = 0;
+
+public:
+    explicit FIFOHashMapSnapshotWriter(const std::string &path) : m_file(std::fopen(path.c_str(), "wb")),
+                                                                  m_buffer(BUFFER_SIZE)
+    {
+        if(m_file == nullptr)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: can not create " + path);
+        }
+    }
+
+    FIFOHashMapSnapshotWriter(const FIFOHashMapSnapshotWriter&) = delete;
+    FIFOHashMapSnapshotWriter &operator=(const FIFOHashMapSnapshotWriter&) = delete;
+
+    ~FIFOHashMapSnapshotWriter()
+    {
+        if(m_file != nullptr)
+        {
+            std::fclose(m_file);
+        }
+    }
+
+    void write(const void *data, size_t size)
+    {
+        if(m_used + size > m_buffer.size())
+        {
+            flush();
+            if(size > m_buffer.size())
+            {
+                writeFile(data, size);
+                return;
+            }
+        }
+        std::memcpy(m_buffer.data() + m_used, data, size);
+        m_used += size;
+    }
+
+    /**
+     * @brief Writes out the buffer and closes the file. Throws std::runtime_error if any write failed.
+     */
+    void close()
+    {
+        flush();
+        const int result = std::fclose(m_file);
+        m_file = nullptr;
+        if(result != 0)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: write failed");
+        }
+    }
+
+private:
+    void flush()
+    {
+        writeFile(m_buffer.data(), m_used);
+        m_used = 0;
+    }
+
+    void writeFile(const void *data, size_t size)
+    {
+        if(std::fwrite(data, 1, size, m_file) != size)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: write failed");
+        }
+    }
+};
+
+/**
+ * @brief Reader of a snapshot file, see FIFOHashMap::load(). The file is memory mapped (read into a buffer where
+ * there is no mmap) and read sequentially, with no copy but into the elements.
+ */
+class FIFOHashMapSnapshotReader
+{
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_position = 0;
+#ifdef FIFOHashMap_MMAP_SNAPSHOTS
+    void *m_mapping = nullptr;
+#else
+    std::vector<char> m_buffer;
+#endif
+
+public:
+    explicit FIFOHashMapSnapshotReader(const std::string &path)
+    {
+#ifdef FIFOHashMap_MMAP_SNAPSHOTS
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: can not open " + path);
+        }
+        struct stat status{};
+        if(::fstat(fd, &status) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("FIFOHashMap snapshot: can not read " + path);
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        if(m_size != 0)
+        {
+            m_mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if(m_mapping == MAP_FAILED)
+        {
+            m_mapping = nullptr;
+            throw std::runtime_error("FIFOHashMap snapshot: can not map " + path);
+        }
+        if(m_mapping != nullptr)
+        {
+            /*Read once, front to back - let the kernel read ahead and drop the pages behind*/
+            ::madvise(m_mapping, m_size, MADV_SEQUENTIAL);
+        }
+        m_data = static_cast<const char*>(m_mapping);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: can not open " + path);
+        }
+        m_buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if(!file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size())))
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: can not read " + path);
+        }
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+    }
+
+    FIFOHashMapSnapshotReader(const FIFOHashMapSnapshotReader&) = delete;
+    FIFOHashMapSnapshotReader &operator=(const FIFOHashMapSnapshotReader&) = delete;
+
+    ~FIFOHashMapSnapshotReader()
+    {
+#ifdef FIFOHashMap_MMAP_SNAPSHOTS
+        if(m_mapping != nullptr)
+        {
+            ::munmap(m_mapping, m_size);
+        }
+#endif
+    }
+
+    /**
+     * @return The next size bytes of the file. Throws std::runtime_error if it ends before.
+     */
+    const char *take(size_t size)
+    {
+        if(size > m_size - m_position)
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: the file is truncated");
+        }
+        const char *data = m_data + m_position;
+        m_position += size;
+        return data;
+    }
+
+    void read(void *data, size_t size)
+    {
+        std::memcpy(data, take(size), size);
+    }
+
+    size_t remaining() const
+    {
+        return m_size - m_position;
+    }
+};
+
+/**
+ * @brief How save() and load() write and read a key or a value. Trivially copyable types are copied as they are,
+ * and strings of them as their length and characters. Specialize it for other types:
+ *   static void write(FIFOHashMapSnapshotWriter &writer, const T &value);
+ *   static T read(FIFOHashMapSnapshotReader &reader);
+ */
+template<class T, class = void>
+struct FIFOHashMapSerializer;
+
+template<class T>
+struct FIFOHashMapSerializer<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+    static void write(FIFOHashMapSnapshotWriter &writer, const T &value)
+    {
+        writer.write(&value, sizeof(T));
+    }
+
+    static T read(FIFOHashMapSnapshotReader &reader)
+    {
+        T value;
+        reader.read(&value, sizeof(T));
+        return value;
+    }
+};
+
+template<class Char, class Traits, class Alloc>
+struct FIFOHashMapSerializer<std::basic_string<Char, Traits, Alloc>,
+        typename std::enable_if<std::is_trivially_copyable<Char>::value>::type>
+{
+    static void write(FIFOHashMapSnapshotWriter &writer, const std::basic_string<Char, Traits, Alloc> &value)
+    {
+        const uint64_t length = value.size();
+        writer.write(&length, sizeof(length));
+        writer.write(value.data(), length * sizeof(Char));
+    }
+
+    static std::basic_string<Char, Traits, Alloc> read(FIFOHashMapSnapshotReader &reader)
+    {
+        uint64_t length;
+        reader.read(&length, sizeof(length));
+        if(length > reader.remaining() / sizeof(Char))
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: the file is truncated");
+        }
+        const Char *data = reinterpret_cast<const Char*>(reader.take(length * sizeof(Char)));
+        return std::basic_string<Char, Traits, Alloc>(data, data + length);
+    }
+};
+
+template<size_t Size>
+struct FIFOHashMapSerializer<FIFOHashMapInlineString<Size>>
+{
+    static void write(FIFOHashMapSnapshotWriter &writer, const FIFOHashMapInlineString<Size> &value)
+    {
+        /*The same layout as a std::string*/
+        const uint64_t length = value.size();
+        writer.write(&length, sizeof(length));
+        writer.write(value.data(), length);
+    }
+
+    static FIFOHashMapInlineString<Size> read(FIFOHashMapSnapshotReader &reader)
+    {
+        uint64_t length;
+        reader.read(&length, sizeof(length));
+        if(length > reader.remaining())
+        {
+            throw std::runtime_error("FIFOHashMap snapshot: the file is truncated");
+        }
+        return FIFOHashMapInlineString<Size>(std::string_view(reader.take(length), length));
+    }
+};
+
+/**
+ * @brief The header of a snapshot file, followed by the elements from the oldest: key, then value.
+ * Snapshots are in the byte order and type layout of the machine that saved them - they are meant for restarts
+ * of the same build, not for exchange.
+ */
+struct FIFOHashMapSnapshotHeader
+{
+    static constexpr char MAGIC[8] = {'F', 'I', 'F', 'O', 'H', 'M', 'A', 'P'};
+    static constexpr uint32_t VERSION = 1;
+
+    char m_magic[8];
+    uint32_t m_version;
+    /*sizeof the key and value types - a snapshot is only loaded into a map of the same types*/
+    uint32_t m_keySize;
+    uint32_t m_valueSize;
+    uint32_t m_reserved;
+    uint64_t m_count;
+};
+
+/********************************************************************************/
+/*Pool memory resource*/
+/********************************************************************************/
+
+#if defined(FIFOHashMap_PMR)
+/**
+ * @brief A memory resource with a fixed number of fixed size blocks, allocated from upstream all at once, when it is
+ * constructed. Allocations that fit in a block take one from a free list, and give it back when they are freed.
+ * Allocations that are larger, or find no free block, go to upstream.
+ * Sized from the capacity of a map, it holds the memory of all its elements, so the map allocates nothing once it is
+ * full: every insertion reuses the blocks of the element it evicts. Not thread safe, like the map.
+ */
+class FIFOHashMapPoolResource : public std::pmr::memory_resource
+{
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+    std::pmr::memory_resource *m_upstream;
+    size_t m_blockSize;
+    size_t m_blockCount;
+    char *m_blocks;
+    /*Blocks are handed out from m_blocks in order first, then from the list of freed ones*/
+    size_t m_untouched = 0;
+    void *m_freeHead = nullptr;
+    size_t m_inUse = 0;
+    size_t m_upstreamAllocations = 0;
+
+public:
+    /**
+     * @param blockSize - The largest allocation served from the pool, rounded up to the alignment of std::max_align_t.
+     * @param blockCount - Number of blocks.
+     * @param upstream - Allocates the blocks, and whatever does not fit in them.
+     */
+    FIFOHashMapPoolResource(size_t blockSize, size_t blockCount,
+                            std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) :
+            m_upstream(upstream),
+            m_blockSize(std::max((blockSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, ALIGNMENT)),
+            m_blockCount(blockCount),
+            m_blocks(static_cast<char*>(upstream->allocate(m_blockSize * blockCount, ALIGNMENT)))
+    {
+    }
+
+    FIFOHashMapPoolResource(const FIFOHashMapPoolResource &other) = delete;
+    FIFOHashMapPoolResource& operator=(const FIFOHashMapPoolResource &other) = delete;
+
+    ~FIFOHashMapPoolResource() override
+    {
+        m_upstream->deallocate(m_blocks, m_blockSize * m_blockCount, ALIGNMENT);
+    }
+
+    size_t block_size() const
+    {
+        return m_blockSize;
+    }
+
+    size_t block_count() const
+    {
+        return m_blockCount;
+    }
+
+    /**
+     * @return Number of blocks allocated and not freed yet.
+     */
+    size_t blocks_in_use() const
+    {
+        return m_inUse;
+    }
+
+    /**
+     * @return Number of allocations passed to upstream since construction - besides the blocks.
+     */
+    size_t upstream_allocations() const
+    {
+        return m_upstreamAllocations;
+    }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if((bytes <= m_blockSize) && (alignment <= ALIGNMENT))
+        {
+            void *block = nullptr;
+            if(m_freeHead != nullptr)
+            {
+                block = m_freeHead;
+                m_freeHead = *static_cast<void**>(block);
+            }
+            else if(m_untouched < m_blockCount)
+            {
+                block = m_blocks + m_blockSize * m_untouched++;
+            }
+            if(block != nullptr)
+            {
+                m_inUse++;
+                return block;
+            }
+        }
+        m_upstreamAllocations++;
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+    {
+        char *block = static_cast<char*>(pointer);
+        if((block >= m_blocks) && (block < m_blocks + m_blockSize * m_blockCount))
+        {
+            *static_cast<void**>(pointer) = m_freeHead;
+            m_freeHead = pointer;
+            m_inUse--;
+            return;
+        }
+        m_upstream->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+#endif
+
+/********************************************************************************/
+/*FIFOHashMapCell*/
+/********************************************************************************/
+
+/**
+ * @brief Indices of the neighbouring cells in the FIFO order (or in the free list while the cell is unused).
+ */
+template<bool Linked>
+struct FIFOHashMapCellLinks
+{
+    uint32_t m_next = UINT32_MAX;
+    uint32_t m_prev = UINT32_MAX;
+};
+
+/**
+ * @brief Ring order cells have no links - the neighbours are the adjacent cells.
+ */
+template<>
+struct FIFOHashMapCellLinks<false>
+{
+};
+
+/**
+ * @brief A single slot of the FIFOHashMap cell array.
+ * The (Key,Value) pair is constructed only while the cell is in use.
+ */
+template<class K, class V, bool Linked = true>
+class FIFOHashMapCell : private FIFOHashMapCellLinks<Linked>
+{
+    template <class KK, class VV, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+    friend class FIFOHashMap;
+
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+private:
+    /*The pair is constructed with a mutable key, so the map may move the key out or assign a new one to a live
+     *element; the elements are only handed out with a const key, through keyValPair()*/
+    union
+    {
+        std::pair<K, V> m_mutableKeyValPair;
+        std::pair<const K, V> m_keyValPair;
+    };
+    /*Mixed hash of the key, so evicting or erasing the cell never hashes the key again*/
+    uint32_t m_hash = 0;
+
+    static_assert(sizeof(std::pair<K, V>) == sizeof(std::pair<const K, V>) &&
+                  alignof(std::pair<K, V>) == alignof(std::pair<const K, V>),
+                  "The const and mutable key pairs must share a layout");
+
+    std::pair<const K, V> &keyValPair() { return *std::launder(&m_keyValPair); }
+
+    const std::pair<const K, V> &keyValPair() const { return *std::launder(&m_keyValPair); }
+
+    std::pair<K, V> &mutableKeyValPair() { return m_mutableKeyValPair; }
+
+public:
+    FIFOHashMapCell() {}
+    FIFOHashMapCell(const FIFOHashMapCell &cell) = delete;
+    FIFOHashMapCell& operator=(const FIFOHashMapCell &other) = delete;
+
+    const K &getKey() const;
+
+    const V &getValue() const;
+
+    uint32_t getNext() const;
+
+    uint32_t getPrev() const;
+
+    friend std::ostream &operator<<(std::ostream &os, const FIFOHashMapCell &cell) {
+        os << "(" << cell.keyValPair().first <<  " , " << cell.keyValPair().second << ")";
+        return os;
+    }
+
+    /*The pair is destroyed by the map, which knows whether the cell is in use*/
+    ~FIFOHashMapCell() {}
+};
+
+/**
+ *
+ * @tparam K - key
+ * @tparam V - Value
+ * @tparam N - The size of the array, or FIFOHashMapDynamicCapacity to set it at run time.
+ * @tparam Hash - Hash function.
+ * @tparam KeyEqual
+ * @tparam Allocator - An allocator of value_type. Rebound to allocate the cell and bucket arrays, and used to construct
+ * the elements, so the elements of a map with a std::pmr::polymorphic_allocator allocate from its memory resource too.
+ * @tparam Policies - Optional policies, see FIFOHashMapSelectPolicy.
+ */
+template<
+        class K,
+        class V,
+        size_t N,
+        class Allocator = std::allocator<std::pair<const K, V>>,
+        class Hash = std::hash<K>,
+        class KeyEqual = std::equal_to<K>,
+        class... Policies
+>
+class FIFOHashMap : private FIFOHashMapCapacity<N, FIFOHashMapBuckets<Allocator>,
+        typename FIFOHashMapSelectPolicy<FIFOHashMapMaxLoadPolicyTag, FIFOHashMapMaxLoad<87>, Policies...>::type>,
+                    private FIFOHashMapCounters<
+        FIFOHashMapSelectPolicy<FIFOHashMapStatsPolicyTag, FIFOHashMapNoStats, Policies...>::type::enabled>,
+                    private FIFOHashMapTimestamps<
+        typename FIFOHashMapSelectPolicy<FIFOHashMapExpiryPolicyTag, FIFOHashMapNoExpiry, Policies...>::type, Allocator>,
+                    private FIFOHashMapAggregateSet<
+        typename FIFOHashMapSelectPolicy<FIFOHashMapAggregatesPolicyTag, FIFOHashMapNoAggregates, Policies...>::type,
+        V, Allocator> {
+
+    static_assert(N < FIFOHashMapCell<K,V>::npos, "FIFOHashMap cells are addressed by 32-bit indices");
+
+    static constexpr bool DYNAMIC = (N == FIFOHashMapDynamicCapacity);
+
+    using OrderPolicy = typename FIFOHashMapSelectPolicy<FIFOHashMapOrderPolicyTag, FIFOHashMapLinkedOrder, Policies...>::type;
+    static constexpr bool IS_RING = OrderPolicy::isRing;
+
+    using EvictionSink = typename FIFOHashMapSelectPolicy<FIFOHashMapEvictionSinkPolicyTag,
+                                                          FIFOHashMapEvictionSink<FIFOHashMapDiscardEvicted>,
+                                                          Policies...>::type::sink_type;
+
+    using MaxLoad = typename FIFOHashMapSelectPolicy<FIFOHashMapMaxLoadPolicyTag, FIFOHashMapMaxLoad<87>, Policies...>::type;
+
+    static constexpr bool STATS = FIFOHashMapSelectPolicy<FIFOHashMapStatsPolicyTag, FIFOHashMapNoStats, Policies...>::type::enabled;
+
+    using EvictionPolicy = typename FIFOHashMapSelectPolicy<FIFOHashMapEvictionPolicyTag, FIFOHashMapFifoEviction,
+                                                            Policies...>::type;
+    static_assert(!IS_RING || std::is_same<EvictionPolicy, FIFOHashMapFifoEviction>::value,
+                  "A ring order map always evicts its oldest element - other eviction policies need FIFOHashMapLinkedOrder");
+    using EvictionOrder = FIFOHashMapEvictionOrder<FIFOHashMap>;
+    friend EvictionOrder;
+
+    using ExpiryPolicy = typename FIFOHashMapSelectPolicy<FIFOHashMapExpiryPolicyTag, FIFOHashMapNoExpiry,
+                                                          Policies...>::type;
+    static constexpr bool EXPIRY = ExpiryPolicy::enabled;
+    using Timestamps = FIFOHashMapTimestamps<ExpiryPolicy, Allocator>;
+
+    using AggregatesPolicy = typename FIFOHashMapSelectPolicy<FIFOHashMapAggregatesPolicyTag, FIFOHashMapNoAggregates,
+                                                              Policies...>::type;
+    static constexpr bool AGGREGATES = !std::is_same<AggregatesPolicy, FIFOHashMapNoAggregates>::value;
+    using AggregateSet = FIFOHashMapAggregateSet<AggregatesPolicy, V, Allocator>;
+    using Lifted = typename AggregateSet::Lifted;
+
+    using Cell = FIFOHashMapCell<K,V,!IS_RING>;
+    static constexpr uint32_t npos = Cell::npos;
+
+    class FIFOHashMapQueue {
+        friend class FIFOHashMap;
+        uint32_t m_head = npos;
+        uint32_t m_tail = npos;
+
+    public:
+        FIFOHashMapQueue() = default;
+        ~FIFOHashMapQueue() = default;
+
+        void addLast(Cell *cells, uint32_t index);
+        void addFirst(Cell *cells, uint32_t index);
+        void removeLast(Cell *cells);
+        void removeFirst(Cell *cells);
+        void removeCell(Cell *cells, uint32_t index);
+
+    };
+
+    /**
+     * @brief A bidirectional iterator over the FIFO order, or over the reversed order (see rbegin()).
+     * Decrementing end() gives the last element. An iterator converts to a const iterator.
+     */
+    template<bool IS_CONST>
+    class FIFOHashMapIteratorBase {
+        friend class FIFOHashMap;
+        template<bool> friend class FIFOHashMapIteratorBase;
+        using Map = typename std::conditional<IS_CONST, const FIFOHashMap, FIFOHashMap>::type;
+
+    private:
+        uint32_t m_index = npos;
+        Map* m_pMap = nullptr;
+        bool m_isReverse = false;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<const K, V>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<IS_CONST, const value_type*, value_type*>::type;
+        using reference = typename std::conditional<IS_CONST, const value_type&, value_type&>::type;
+
+        FIFOHashMapIteratorBase() = default;
+        FIFOHashMapIteratorBase(uint32_t index, Map *pMap, bool reverse = false);
+        template<bool OTHER_CONST, typename std::enable_if<IS_CONST && !OTHER_CONST, int>::type = 0>
+        FIFOHashMapIteratorBase(const FIFOHashMapIteratorBase<OTHER_CONST> &other);
+        reference operator*() const;
+        pointer operator->() const;
+        FIFOHashMapIteratorBase& operator++();
+        FIFOHashMapIteratorBase operator++(int);
+        FIFOHashMapIteratorBase& operator--();
+        FIFOHashMapIteratorBase operator--(int);
+
+        friend bool operator==(const FIFOHashMapIteratorBase &first, const FIFOHashMapIteratorBase &second)
+        {
+            return (first.m_index == second.m_index) && (first.m_pMap == second.m_pMap);
+        }
+
+        friend bool operator!=(const FIFOHashMapIteratorBase &first, const FIFOHashMapIteratorBase &second)
+        {
+            return !(first == second);
+        }
+    };
+    using FIFOHashMapIterator = FIFOHashMapIteratorBase<false>;
+    using FIFOHashMapConstIterator = FIFOHashMapIteratorBase<true>;
+
+    using CellAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Cell>;
+    using Group = FIFOHashMapBucketGroup;
+    using Buckets = FIFOHashMapBuckets<Allocator>;
+    using CapacityBase = FIFOHashMapCapacity<N, Buckets, MaxLoad>;
+
+    /*Returned by eraseBucket when the freed bucket is in the old bucket array*/
+    static constexpr size_t NO_BUCKET = SIZE_MAX;
+    /*Old groups moved to the new bucket array by every operation while migrating*/
+    static constexpr size_t MIGRATION_STEP = 2;
+    /*How many elements ahead insert(first, last) prefetches - enough to cover a memory access with inserts*/
+    static constexpr size_t PREFETCH_DISTANCE = 8;
+    /*How many keys find_batch has in flight - about as many cache misses as a core can wait for at once*/
+    static constexpr size_t LOOKUP_CHUNK = 32;
+    /*for_each_parallel uses no more threads than it has this many elements for each*/
+    static constexpr size_t PARALLEL_MIN_ELEMENTS = 1 << 14;
+    /*Sublists the linked order is cut into for every thread - more than one, so the threads finish together*/
+    static constexpr size_t SUBLISTS_PER_THREAD = 8;
+
+    struct AllocateTag {};
+    struct EmptyTag {};
+
+    /*Members*/
+    std::vector<Cell, CellAllocator> m_cells;
+    Buckets m_buckets;
+    FIFOHashMapQueue m_queue;
+    uint32_t m_freeHead;
+    size_t m_size;
+    Hash m_hasher;
+    KeyEqual m_keyEqual;
+    EvictionSink m_evictionSink;
+    EvictionPolicy m_evictionPolicy;
+
+    /*Whether moving a map can not throw - it only swaps what the maps hold, and allocates nothing*/
+    static constexpr bool NOTHROW_MOVE =
+            std::is_nothrow_copy_constructible<Hash>::value && std::is_nothrow_copy_constructible<KeyEqual>::value &&
+            std::is_nothrow_default_constructible<EvictionSink>::value &&
+            std::is_nothrow_default_constructible<EvictionPolicy>::value &&
+            std::is_nothrow_swappable<Hash>::value && std::is_nothrow_swappable<KeyEqual>::value &&
+            std::is_nothrow_swappable<EvictionSink>::value && std::is_nothrow_swappable<EvictionPolicy>::value &&
+            std::is_nothrow_swappable<CapacityBase>::value && std::is_nothrow_swappable<Timestamps>::value &&
+            std::is_nothrow_swappable<AggregateSet>::value;
+
+    /*Private methods*/
+    FIFOHashMap(AllocateTag, size_t capacity, const Hash &hash, const KeyEqual &keyEqual, const Allocator &allocator);
+    FIFOHashMap(EmptyTag, const Hash &hash, const KeyEqual &keyEqual, const Allocator &allocator) noexcept(NOTHROW_MOVE);
+    void allocateStorage(size_t capacity);
+    void ensureStorage()
+    {
+        if(m_cells.empty())
+        {
+            allocateStorage(capacity());
+        }
+    }
+    static size_t validCapacity(size_t capacity);
+    static uint32_t mixHash(size_t hash);
+    uint32_t hashKey(const K &key) const;
+    template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type = 0>
+    uint32_t hashKey(const KeyLike &key) const;
+    template<class KeyLike>
+    size_t probeTable(const Buckets &buckets, size_t groupMask, const KeyLike &key, uint32_t hash) const;
+    template<class KeyLike>
+    size_t probeBucket(const KeyLike &key, uint32_t hash);
+    template<class KeyLike>
+    size_t dropExpired(const KeyLike &key, uint32_t hash, size_t bucket);
+    template<class KeyLike>
+    FIFOHashMapIterator findKey(const KeyLike &key, uint32_t hash);
+    template<class KeyLike>
+    size_t eraseKey(const KeyLike &key);
+    template<class KeyLike>
+    void moveKeyToTail(const KeyLike &key);
+    template<class KeyLike>
+    void moveKeyToHead(const KeyLike &key);
+    void expireCell(uint32_t cellIndex);
+    template<class Consumer>
+    size_t expireHead(typename ExpiryPolicy::clock_type::time_point now, Consumer &&consumer);
+    static size_t findEmpty(const Buckets &buckets, size_t groupMask, uint32_t hash);
+    template<class Resolve>
+    void lookupBatch(const K *keys, size_t count, Resolve &&resolve);
+    template<class KeyLike>
+    size_t probeMigrating(const KeyLike &key, uint32_t hash);
+    static size_t findCell(const Buckets &buckets, size_t groupMask, uint32_t hash, uint32_t cellIndex);
+    static size_t shiftBuckets(Buckets &buckets, size_t groupMask, size_t hole);
+    static void placeBucket(Buckets &buckets, size_t groupMask, FIFOHashMapBucket bucket);
+    size_t eraseBucket(uint32_t hash, uint32_t cellIndex);
+    void migrateStep();
+    void finishMigration();
+    void shrinkTo(size_t capacity);
+    void growTo(size_t capacity);
+    void rebuild(size_t capacity);
+    void relocateCell(Cell &from, Cell &to);
+    template<class... Args>
+    void constructPair(Cell &cell, Args&&... args);
+    void destroyPair(Cell &cell);
+    void retargetBucket(uint32_t cellIndex, uint32_t target);
+    template<class... Args>
+    std::pair<FIFOHashMapIterator, bool> emplaceHashed(const K &key, uint32_t hash, Args&&... args);
+    template<class KeyArg, class ValueArg,
+             typename std::enable_if<std::is_same<typename std::decay<KeyArg>::type, K>::value, int>::type = 0>
+    std::pair<FIFOHashMapIterator, bool> emplaceImpl(KeyArg &&key, ValueArg &&value);
+    template<class Pair,
+             typename std::enable_if<FIFOHashMapIsKeyedPair<typename std::decay<Pair>::type, K>::value, int>::type = 0>
+    std::pair<FIFOHashMapIterator, bool> emplaceImpl(Pair &&pair);
+    template<class... Args>
+    std::pair<FIFOHashMapIterator, bool> emplaceImpl(Args&&... args);
+    template<class Consumer, class... Args>
+    uint32_t insertNew(Consumer &&onEvict, uint32_t hash, size_t bucket, Args&&... args);
+    template<class... Args>
+    uint32_t recycleVictim(uint32_t hash, size_t bucket, Args&&... args);
+    size_t nearerBucket(uint32_t hash, size_t bucket, size_t freedBucket) const;
+    template<class Consumer>
+    size_t evictHead(Consumer &&consumer);
+    template<class Consumer>
+    size_t evictVictim(Consumer &&consumer);
+    template<class Consumer>
+    size_t evictCell(uint32_t cellIndex, Consumer &&consumer);
+    size_t eraseCell(uint32_t cellIndex);
+    size_t eraseCell(uint32_t cellIndex, const Lifted &lifted);
+    template<class M>
+    void assignCell(uint32_t cellIndex, M &&obj);
+    void accessCell(uint32_t cellIndex);
+    void prefetchBucket(uint32_t hash) const;
+    void countProbe(uint32_t hash, size_t bucket);
+    void initFreeList();
+    void copyElements(const FIFOHashMap &other);
+    uint32_t headIndex() const;
+    uint32_t tailIndex() const;
+    uint32_t nextIndex(uint32_t cellIndex) const;
+    uint32_t prevIndex(uint32_t cellIndex) const;
+    uint32_t cellHash(uint32_t cellIndex) const
+    {
+        return m_cells[cellIndex].m_hash;
+    }
+    template<class Visit>
+    void visitCells(Visit &&visit, size_t threads) const;
+    template<class Task>
+    static void runThreads(size_t threads, Task &&task);
+
+    /*Methods*/
+public:
+    FIFOHashMap();
+    explicit FIFOHashMap(const Allocator &allocator);
+    FIFOHashMap(const Hash &hash, const KeyEqual &keyEqual, const Allocator &allocator = Allocator());
+    /**
+     * @brief Constructs a runtime-capacity map (N = FIFOHashMapDynamicCapacity).
+     * @param capacity - The maximum number of elements. Throws std::invalid_argument unless it is in [1, 2^32 - 1).
+     */
+    explicit FIFOHashMap(size_t capacity);
+    FIFOHashMap(size_t capacity, const Allocator &allocator);
+    FIFOHashMap(size_t capacity, const Hash &hash, const KeyEqual &keyEqual, const Allocator &allocator = Allocator());
+    FIFOHashMap(std::initializer_list<std::pair<const K, V>> initList);
+    FIFOHashMap(const FIFOHashMap &other);
+    /**
+     * @brief Takes over the storage of other, without allocating. other is left empty and holds no storage until it
+     * looks up or inserts a key again.
+     */
+    FIFOHashMap(FIFOHashMap &&other) noexcept(NOTHROW_MOVE);
+    FIFOHashMap& operator=(const FIFOHashMap &other);
+    FIFOHashMap& operator=(FIFOHashMap &&other)
+            noexcept(NOTHROW_MOVE && std::allocator_traits<Allocator>::is_always_equal::value);
+
+    ~FIFOHashMap();
+
+
+    using value_type = std::pair<const K, V>;
+    using iterator = FIFOHashMapIterator;
+    using const_iterator = FIFOHashMapConstIterator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using allocator_type = Allocator;
+    using clock_type = typename ExpiryPolicy::clock_type;
+
+    /*Insert methods*/
+    /**
+     * @brief Insert new element to the hash map. If the key is already exist - do nothing.
+     * @param value - (Key,Value) pair.
+     * @return A std::pair consisting of an iterator to the inserted element
+     * (or to the element that prevented the insertion) and a bool denoting whether the insertion took place
+     * (true if insertion happened, false if it did not).
+     */
+    std::pair<FIFOHashMapIterator, bool> insert(const value_type& value);
+    std::pair<FIFOHashMapIterator,bool> insert( value_type&& value );
+    /**
+     * @brief Same as insert(value), for callers that already hashed the key (e.g. to route it to a shard).
+     * @param value - (Key,Value) pair.
+     * @param hash - hash_function()(value.first). The key is not hashed again.
+     */
+    std::pair<FIFOHashMapIterator, bool> insert(const value_type& value, size_t hash);
+    std::pair<FIFOHashMapIterator, bool> insert(value_type&& value, size_t hash);
+    /**
+     * @brief Same as emplace(std::forward<P>(value)) - e.g. a std::pair<K, V> temporary is moved in, key included.
+     */
+    template<class P,
+             typename std::enable_if<std::is_constructible<value_type, P&&>::value, int>::type = 0>
+    std::pair<FIFOHashMapIterator, bool> insert(P&& value);
+    /**
+     * @brief Same as insert(value), but if the map is full the oldest element is moved out to evicted
+     * instead of being destroyed (the eviction sink is not called).
+     * @param value - (Key,Value) pair.
+     * @param evicted - Set to the evicted element if there was one, reset otherwise.
+     */
+    std::pair<FIFOHashMapIterator, bool> insert(const value_type& value, std::optional<std::pair<K, V>> &evicted);
+    std::pair<FIFOHashMapIterator, bool> insert(value_type&& value, std::optional<std::pair<K, V>> &evicted);
+    /**
+     * @brief Inserts the elements of [first, last) in order, with the same result as inserting them one by one.
+     * With forward iterators the keys are hashed a few elements ahead and their buckets prefetched, as are the
+     * buckets of the elements they are going to evict - so the cache misses of consecutive inserts overlap.
+     * @param first, last - Range of (Key,Value) pairs.
+     * @return Number of elements inserted.
+     */
+    template<class InputIt, typename std::enable_if<FIFOHashMapIsIterator<InputIt>::value, int>::type = 0>
+    size_t insert(InputIt first, InputIt last);
+    /**
+     * @brief Same as insert(first, last) for values[0, count), but the pairs are moved from.
+     * @param values - Array of (Key,Value) pairs, e.g. std::pair<K, V> so the keys are moved too.
+     * @return Number of elements inserted.
+     */
+    template<class Pair>
+    size_t insert_batch(Pair *values, size_t count);
+
+    /**
+     * @brief Inserts a new element constructed in place from args, if there is no element with the key.
+     * When args are a key and a value, or a pair, the key is looked up first and nothing is constructed on a hit.
+     * Otherwise the element is constructed first to find out its key.
+     * @param args - arguments to forward to the constructor of the (Key,Value) pair.
+     * @return Same as insert.
+     */
+    template<class... Args>
+    std::pair<FIFOHashMapIterator, bool> emplace(Args&&... args);
+
+    /**
+     * @brief If the key does not exist, inserts an element with the key and a value constructed in place from args.
+     * If the key exists, does nothing - args are not moved from.
+     * @param key - the key of the element to find or insert.
+     * @param args - arguments to forward to the constructor of the value.
+     * @return Same as insert.
+     */
+    template<class... Args>
+    std::pair<FIFOHashMapIterator, bool> try_emplace(const K& key, Args&&... args);
+    template<class... Args>
+    std::pair<FIFOHashMapIterator, bool> try_emplace(K&& key, Args&&... args);
+
+    /**
+     * @brief If the key exists, assigns obj to its value (the position in the queue does not change).
+     * Otherwise inserts it like insert does.
+     * @param key - the key of the element to find or insert.
+     * @param obj - the value to assign or insert.
+     * @return Same as insert - the bool is true if insertion took place and false if the assignment took place.
+     */
+    template<class M>
+    std::pair<FIFOHashMapIterator, bool> insert_or_assign(const K& key, M&& obj);
+    template<class M>
+    std::pair<FIFOHashMapIterator, bool> insert_or_assign(K&& key, M&& obj);
+
+    /*Erase methods*/
+    /**
+     * @brief Removes the element at pos.
+     * @param pos - iterator to the element to remove.
+     * @return Iterator following the removed element, in the direction of pos: end(), or rend() for an iterator
+     * from rbegin(), if it was the last one.
+     */
+    FIFOHashMapIterator erase( FIFOHashMapIterator pos );
+    /**
+     * @brief  Removes the element (if one exists) with the key equivalent to key.
+     * @param key
+     * @return Number of elements removed (0 or 1).
+     */
+    size_t erase( const K& key );
+    /**
+     * @brief Same as erase(key), for a key of another type than K, see find(const KeyLike&).
+     */
+    template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type = 0>
+    size_t erase(const KeyLike &key);
+
+    /**
+     * @brief Removes all the elements. The storage is kept for reuse.
+     */
+    void clear();
+
+    /**
+     * @brief Finds an element with key equivalent to key.
+     * @param key - key value of the element to search for
+     * @return An iterator to the requested element. If no such element is found,
+     * past-the-end (see end()) iterator is returned.
+     *
+     */
+    FIFOHashMapIterator find(const K& key);
+    /**
+     * @brief Same as find(key), for callers that already hashed the key.
+     * @param key - key value of the element to search for
+     * @param hash - hash_function()(key). The key is not hashed again.
+     */
+    FIFOHashMapIterator find(const K& key, size_t hash);
+    /**
+     * @brief Same as find(key), for a key of another type than K that compares equal to the keys - a std::string_view
+     * or a const char* for std::string keys, without building a std::string. Only there if Hash and KeyEqual are
+     * transparent, like FIFOHashMapStringHash and std::equal_to<>, and Hash hashes key as it hashes the equal K.
+     */
+    template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type = 0>
+    FIFOHashMapIterator find(const KeyLike &key);
+    /**
+     * @brief Finds count keys at once - results[i] is find(keys[i]).
+     * The keys are hashed a few dozen at a time and all their buckets are prefetched before any of them is probed,
+     * so the cache misses of the lookups overlap instead of following each other.
+     * @param keys - Array of count keys.
+     * @param results - Array of count iterators to write to.
+     */
+    void find_batch(const K *keys, size_t count, iterator *results);
+    /**
+     * @brief Same as find_batch, but only tells whether each key exists.
+     * @param found - (count + 63) / 64 words. Bit i % 64 of found[i / 64] is set if keys[i] exists, cleared otherwise.
+     * @return Number of keys that exist.
+     */
+    size_t contains_batch(const K *keys, size_t count, uint64_t *found);
+
+    /*Value access*/
+    /**
+     * @brief Returns a reference to the value that is mapped to a key equivalent to key,
+     * performing an insertion if such key does not already exist.
+     * @param key - the key of the element to find
+     * @return A reference to the mapped value of the new element if no element with key key existed.
+     * Otherwise, a reference to the mapped value of the existing element whose key is equivalent to key.
+     * With the FIFOHashMapAggregates policy, what is written through it until the next call on the map is aggregated.
+     */
+    V& operator[]( const K& key );
+    /**
+     * @brief Returns a reference to the value that is mapped to a key equivalent to key,
+     * performing an insertion if such key does not already exist.
+     * @param key - the key of the element to find
+     * @return A reference to the mapped value of the new element if no element with key key existed.
+     * Otherwise, a reference to the mapped value of the existing element whose key is equivalent to key.
+     */
+    V& operator[]( K&& key );
+
+    /**
+     * @brief Popping the first element in the queue
+     */
+    void pop();
+    /**
+     * @brief Popping the first element in the queue, moving it out instead of destroying it.
+     * @param oldest - Move assigned the first element, if there is one.
+     * @return false if the map is empty.
+     */
+    bool pop(std::pair<K, V> &oldest);
+
+    /**
+     * @brief Pops the oldest count elements (or all of them, if there are fewer) and moves them to out, oldest first.
+     * @param count - maximum number of elements to pop.
+     * @param out - output iterator accepting std::pair<K, V>.
+     * @return Number of elements popped.
+     */
+    template<class OutputIt>
+    size_t drain(size_t count, OutputIt out);
+
+    /**
+     * @brief Move the element to the end of the queue if existed. If not - do nothing
+     * @param key
+     */
+    void moveElementToTail(const K& key);
+    template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type = 0>
+    void moveElementToTail(const KeyLike &key);
+
+    /**
+     * @brief Move the element to the beginning of the queue if existed. If not - do nothing
+     * @param key
+     */
+    void moveElementToHead(const K& key);
+    template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type = 0>
+    void moveElementToHead(const KeyLike &key);
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    bool isFull() const;
+
+    /**
+     * @return The maximum number of elements - N, or the runtime capacity.
+     */
+    using CapacityBase::capacity;
+
+    /**
+     * @return Number of buckets in the hash index.
+     */
+    using CapacityBase::bucket_count;
+
+    /**
+     * @brief Changes the capacity of a runtime-capacity map (N = FIFOHashMapDynamicCapacity).
+     * Shrinking below size() evicts the oldest elements, which are passed to the eviction sink.
+     * Iterators are invalidated.
+     * @param capacity - The new maximum number of elements. Throws std::invalid_argument unless it is in [1, 2^32 - 1).
+     */
+    void set_capacity(size_t capacity);
+
+    /**
+     * @brief Memory held by the map itself: the object, the cell array and the bucket arrays.
+     * Heap memory owned by the keys and values (e.g. long std::string buffers) is not included.
+     * All of it is allocated on construction, so it does not change with size().
+     * @return Size in bytes.
+     */
+    size_t memory_usage() const;
+
+    /**
+     * @return memory_usage() divided by the capacity - the cost of one element of a full map, to size it against a RAM budget.
+     */
+    double bytes_per_entry() const;
+
+    Hash hash_function() const
+    {
+        return m_hasher;
+    }
+
+    KeyEqual key_eq() const
+    {
+        return m_keyEqual;
+    }
+
+    Allocator get_allocator() const
+    {
+        return Allocator(m_cells.get_allocator());
+    }
+
+    /**
+     * @return The counters since construction or the last reset_stats(). Needs the FIFOHashMapStats policy.
+     * A copy of a map, and a map assigned a copy, start with their counters at 0.
+     */
+    FIFOHashMapStatistics stats() const;
+
+    /**
+     * @brief Sets all the counters to 0. Needs the FIFOHashMapStats policy.
+     */
+    void reset_stats();
+
+    /**
+     * @brief Sets the time to live of the elements - those inserted longer ago than ttl are expired, including the
+     * ones already in the map. Until it is set nothing expires. Needs the FIFOHashMapExpiry policy.
+     */
+    void set_ttl(typename clock_type::duration ttl);
+
+    /**
+     * @return The time to live. Needs the FIFOHashMapExpiry policy.
+     */
+    typename clock_type::duration ttl() const;
+
+    /**
+     * @return The clock that stamps the inserted elements and that lookups check them against.
+     * Needs the FIFOHashMapExpiry policy.
+     */
+    clock_type& clock();
+
+    /**
+     * @brief Removes the expired elements at the head: it stops at the first one that is not expired, so it takes
+     * time in the number of removed elements only, not in the size of the map.
+     * The head is the oldest element unless elements were reordered (moveElementToHead, or an eviction policy
+     * other than FIFO): expired elements behind a newer one stay until they are evicted or looked up - a lookup
+     * never finds an expired element. Needs the FIFOHashMapExpiry policy.
+     * @param now - The current time of clock().
+     * @return Number of elements removed.
+     */
+    size_t expire(typename clock_type::time_point now);
+
+    /**
+     * @brief Like expire(now), but moves the removed elements to out, oldest first.
+     * @param out - output iterator accepting std::pair<K, V>.
+     */
+    template<class OutputIt>
+    size_t expire(typename clock_type::time_point now, OutputIt out);
+
+    /**
+     * @return The aggregate of the values of the elements, kept up to date as they come and go - see
+     * FIFOHashMapAggregates. Aggregate must be one of those of the policy. Invertible aggregates (count, sum, mean)
+     * return in O(1); selective ones (min, max) in O(1) too, unless renumbering the elements made it rebuild.
+     */
+    template<class Aggregate>
+    auto aggregate();
+
+    /**
+     * @brief Recomputes the aggregates, on their next aggregate() - after values were changed through iterators,
+     * find() or for_each, or to clear the rounding of a floating point sum. Needs the FIFOHashMapAggregates policy.
+     */
+    void refresh_aggregates();
+
+    /**
+     * @brief Writes the elements, oldest first, to a snapshot file that load() restores - e.g. to restart warm.
+     * Keys and values go through FIFOHashMapSerializer: trivially copyable types and strings work as they are.
+     * The file is written next to path and renamed over it when complete, so path always holds a whole snapshot.
+     * Throws std::runtime_error if the file can not be written.
+     */
+    void save(const std::string &path) const;
+
+    /**
+     * @brief Replaces the contents of the map with a snapshot written by save(), in the same order.
+     * The cells and buckets are filled in directly, without the lookups of insert. If the snapshot holds more
+     * elements than the capacity, only the newest are loaded. Expiry times start over: the elements are stamped with
+     * the time of the load. Throws std::runtime_error if the file can not be read, was saved from a map of other types,
+     * or is truncated - the map then holds the elements read before the error.
+     */
+    void load(const std::string &path);
+
+    /**
+     * @return The eviction policy, see FIFOHashMapFifoEviction.
+     */
+    EvictionPolicy& eviction_policy()
+    {
+        return m_evictionPolicy;
+    }
+
+    /**
+     * @return The sink that receives elements evicted at capacity, see FIFOHashMapEvictionSink.
+     */
+    EvictionSink& eviction_sink()
+    {
+        return m_evictionSink;
+    }
+
+    /**
+     *
+     * @return Iterator to the first element.
+     */
+    FIFOHashMapIterator begin()
+    {
+        return FIFOHashMapIterator{headIndex(), this};
+    }
+    /**
+     *
+     * @return Iterator to the element following the last element.
+     */
+    FIFOHashMapIterator end()
+    {
+        return FIFOHashMapIterator{npos, this};
+    }
+    /**
+     *
+     * @return Returns a reverse iterator to the first element of the reversed queue.
+     * It corresponds to the last element of the non-reversed queue.
+     * If the vector is queue, the returned iterator is equal to rend().
+     */
+    FIFOHashMapIterator rbegin()
+    {
+        return FIFOHashMapIterator{tailIndex(), this, true};
+    }
+    /**
+     *
+     * @return Returns a reverse iterator to the element following the last element of the reversed vector.
+     * It corresponds to the element preceding the first element of the non-reversed queue.
+     * This element acts as a placeholder, attempting to access it results in undefined behavior.
+     */
+    FIFOHashMapIterator rend()
+    {
+        return FIFOHashMapIterator{npos, this, true};
+    }
+
+    FIFOHashMapConstIterator begin() const
+    {
+        return FIFOHashMapConstIterator{headIndex(), this};
+    }
+
+    FIFOHashMapConstIterator end() const
+    {
+        return FIFOHashMapConstIterator{npos, this};
+    }
+
+    FIFOHashMapConstIterator rbegin() const
+    {
+        return FIFOHashMapConstIterator{tailIndex(), this, true};
+    }
+
+    FIFOHashMapConstIterator rend() const
+    {
+        return FIFOHashMapConstIterator{npos, this, true};
+    }
+
+    FIFOHashMapConstIterator cbegin() const
+    {
+        return begin();
+    }
+
+    FIFOHashMapConstIterator cend() const
+    {
+        return end();
+    }
+
+    /*Traversal*/
+    /**
+     * @brief Calls fn(element, position) on every element, in order - position 0 is the first element.
+     * fn may modify the values, but must not insert or erase elements.
+     */
+    template<class Fn>
+    void for_each(Fn &&fn);
+    template<class Fn>
+    void for_each(Fn &&fn) const;
+
+    /**
+     * @brief Same as for_each, but the order is cut into chunks that up to threads threads process at once,
+     * each element with its position in the order. fn is called concurrently, on different elements.
+     * Maps too small to be worth a thread are processed on the calling thread. If fn throws, the first exception
+     * is rethrown once all the threads have finished.
+     * In linked order the chunks start at cells spread over the cell array, and every chunk is walked twice - once to
+     * count it and once to visit it - so the pointer chase of a large map is spread over the threads.
+     */
+    template<class Fn>
+    void for_each_parallel(Fn &&fn, size_t threads);
+    template<class Fn>
+    void for_each_parallel(Fn &&fn, size_t threads) const;
+
+    /**
+     * @brief Erases the elements for which pred(element, position) returns true, position being the one in the order
+     * before erasing. With threads > 1 pred is called like fn of for_each_parallel, and the elements are erased after.
+     * Not available in ring order.
+     * @return Number of elements erased.
+     */
+    template<class Pred>
+    size_t erase_if(Pred &&pred, size_t threads = 1);
+
+};
+
+/**
+ * @brief A FIFOHashMap with std::string keys that find, erase and the moves also look up by std::string_view or
+ * const char*, without building a std::string.
+ */
+template<class V, size_t N, class... Policies>
+using FIFOHashMapStringKeys = FIFOHashMap<std::string, V, N, std::allocator<std::pair<const std::string, V>>,
+                                          FIFOHashMapStringHash, std::equal_to<>, Policies...>;
+
+/**
+ * @brief Same as FIFOHashMapStringKeys, with the keys of up to KeySize - 1 characters stored in the cells themselves,
+ * see FIFOHashMapInlineString.
+ */
+template<class V, size_t N, size_t KeySize = 32, class... Policies>
+using FIFOHashMapInlineStringKeys = FIFOHashMap<FIFOHashMapInlineString<KeySize>, V, N,
+                                                std::allocator<std::pair<const FIFOHashMapInlineString<KeySize>, V>>,
+                                                FIFOHashMapStringHash, std::equal_to<>, Policies...>;
+
+#if defined(FIFOHashMap_PMR)
+/**
+ * @brief A FIFOHashMap that allocates its arrays and its elements from a std::pmr::memory_resource, like std::pmr::unordered_map.
+ */
+template<class K, class V, size_t N, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>, class... Policies>
+using FIFOHashMapPmr = FIFOHashMap<K, V, N, std::pmr::polymorphic_allocator<std::pair<const K, V>>, Hash, KeyEqual,
+                                   Policies...>;
+#endif
+
+/*FIFOHashMap*/
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap():FIFOHashMap(Hash(), KeyEqual())
+{
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(const Allocator &allocator):
+        FIFOHashMap(Hash(), KeyEqual(), allocator)
+{
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(const Hash &hash, const KeyEqual &keyEqual,
+                                                                         const Allocator &allocator):
+        FIFOHashMap(AllocateTag{}, N, hash, keyEqual, allocator)
+{
+    static_assert(!DYNAMIC, "A runtime-capacity FIFOHashMap is constructed with its capacity");
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(size_t capacity):
+        FIFOHashMap(capacity, Hash(), KeyEqual())
+{
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(size_t capacity, const Allocator &allocator):
+        FIFOHashMap(capacity, Hash(), KeyEqual(), allocator)
+{
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(size_t capacity, const Hash &hash,
+                                                                         const KeyEqual &keyEqual,
+                                                                         const Allocator &allocator):
+        FIFOHashMap(AllocateTag{}, capacity, hash, keyEqual, allocator)
+{
+    static_assert(DYNAMIC, "The capacity of this FIFOHashMap is N - construct it without arguments");
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(AllocateTag, size_t capacity, const Hash &hash,
+                                                                         const KeyEqual &keyEqual,
+                                                                         const Allocator &allocator):
+        FIFOHashMap(EmptyTag{}, hash, keyEqual, allocator)
+{
+    allocateStorage(capacity);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(EmptyTag, const Hash &hash,
+                                                                         const KeyEqual &keyEqual,
+                                                                         const Allocator &allocator) noexcept(NOTHROW_MOVE):
+        CapacityBase(typename Buckets::allocator_type(allocator)), Timestamps(allocator), AggregateSet(allocator),
+        m_cells(CellAllocator(allocator)), m_buckets(typename Buckets::allocator_type(allocator)),
+        m_queue{}, m_freeHead{npos}, m_size{0}, m_hasher(hash), m_keyEqual(keyEqual), m_evictionSink{}, m_evictionPolicy{}
+{
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(std::initializer_list<std::pair<const K, V>> initList):FIFOHashMap()
+{
+    for (const auto &p: initList)
+    {
+        insert(p);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(const FIFOHashMap &other):
+        FIFOHashMap(AllocateTag{}, other.capacity(), other.m_hasher, other.m_keyEqual,
+                    std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+{
+    m_evictionSink = other.m_evictionSink;
+    m_evictionPolicy = other.m_evictionPolicy;
+    EvictionOrder order(*this);
+    m_evictionPolicy.on_rebuild(order);
+    copyElements(other);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap(FIFOHashMap &&other) noexcept(NOTHROW_MOVE):
+        FIFOHashMap(EmptyTag{}, other.m_hasher, other.m_keyEqual, other.get_allocator())
+{
+    /*The moved-from map is left empty but usable, with no storage - it keeps its capacity, to allocate it again*/
+    std::swap(static_cast<CapacityBase&>(*this), static_cast<CapacityBase&>(other));
+    std::swap(m_cells, other.m_cells);
+    std::swap(m_buckets, other.m_buckets);
+    std::swap(m_queue, other.m_queue);
+    std::swap(m_freeHead, other.m_freeHead);
+    std::swap(m_size, other.m_size);
+    std::swap(m_evictionSink, other.m_evictionSink);
+    std::swap(m_evictionPolicy, other.m_evictionPolicy);
+    std::swap(static_cast<Timestamps&>(*this), static_cast<Timestamps&>(other));
+    std::swap(static_cast<AggregateSet&>(*this), static_cast<AggregateSet&>(other));
+    if constexpr (DYNAMIC)
+    {
+        other.m_capacity = this->m_capacity;
+        other.m_groupMask = this->m_groupMask;
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...> &
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::operator=(const FIFOHashMap &other)
+{
+    if(this == &other)
+    {
+        return *this;
+    }
+    clear();
+    if constexpr (DYNAMIC)
+    {
+        set_capacity(other.capacity());
+    }
+    m_hasher = other.m_hasher;
+    m_keyEqual = other.m_keyEqual;
+    m_evictionSink = other.m_evictionSink;
+    m_evictionPolicy = other.m_evictionPolicy;
+    EvictionOrder order(*this);
+    m_evictionPolicy.on_rebuild(order);
+    copyElements(other);
+    return *this;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...> &
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::operator=(FIFOHashMap &&other)
+        noexcept(NOTHROW_MOVE && std::allocator_traits<Allocator>::is_always_equal::value)
+{
+    if(this == &other)
+    {
+        return *this;
+    }
+    if constexpr (!std::allocator_traits<Allocator>::is_always_equal::value)
+    {
+        if(get_allocator() != other.get_allocator())
+        {
+            /*The storage of other can not be adopted by this allocator - the elements are copied instead*/
+            *this = static_cast<const FIFOHashMap&>(other);
+            other.clear();
+            return *this;
+        }
+    }
+    clear();
+    std::swap(m_hasher, other.m_hasher);
+    std::swap(m_keyEqual, other.m_keyEqual);
+    std::swap(static_cast<CapacityBase&>(*this), static_cast<CapacityBase&>(other));
+    std::swap(m_cells, other.m_cells);
+    std::swap(m_buckets, other.m_buckets);
+    std::swap(m_queue, other.m_queue);
+    std::swap(m_freeHead, other.m_freeHead);
+    std::swap(m_size, other.m_size);
+    std::swap(m_evictionSink, other.m_evictionSink);
+    std::swap(m_evictionPolicy, other.m_evictionPolicy);
+    std::swap(static_cast<Timestamps&>(*this), static_cast<Timestamps&>(other));
+    std::swap(static_cast<AggregateSet&>(*this), static_cast<AggregateSet&>(other));
+    return *this;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::~FIFOHashMap()
+{
+    clear();
+}
+
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(FIFOHashMap::value_type &&value)
+{
+    const uint32_t hash = hashKey(value.first);
+    return emplaceHashed(value.first, hash, std::move(value));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::
+insert(const FIFOHashMap::value_type &value)
+{
+    return emplaceHashed(value.first, hashKey(value.first), value);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(FIFOHashMap::value_type &&value, size_t hash)
+{
+    return emplaceHashed(value.first, mixHash(hash), std::move(value));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(const FIFOHashMap::value_type &value, size_t hash)
+{
+    return emplaceHashed(value.first, mixHash(hash), value);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(const FIFOHashMap::value_type &value,
+                                                                     std::optional<std::pair<K, V>> &evicted)
+{
+    evicted.reset();
+    const uint32_t hash = hashKey(value.first);
+    const size_t bucket = probeBucket(value.first, hash);
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        this->count(&FIFOHashMapStatistics::m_duplicates);
+        return std::make_pair(FIFOHashMapIterator{m_buckets[bucket].m_cell, this}, false);
+    }
+    auto moveOut = [&evicted](K &&key, V &&mapped) { evicted.emplace(std::move(key), std::move(mapped)); };
+    const uint32_t index = insertNew(moveOut, hash, bucket, value);
+    return std::make_pair(FIFOHashMapIterator{index, this}, true);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(FIFOHashMap::value_type &&value,
+                                                                     std::optional<std::pair<K, V>> &evicted)
+{
+    evicted.reset();
+    const uint32_t hash = hashKey(value.first);
+    const size_t bucket = probeBucket(value.first, hash);
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        this->count(&FIFOHashMapStatistics::m_duplicates);
+        return std::make_pair(FIFOHashMapIterator{m_buckets[bucket].m_cell, this}, false);
+    }
+    auto moveOut = [&evicted](K &&key, V &&mapped) { evicted.emplace(std::move(key), std::move(mapped)); };
+    const uint32_t index = insertNew(moveOut, hash, bucket, std::move(value));
+    return std::make_pair(FIFOHashMapIterator{index, this}, true);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class InputIt, typename std::enable_if<FIFOHashMapIsIterator<InputIt>::value, int>::type>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(InputIt first, InputIt last)
+{
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    size_t inserted = 0;
+    if constexpr (!std::is_base_of<std::forward_iterator_tag, Category>::value)
+    {
+        /*A single pass range - there is no looking ahead*/
+        for(; first != last; ++first)
+        {
+            inserted += emplace(*first).second;
+        }
+        return inserted;
+    }
+    else
+    {
+        ensureStorage();
+        /*hashes[i % PREFETCH_DISTANCE] is the hash of element i until element i is inserted,
+         *then of element i + PREFETCH_DISTANCE, whose bucket is prefetched right away*/
+        uint32_t hashes[PREFETCH_DISTANCE];
+        InputIt ahead = first;
+        for(size_t i = 0; (i < PREFETCH_DISTANCE) && (ahead != last); i++, ++ahead)
+        {
+            hashes[i] = hashKey((*ahead).first);
+            prefetchBucket(hashes[i]);
+        }
+
+        /*Linked order: the cell that will be evicted PREFETCH_DISTANCE evictions from now - found once the map is full*/
+        uint32_t evictAhead = npos;
+        for(size_t i = 0; first != last; i++, ++first)
+        {
+            const uint32_t hash = hashes[i % PREFETCH_DISTANCE];
+            if(ahead != last)
+            {
+                hashes[i % PREFETCH_DISTANCE] = hashKey((*ahead).first);
+                prefetchBucket(hashes[i % PREFETCH_DISTANCE]);
+                ++ahead;
+            }
+
+            const bool full = (m_size >= capacity());
+            if(full && (PREFETCH_DISTANCE < m_size))
+            {
+                if constexpr (IS_RING)
+                {
+                    const size_t position = m_queue.m_head + PREFETCH_DISTANCE;
+                    prefetchBucket(m_cells[(position >= capacity()) ? position - capacity() : position].m_hash);
+                }
+                else
+                {
+                    if(evictAhead == npos)
+                    {
+                        evictAhead = m_queue.m_head;
+                        for(size_t step = 0; step < PREFETCH_DISTANCE; step++)
+                        {
+                            evictAhead = nextIndex(evictAhead);
+                        }
+                    }
+                    prefetchBucket(m_cells[evictAhead].m_hash);
+                }
+            }
+
+            auto &&value = *first;
+            if(emplaceHashed(value.first, hash, std::forward<decltype(value)>(value)).second)
+            {
+                inserted++;
+                if constexpr (!IS_RING)
+                {
+                    /*The head moved one cell on - so does the cell ahead of it*/
+                    if(full && (evictAhead != npos))
+                    {
+                        evictAhead = nextIndex(evictAhead);
+                    }
+                }
+            }
+        }
+        return inserted;
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Pair>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert_batch(Pair *values, size_t count)
+{
+    return insert(std::make_move_iterator(values), std::make_move_iterator(values + count));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+V &FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::operator[](K &&key)
+{
+    const uint32_t hash = hashKey(key);
+    const size_t bucket = probeBucket(key, hash);
+    this->count((m_buckets[bucket].m_cell != npos) ? &FIFOHashMapStatistics::m_hits : &FIFOHashMapStatistics::m_misses);
+    uint32_t index = m_buckets[bucket].m_cell;
+    if(index != npos)
+    {
+        accessCell(index);
+    }
+    else
+    {
+        index = insertNew(m_evictionSink, hash, bucket, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                          std::tuple<>());
+    }
+    V &value = m_cells[index].keyValPair().second;
+    this->detachAggregated(index, value);
+    return value;
+}
+
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+V &FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::
+operator[](const K &key)
+{
+    const uint32_t hash = hashKey(key);
+    const size_t bucket = probeBucket(key, hash);
+    this->count((m_buckets[bucket].m_cell != npos) ? &FIFOHashMapStatistics::m_hits : &FIFOHashMapStatistics::m_misses);
+    uint32_t index = m_buckets[bucket].m_cell;
+    if(index != npos)
+    {
+        accessCell(index);
+    }
+    else
+    {
+        index = insertNew(m_evictionSink, hash, bucket, std::piecewise_construct, std::forward_as_tuple(key),
+                          std::tuple<>());
+    }
+    V &value = m_cells[index].keyValPair().second;
+    this->detachAggregated(index, value);
+    return value;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class P, typename std::enable_if<std::is_constructible<std::pair<const K, V>, P&&>::value, int>::type>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert(P &&value)
+{
+    return emplace(std::forward<P>(value));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::emplace(Args&&... args)
+{
+    return emplaceImpl(std::forward<Args>(args)...);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::try_emplace(const K &key, Args&&... args)
+{
+    return emplaceHashed(key, hashKey(key), std::piecewise_construct, std::forward_as_tuple(key),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::try_emplace(K &&key, Args&&... args)
+{
+    const uint32_t hash = hashKey(key);
+    return emplaceHashed(key, hash, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class M>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert_or_assign(const K &key, M &&obj)
+{
+    const uint32_t hash = hashKey(key);
+    const size_t bucket = probeBucket(key, hash);
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        assignCell(m_buckets[bucket].m_cell, std::forward<M>(obj));
+        return std::make_pair(FIFOHashMapIterator{m_buckets[bucket].m_cell, this}, false);
+    }
+    const uint32_t index = insertNew(m_evictionSink, hash, bucket, key, std::forward<M>(obj));
+    return std::make_pair(FIFOHashMapIterator{index, this}, true);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class M>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insert_or_assign(K &&key, M &&obj)
+{
+    const uint32_t hash = hashKey(key);
+    const size_t bucket = probeBucket(key, hash);
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        assignCell(m_buckets[bucket].m_cell, std::forward<M>(obj));
+        return std::make_pair(FIFOHashMapIterator{m_buckets[bucket].m_cell, this}, false);
+    }
+    const uint32_t index = insertNew(m_evictionSink, hash, bucket, std::move(key), std::forward<M>(obj));
+    return std::make_pair(FIFOHashMapIterator{index, this}, true);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap::FIFOHashMapIterator
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::erase(FIFOHashMap::FIFOHashMapIterator pos) {
+    static_assert(!IS_RING, "erase is not available in ring order");
+    if(pos == end())
+    {
+        return end();
+    }
+    const Cell &cell = m_cells[pos.m_index];
+    const uint32_t following = pos.m_isReverse ? cell.m_prev : cell.m_next;
+    eraseCell(pos.m_index);
+    this->count(&FIFOHashMapStatistics::m_erasures);
+    return FIFOHashMapIterator{following, this, pos.m_isReverse};
+}
+
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::erase(const K &key)
+{
+    return eraseKey(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::erase(const KeyLike &key)
+{
+    return eraseKey(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::clear()
+{
+    while(m_size != 0)
+    {
+        evictHead(FIFOHashMapDiscardEvicted{});
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Fn>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::for_each(Fn &&fn)
+{
+    visitCells([this, &fn](uint32_t index, size_t position)
+               {
+                   fn(m_cells[index].keyValPair(), position);
+               }, 1);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Fn>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::for_each(Fn &&fn) const
+{
+    visitCells([this, &fn](uint32_t index, size_t position)
+               {
+                   fn(const_cast<const value_type&>(m_cells[index].keyValPair()), position);
+               }, 1);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Fn>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::for_each_parallel(Fn &&fn, size_t threads)
+{
+    visitCells([this, &fn](uint32_t index, size_t position)
+               {
+                   fn(m_cells[index].keyValPair(), position);
+               }, threads);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Fn>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::for_each_parallel(Fn &&fn, size_t threads) const
+{
+    visitCells([this, &fn](uint32_t index, size_t position)
+               {
+                   fn(const_cast<const value_type&>(m_cells[index].keyValPair()), position);
+               }, threads);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Pred>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::erase_if(Pred &&pred, size_t threads)
+{
+    static_assert(!IS_RING, "erase_if is not available in ring order");
+    size_t erased = 0;
+    if(threads <= 1)
+    {
+        size_t position = 0;
+        for(uint32_t index = m_queue.m_head; index != npos; position++)
+        {
+            const uint32_t next = m_cells[index].m_next;
+            if(pred(const_cast<const value_type&>(m_cells[index].keyValPair()), position))
+            {
+                eraseCell(index);
+                this->count(&FIFOHashMapStatistics::m_erasures);
+                erased++;
+            }
+            index = next;
+        }
+        return erased;
+    }
+    /*The predicate runs on the threads, the erasing does not - it changes the buckets and the list*/
+    std::vector<uint8_t> doomed(m_cells.size(), 0);
+    visitCells([this, &pred, &doomed](uint32_t index, size_t position)
+               {
+                   doomed[index] = pred(const_cast<const value_type&>(m_cells[index].keyValPair()), position) ? 1 : 0;
+               }, threads);
+    for(size_t index = 0; index < doomed.size(); index++)
+    {
+        if(doomed[index] != 0)
+        {
+            eraseCell(static_cast<uint32_t>(index));
+            this->count(&FIFOHashMapStatistics::m_erasures);
+            erased++;
+        }
+    }
+    return erased;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap::FIFOHashMapIterator
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::find(const K &key)
+{
+    return findKey(key, hashKey(key));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap::FIFOHashMapIterator
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::find(const K &key, size_t hash)
+{
+    return findKey(key, mixHash(hash));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap::FIFOHashMapIterator
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::find(const KeyLike &key)
+{
+    return findKey(key, hashKey(key));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::find_batch(const K *keys, size_t count,
+                                                                             FIFOHashMapIterator *results)
+{
+    lookupBatch(keys, count, [this, results](size_t index, uint32_t cellIndex)
+    {
+        if(cellIndex != npos)
+        {
+            accessCell(cellIndex);
+        }
+        results[index] = FIFOHashMapIterator{cellIndex, this};
+    });
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::contains_batch(const K *keys, size_t count,
+                                                                                   uint64_t *found)
+{
+    std::fill(found, found + (count + 63) / 64, 0);
+    size_t total = 0;
+    lookupBatch(keys, count, [found, &total](size_t index, uint32_t cellIndex)
+    {
+        if(cellIndex != npos)
+        {
+            found[index / 64] |= uint64_t(1) << (index % 64);
+            total++;
+        }
+    });
+    return total;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::pop()
+{
+    if(m_size != 0)
+    {
+        evictHead(FIFOHashMapDiscardEvicted{});
+        this->count(&FIFOHashMapStatistics::m_pops);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+bool FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::pop(std::pair<K, V> &oldest)
+{
+    if(m_size == 0)
+    {
+        return false;
+    }
+    evictHead([&oldest](K &&key, V &&mapped)
+              {
+                  oldest.first = std::move(key);
+                  oldest.second = std::move(mapped);
+              });
+    this->count(&FIFOHashMapStatistics::m_pops);
+    return true;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class OutputIt>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::drain(size_t count, OutputIt out)
+{
+    const size_t popped = (count < m_size) ? count : m_size;
+    for(size_t i = 0; i < popped; i++)
+    {
+        evictHead([&out](K &&key, V &&mapped)
+                  {
+                      *out = std::pair<K, V>(std::move(key), std::move(mapped));
+                      ++out;
+                  });
+        this->count(&FIFOHashMapStatistics::m_pops);
+    }
+    return popped;
+}
+
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveElementToTail(const K &key)
+{
+    moveKeyToTail(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveElementToTail(const KeyLike &key)
+{
+    moveKeyToTail(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveElementToHead(const K &key)
+{
+    moveKeyToHead(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveElementToHead(const KeyLike &key)
+{
+    moveKeyToHead(key);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+bool FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::isFull() const
+{
+    return (m_size >= capacity());
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::set_capacity(size_t capacity)
+{
+    static_assert(DYNAMIC, "Only a runtime-capacity FIFOHashMap (N = FIFOHashMapDynamicCapacity) can change its capacity");
+    validCapacity(capacity);
+    if(m_cells.empty())
+    {
+        /*Moved from - the storage is allocated with the new capacity when it is needed*/
+        this->m_capacity = capacity;
+        this->m_groupMask = FIFOHashMapGroupCount(capacity, MaxLoad::percent) - 1;
+    }
+    else if(capacity < this->m_capacity)
+    {
+        shrinkTo(capacity);
+    }
+    else if(capacity > this->m_capacity)
+    {
+        growTo(capacity);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::memory_usage() const
+{
+    size_t bucketUsage = m_buckets.memory_usage();
+    if constexpr (DYNAMIC)
+    {
+        bucketUsage += this->m_oldBuckets.memory_usage();
+    }
+    return sizeof(*this) + m_cells.capacity() * sizeof(Cell) + bucketUsage;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+double FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::bytes_per_entry() const
+{
+    return static_cast<double>(memory_usage()) / capacity();
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+FIFOHashMapStatistics FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::stats() const
+{
+    static_assert(STATS, "stats() needs the FIFOHashMapStats policy");
+    return this->m_stats;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::reset_stats()
+{
+    static_assert(STATS, "reset_stats() needs the FIFOHashMapStats policy");
+    this->m_stats = FIFOHashMapStatistics{};
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Aggregate>
+auto FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::aggregate()
+{
+    static_assert(AGGREGATES, "aggregate() needs the FIFOHashMapAggregates policy");
+    this->settleAggregates();
+    auto &state = this->template aggregateState<Aggregate>();
+    if(!state.valid())
+    {
+        state.reset();
+        for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+        {
+            state.insert(index, Aggregate::lift(m_cells[index].keyValPair().second));
+        }
+    }
+    return FIFOHashMapAggregateResult<Aggregate>(state.total(), 0);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::refresh_aggregates()
+{
+    static_assert(AGGREGATES, "refresh_aggregates() needs the FIFOHashMapAggregates policy");
+    this->invalidateAggregates();
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::set_ttl(typename clock_type::duration ttl)
+{
+    static_assert(EXPIRY, "set_ttl() needs the FIFOHashMapExpiry policy");
+    this->m_ttl = ttl;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::clock_type::duration FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::ttl() const
+{
+    static_assert(EXPIRY, "ttl() needs the FIFOHashMapExpiry policy");
+    return this->m_ttl;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::clock_type& FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::clock()
+{
+    static_assert(EXPIRY, "clock() needs the FIFOHashMapExpiry policy");
+    return this->m_clock;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::expire(typename clock_type::time_point now)
+{
+    return expireHead(now, FIFOHashMapDiscardEvicted{});
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class OutputIt>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::expire(typename clock_type::time_point now, OutputIt out)
+{
+    return expireHead(now, [&out](K &&key, V &&mapped)
+                      {
+                          *out = std::pair<K, V>(std::move(key), std::move(mapped));
+                          ++out;
+                      });
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Consumer>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::expireHead(typename clock_type::time_point now, Consumer &&consumer)
+{
+    static_assert(EXPIRY, "expire() needs the FIFOHashMapExpiry policy");
+    size_t expired = 0;
+    while((m_size != 0) && this->isExpired(headIndex(), now))
+    {
+        evictHead(consumer);
+        expired++;
+    }
+    this->count(&FIFOHashMapStatistics::m_expirations, expired);
+    return expired;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::save(const std::string &path) const
+{
+    const std::string temporary = path + ".tmp";
+    {
+        FIFOHashMapSnapshotWriter writer(temporary);
+        FIFOHashMapSnapshotHeader header{};
+        std::memcpy(header.m_magic, FIFOHashMapSnapshotHeader::MAGIC, sizeof(header.m_magic));
+        header.m_version = FIFOHashMapSnapshotHeader::VERSION;
+        header.m_keySize = sizeof(K);
+        header.m_valueSize = sizeof(V);
+        header.m_count = m_size;
+        writer.write(&header, sizeof(header));
+        for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+        {
+            const value_type &pair = m_cells[index].keyValPair();
+            FIFOHashMapSerializer<K>::write(writer, pair.first);
+            FIFOHashMapSerializer<V>::write(writer, pair.second);
+        }
+        writer.close();
+    }
+    if(std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("FIFOHashMap snapshot: can not replace " + path);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::load(const std::string &path)
+{
+    FIFOHashMapSnapshotReader reader(path);
+    FIFOHashMapSnapshotHeader header;
+    reader.read(&header, sizeof(header));
+    if((std::memcmp(header.m_magic, FIFOHashMapSnapshotHeader::MAGIC, sizeof(header.m_magic)) != 0) ||
+       (header.m_version != FIFOHashMapSnapshotHeader::VERSION))
+    {
+        throw std::runtime_error("FIFOHashMap snapshot: " + path + " is not a snapshot");
+    }
+    if((header.m_keySize != sizeof(K)) || (header.m_valueSize != sizeof(V)))
+    {
+        throw std::runtime_error("FIFOHashMap snapshot: " + path + " holds other key or value types");
+    }
+
+    clear();
+    finishMigration();
+    ensureStorage();
+    /*The oldest elements that do not fit are read past*/
+    const uint64_t skipped = (header.m_count > capacity()) ? header.m_count - capacity() : 0;
+    for(uint64_t i = 0; i < header.m_count; i++)
+    {
+        K key = FIFOHashMapSerializer<K>::read(reader);
+        V value = FIFOHashMapSerializer<V>::read(reader);
+        if(i >= skipped)
+        {
+            /*The keys of a snapshot are unique - each goes straight to the first empty bucket of its probe sequence*/
+            const uint32_t hash = hashKey(key);
+            insertNew(FIFOHashMapDiscardEvicted{}, hash, findEmpty(m_buckets, this->groupMask(), hash),
+                      std::move(key), std::move(value));
+        }
+    }
+}
+
+/********************************************************************************/
+/*FIFOHashMap - private*/
+/********************************************************************************/
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::validCapacity(size_t capacity)
+{
+    if((capacity == 0) || (capacity >= npos))
+    {
+        throw std::invalid_argument("FIFOHashMap capacity must be in [1, 2^32 - 1)");
+    }
+    return capacity;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::mixHash(size_t hash)
+{
+    return FIFOHashMapMixHash(hash);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::hashKey(const K &key) const
+{
+    return mixHash(m_hasher(key));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike, typename std::enable_if<FIFOHashMapIsHeterogeneousKey<KeyLike, K, Hash, KeyEqual>::value, int>::type>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::hashKey(const KeyLike &key) const
+{
+    /*A transparent hash hashes key as it hashes the K equal to it*/
+    return mixHash(m_hasher(key));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::probeTable(const Buckets &buckets, size_t groupMask,
+                                                                               const KeyLike &key, uint32_t hash) const
+{
+    /*Linear probing, a group at a time: a key is in its home group, or in a later one if all the groups in between
+     *are full. There are always empty buckets, so the probe sequence ends at a group with an empty bucket.
+     *A miss returns that empty bucket - the place to insert the key.*/
+    const uint8_t tag = Group::tag(hash);
+    for(size_t groupIndex = hash & groupMask; ; groupIndex = (groupIndex + 1) & groupMask)
+    {
+        const Group &group = buckets.group(groupIndex);
+        for(uint32_t candidates = group.match(tag); candidates != 0; candidates &= candidates - 1)
+        {
+            const uint32_t position = FIFOHashMapLowestBit(candidates);
+            const FIFOHashMapBucket &current = group.m_buckets[position];
+            if((current.m_hash == hash) && m_keyEqual(m_cells[current.m_cell].keyValPair().first, key))
+            {
+                return Buckets::index(groupIndex, position);
+            }
+        }
+        const uint32_t empty = group.matchEmpty();
+        if(empty != 0)
+        {
+            return Buckets::index(groupIndex, FIFOHashMapLowestBit(empty));
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::findCell(const Buckets &buckets, size_t groupMask,
+                                                                             uint32_t hash, uint32_t cellIndex)
+{
+    /*Same probe sequence as probeTable, but the bucket is told apart by the cell index - no key is compared.
+     *If the cell is not in this array, returns the empty bucket that ended the probe.*/
+    const uint8_t tag = Group::tag(hash);
+    for(size_t groupIndex = hash & groupMask; ; groupIndex = (groupIndex + 1) & groupMask)
+    {
+        const Group &group = buckets.group(groupIndex);
+        for(uint32_t candidates = group.match(tag); candidates != 0; candidates &= candidates - 1)
+        {
+            const uint32_t position = FIFOHashMapLowestBit(candidates);
+            if(group.m_buckets[position].m_cell == cellIndex)
+            {
+                return Buckets::index(groupIndex, position);
+            }
+        }
+        const uint32_t empty = group.matchEmpty();
+        if(empty != 0)
+        {
+            return Buckets::index(groupIndex, FIFOHashMapLowestBit(empty));
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::probeBucket(const KeyLike &key, uint32_t hash)
+{
+    ensureStorage();
+    if constexpr (DYNAMIC)
+    {
+        if(this->isMigrating())
+        {
+            const size_t bucket = probeMigrating(key, hash);
+            countProbe(hash, bucket);
+            return dropExpired(key, hash, bucket);
+        }
+    }
+    const size_t bucket = probeTable(m_buckets, this->groupMask(), key, hash);
+    countProbe(hash, bucket);
+    return dropExpired(key, hash, bucket);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::dropExpired(const KeyLike &key, uint32_t hash, size_t bucket)
+{
+    if constexpr (EXPIRY)
+    {
+        /*An expired element is removed when it is found, and the key probed again for the bucket it now ends at*/
+        const uint32_t cellIndex = m_buckets[bucket].m_cell;
+        if((cellIndex != npos) && this->isExpired(cellIndex, this->m_clock.now()))
+        {
+            expireCell(cellIndex);
+            return probeBucket(key, hash);
+        }
+    }
+    return bucket;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMap::FIFOHashMapIterator
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::findKey(const KeyLike &key, uint32_t hash)
+{
+    /*An empty bucket holds npos, which is also the end() index*/
+    const size_t bucket = probeBucket(key, hash);
+    this->count((m_buckets[bucket].m_cell != npos) ? &FIFOHashMapStatistics::m_hits : &FIFOHashMapStatistics::m_misses);
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        accessCell(m_buckets[bucket].m_cell);
+    }
+    return FIFOHashMap::FIFOHashMapIterator{m_buckets[bucket].m_cell, this};
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::eraseKey(const KeyLike &key)
+{
+    static_assert(!IS_RING, "erase is not available in ring order");
+    const size_t bucket = probeBucket(key, hashKey(key));
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        eraseCell(m_buckets[bucket].m_cell);
+        this->count(&FIFOHashMapStatistics::m_erasures);
+        return 1;
+    }
+    return 0;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveKeyToTail(const KeyLike &key)
+{
+    static_assert(!IS_RING, "moveElementToTail is not available in ring order");
+    const size_t bucket = probeBucket(key, hashKey(key));
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        const uint32_t index = m_buckets[bucket].m_cell;
+        m_queue.removeCell(m_cells.data(), index);
+        m_queue.addLast(m_cells.data(), index);
+        this->count(&FIFOHashMapStatistics::m_movesToTail);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::moveKeyToHead(const KeyLike &key)
+{
+    static_assert(!IS_RING, "moveElementToHead is not available in ring order");
+    const size_t bucket = probeBucket(key, hashKey(key));
+    if(m_buckets[bucket].m_cell != npos)
+    {
+        const uint32_t index = m_buckets[bucket].m_cell;
+        m_queue.removeCell(m_cells.data(), index);
+        m_queue.addFirst(m_cells.data(), index);
+        this->count(&FIFOHashMapStatistics::m_movesToHead);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::expireCell(uint32_t cellIndex)
+{
+    if constexpr (IS_RING)
+    {
+        /*Cells of a ring can only leave from the head - the ones before this cell are older, so expired too*/
+        uint32_t head;
+        do
+        {
+            head = m_queue.m_head;
+            evictHead(FIFOHashMapDiscardEvicted{});
+            this->count(&FIFOHashMapStatistics::m_expirations);
+        } while(head != cellIndex);
+    }
+    else
+    {
+        eraseCell(cellIndex);
+        this->count(&FIFOHashMapStatistics::m_expirations);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Resolve>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::lookupBatch(const K *keys, size_t count,
+                                                                              Resolve &&resolve)
+{
+    ensureStorage();
+    if constexpr (DYNAMIC)
+    {
+        if(this->isMigrating())
+        {
+            /*Every lookup moves buckets while migrating - one at a time*/
+            for(size_t i = 0; i < count; i++)
+            {
+                const uint32_t cellIndex = m_buckets[probeBucket(keys[i], hashKey(keys[i]))].m_cell;
+                this->count((cellIndex != npos) ? &FIFOHashMapStatistics::m_hits : &FIFOHashMapStatistics::m_misses);
+                resolve(i, cellIndex);
+            }
+            return;
+        }
+    }
+
+    const size_t groupMask = this->groupMask();
+    uint32_t hashes[LOOKUP_CHUNK];
+    for(size_t start = 0; start < count; start += LOOKUP_CHUNK)
+    {
+        const K *chunkKeys = keys + start;
+        const size_t chunk = std::min(LOOKUP_CHUNK, count - start);
+        /*A loop of its own, with no memory access but the keys - the compiler vectorizes it for integer keys.
+         *A constant trip count for full chunks lets it do so at -O2 too.*/
+        if(chunk == LOOKUP_CHUNK)
+        {
+            for(size_t i = 0; i < LOOKUP_CHUNK; i++)
+            {
+                hashes[i] = hashKey(chunkKeys[i]);
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < chunk; i++)
+            {
+                hashes[i] = hashKey(chunkKeys[i]);
+            }
+        }
+        for(size_t i = 0; i < chunk; i++)
+        {
+            m_buckets.prefetch(hashes[i] & groupMask);
+        }
+        for(size_t i = 0; i < chunk; i++)
+        {
+            size_t bucket = probeTable(m_buckets, groupMask, chunkKeys[i], hashes[i]);
+            countProbe(hashes[i], bucket);
+            bucket = dropExpired(chunkKeys[i], hashes[i], bucket);
+            this->count((m_buckets[bucket].m_cell != npos) ? &FIFOHashMapStatistics::m_hits : &FIFOHashMapStatistics::m_misses);
+            resolve(start + i, m_buckets[bucket].m_cell);
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyLike>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::probeMigrating(const KeyLike &key, uint32_t hash)
+{
+    migrateStep();
+    const size_t bucket = probeTable(m_buckets, this->groupMask(), key, hash);
+    if((m_buckets[bucket].m_cell != npos) || !this->isMigrating())
+    {
+        return bucket;
+    }
+
+    /*Not found in the new array - if the key is still in the old one, move it to the empty bucket that ended the probe*/
+    const size_t oldMask = this->m_oldBuckets.groupCount() - 1;
+    const size_t oldBucket = probeTable(this->m_oldBuckets, oldMask, key, hash);
+    if(this->m_oldBuckets[oldBucket].m_cell != npos)
+    {
+        m_buckets.set(bucket, this->m_oldBuckets[oldBucket]);
+        shiftBuckets(this->m_oldBuckets, oldMask, oldBucket);
+    }
+    return bucket;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::shiftBuckets(Buckets &buckets, size_t groupMask,
+                                                                                 size_t hole)
+{
+    /*Backward shift deletion - no tombstones, so probe sequences never grow with churn.
+     *A key past its home group relies on all the groups in between being full. The hole is refilled with such a key
+     *from a following group, which moves the hole there, until a group that already had an empty bucket.*/
+    size_t holeGroup = Buckets::groupOf(hole);
+    /*Usually the group of the hole already had an empty bucket - then no key probes past it, and nothing moves*/
+    const bool wasFull = (buckets.group(holeGroup).matchEmpty() == 0);
+    for(size_t groupIndex = (holeGroup + 1) & groupMask; wasFull && (groupIndex != holeGroup);
+        groupIndex = (groupIndex + 1) & groupMask)
+    {
+        const Group &group = buckets.group(groupIndex);
+        const bool hadEmpty = (group.matchEmpty() != 0);
+        for(uint32_t occupied = ~group.matchEmpty() & Group::ALL; occupied != 0; occupied &= occupied - 1)
+        {
+            const uint32_t position = FIFOHashMapLowestBit(occupied);
+            const size_t home = group.m_buckets[position].m_hash & groupMask;
+            if(((groupIndex - home) & groupMask) >= ((groupIndex - holeGroup) & groupMask))
+            {
+                //The hole is on the probe path of this key - move it back.
+                buckets.set(hole, group.m_buckets[position]);
+                hole = Buckets::index(groupIndex, position);
+                holeGroup = groupIndex;
+                break;
+            }
+        }
+        if(hadEmpty)
+        {
+            break;
+        }
+    }
+    buckets.clear(hole);
+    return hole;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::placeBucket(Buckets &buckets, size_t groupMask,
+                                                                              FIFOHashMapBucket bucket)
+{
+    /*The key is known not to be in the array*/
+    buckets.set(findEmpty(buckets, groupMask, bucket.m_hash), bucket);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::findEmpty(const Buckets &buckets, size_t groupMask, uint32_t hash)
+{
+    /*The first empty bucket in the first group of the probe sequence that has one*/
+    size_t groupIndex = hash & groupMask;
+    while(buckets.group(groupIndex).matchEmpty() == 0)
+    {
+        groupIndex = (groupIndex + 1) & groupMask;
+    }
+    return Buckets::index(groupIndex, FIFOHashMapLowestBit(buckets.group(groupIndex).matchEmpty()));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::eraseBucket(uint32_t hash, uint32_t cellIndex)
+{
+    const size_t groupMask = this->groupMask();
+    const size_t hole = findCell(m_buckets, groupMask, hash, cellIndex);
+    if constexpr (DYNAMIC)
+    {
+        if(m_buckets[hole].m_cell == npos)
+        {
+            /*Not migrated yet*/
+            const size_t oldMask = this->m_oldBuckets.groupCount() - 1;
+            shiftBuckets(this->m_oldBuckets, oldMask, findCell(this->m_oldBuckets, oldMask, hash, cellIndex));
+            return NO_BUCKET;
+        }
+    }
+    return shiftBuckets(m_buckets, groupMask, hole);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::migrateStep()
+{
+    if constexpr (DYNAMIC)
+    {
+        const size_t oldMask = this->m_oldBuckets.groupCount() - 1;
+        for(size_t scanned = 1; this->m_migrateRemaining != 0; scanned++)
+        {
+            const Group &group = this->m_oldBuckets.group(this->m_migrateCursor);
+            const bool hadEmpty = (group.matchEmpty() != 0);
+            for(uint32_t occupied = ~group.matchEmpty() & Group::ALL; occupied != 0; occupied &= occupied - 1)
+            {
+                const size_t bucket = Buckets::index(this->m_migrateCursor, FIFOHashMapLowestBit(occupied));
+                placeBucket(m_buckets, this->groupMask(), this->m_oldBuckets[bucket]);
+                this->m_oldBuckets.clear(bucket);
+            }
+            this->m_migrateCursor = (this->m_migrateCursor + 1) & oldMask;
+            this->m_migrateRemaining--;
+            /*Stop only after a group that had an empty bucket - no key left in the old array was probing past it*/
+            if(hadEmpty && (scanned >= MIGRATION_STEP))
+            {
+                break;
+            }
+        }
+        if(this->m_migrateRemaining == 0)
+        {
+            Buckets(m_buckets.get_allocator()).swap(this->m_oldBuckets);
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::finishMigration()
+{
+    if constexpr (DYNAMIC)
+    {
+        while(this->isMigrating())
+        {
+            migrateStep();
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::relocateCell(Cell &from, Cell &to)
+{
+    /*Like a node handle, the key is moved too - the source pair is destroyed right after*/
+    std::pair<K, V> &moved = from.mutableKeyValPair();
+    constructPair(to, std::move(moved.first), std::move(moved.second));
+    destroyPair(from);
+    to.m_hash = from.m_hash;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::constructPair(Cell &cell, Args&&... args)
+{
+    /*Through the allocator, which passes itself on to the key and the value if they use one*/
+    CellAllocator allocator(m_cells.get_allocator());
+    std::allocator_traits<CellAllocator>::construct(allocator, &cell.m_mutableKeyValPair, std::forward<Args>(args)...);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::destroyPair(Cell &cell)
+{
+    CellAllocator allocator(m_cells.get_allocator());
+    std::allocator_traits<CellAllocator>::destroy(allocator, &cell.m_mutableKeyValPair);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::retargetBucket(uint32_t cellIndex, uint32_t target)
+{
+    m_buckets.setCell(findCell(m_buckets, this->groupMask(), m_cells[cellIndex].m_hash, cellIndex), target);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::shrinkTo(size_t capacity)
+{
+    /*The bucket arrays are rebuilt from the cells, so the evicted elements are dropped without touching them*/
+    try
+    {
+        while(m_size > capacity)
+        {
+            EvictionOrder order(*this);
+            const uint32_t index = IS_RING ? headIndex() : m_evictionPolicy.victim(order);
+            std::pair<K, V> &evicted = m_cells[index].mutableKeyValPair();
+            m_evictionSink(std::move(evicted.first), std::move(evicted.second));
+            if constexpr (IS_RING)
+            {
+                destroyPair(m_cells[index]);
+                m_queue.m_head = (index + 1 == this->m_capacity) ? 0 : index + 1;
+            }
+            else
+            {
+                m_evictionPolicy.on_erase(order, index);
+                destroyPair(m_cells[index]);
+                m_queue.removeCell(m_cells.data(), index);
+            }
+            m_size--;
+            this->count(&FIFOHashMapStatistics::m_evictions);
+        }
+    }
+    catch(...)
+    {
+        /*The sink threw - keep the capacity, but the buckets of the dropped elements have to go*/
+        rebuild(this->m_capacity);
+        throw;
+    }
+    rebuild(capacity);
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::rebuild(size_t capacity)
+{
+    /*Moves the elements in FIFO order to the start of new arrays and indexes them with their cached hashes*/
+    std::vector<Cell, CellAllocator> cells(capacity, m_cells.get_allocator());
+    Buckets buckets(FIFOHashMapGroupCount(capacity, MaxLoad::percent), m_buckets.get_allocator());
+    const size_t groupMask = buckets.groupCount() - 1;
+    uint32_t position = 0;
+    for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+    {
+        relocateCell(m_cells[index], cells[position]);
+        placeBucket(buckets, groupMask, FIFOHashMapBucket{cells[position].m_hash, position});
+        position++;
+    }
+    if constexpr (EXPIRY)
+    {
+        decltype(this->m_insertedAt) insertedAt(capacity, {}, this->m_insertedAt.get_allocator());
+        position = 0;
+        for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+        {
+            insertedAt[position++] = this->m_insertedAt[index];
+        }
+        this->m_insertedAt.swap(insertedAt);
+    }
+
+    m_cells.swap(cells);
+    m_buckets.swap(buckets);
+    Buckets(m_buckets.get_allocator()).swap(this->m_oldBuckets);
+    /*Elements were dropped without going through eraseCell, and the rest renumbered*/
+    this->invalidateAggregates();
+    this->m_migrateRemaining = 0;
+    this->m_capacity = capacity;
+    this->m_groupMask = groupMask;
+
+    if constexpr (IS_RING)
+    {
+        m_queue.m_head = 0;
+    }
+    else
+    {
+        m_queue = FIFOHashMapQueue{};
+        for(uint32_t index = 0; index < m_size; index++)
+        {
+            m_queue.addLast(m_cells.data(), index);
+        }
+        for(uint32_t index = static_cast<uint32_t>(m_size); index < capacity; index++)
+        {
+            m_cells[index].m_next = (index + 1 < capacity) ? index + 1 : npos;
+        }
+        m_freeHead = (m_size < capacity) ? static_cast<uint32_t>(m_size) : npos;
+        EvictionOrder order(*this);
+        m_evictionPolicy.on_rebuild(order);
+    }
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::growTo(size_t capacity)
+{
+    finishMigration();
+    /*The values are about to move*/
+    this->settleAggregates();
+    const size_t oldCapacity = this->m_capacity;
+    std::vector<Cell, CellAllocator> cells(capacity, m_cells.get_allocator());
+
+    if constexpr (IS_RING)
+    {
+        /*Elements keep their indices, unless the ring wraps around the end of the old array:
+         *then the shorter part is moved so the elements are contiguous (modulo the new capacity) again,
+         *and the buckets of the moved elements are updated.*/
+        const size_t head = m_queue.m_head;
+        const size_t wrapped = (head + m_size > oldCapacity) ? head + m_size - oldCapacity : 0;
+        const size_t tailPart = oldCapacity - head;
+        const bool moveWrapped = (wrapped != 0) && (wrapped <= tailPart) && (oldCapacity + wrapped <= capacity);
+        const bool moveTail = (wrapped != 0) && !moveWrapped;
+        const size_t newHead = moveTail ? capacity - tailPart : head;
+        auto target = [&](uint32_t index)
+        {
+            if(moveWrapped && (index < head))
+            {
+                return static_cast<uint32_t>(oldCapacity + index);
+            }
+            if(moveTail && (index >= head))
+            {
+                return static_cast<uint32_t>(newHead + (index - head));
+            }
+            return index;
+        };
+
+        /*The buckets are updated first, while the cells still have their hashes.
+         *The targets of the tail part are above their sources, so going down a bucket that was already updated
+         *can not be mistaken for one that was not.*/
+        if(moveWrapped)
+        {
+            for(uint32_t index = 0; index < wrapped; index++)
+            {
+                retargetBucket(index, target(index));
+            }
+        }
+        if(moveTail)
+        {
+            for(uint32_t index = static_cast<uint32_t>(oldCapacity); index-- > head;)
+            {
+                retargetBucket(index, target(index));
+            }
+        }
+        for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+        {
+            relocateCell(m_cells[index], cells[target(index)]);
+        }
+        if constexpr (EXPIRY)
+        {
+            decltype(this->m_insertedAt) insertedAt(capacity, {}, this->m_insertedAt.get_allocator());
+            for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+            {
+                insertedAt[target(index)] = this->m_insertedAt[index];
+            }
+            this->m_insertedAt.swap(insertedAt);
+        }
+        m_queue.m_head = static_cast<uint32_t>(newHead);
+        /*Renumbered*/
+        this->invalidateAggregates();
+    }
+    else
+    {
+        /*Elements keep their indices, so the links and the buckets stay valid*/
+        for(uint32_t index = 0; index < oldCapacity; index++)
+        {
+            cells[index].m_next = m_cells[index].m_next;
+            cells[index].m_prev = m_cells[index].m_prev;
+        }
+        for(uint32_t index = headIndex(); index != npos; index = nextIndex(index))
+        {
+            relocateCell(m_cells[index], cells[index]);
+        }
+        for(uint32_t index = static_cast<uint32_t>(oldCapacity); index < capacity; index++)
+        {
+            cells[index].m_next = (index + 1 < capacity) ? index + 1 : m_freeHead;
+        }
+        m_freeHead = static_cast<uint32_t>(oldCapacity);
+        if constexpr (EXPIRY)
+        {
+            this->m_insertedAt.resize(capacity);
+        }
+    }
+    m_cells.swap(cells);
+    this->m_capacity = capacity;
+    this->reserveAggregates(capacity);
 
-    size_t size() const
+    const size_t groupCount = FIFOHashMapGroupCount(capacity, MaxLoad::percent);
+    if(groupCount > m_buckets.groupCount())
     {
-        return m_size;
+        /*The entries are moved to the new bucket array by the following operations, see migrateStep.
+         *The migration starts right after a group with an empty bucket, so no probe sequence is split by the wrap around.*/
+        size_t start = 0;
+        while(m_buckets.group(start).matchEmpty() == 0)
+        {
+            start++;
+        }
+        this->m_oldBuckets.swap(m_buckets);
+        Buckets(groupCount, m_buckets.get_allocator()).swap(m_buckets);
+        this->m_groupMask = groupCount - 1;
+        this->m_migrateCursor = (start + 1) & (this->m_oldBuckets.groupCount() - 1);
+        this->m_migrateRemaining = this->m_oldBuckets.groupCount();
     }
+}
 
-    bool empty() const
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::emplaceHashed(const K &key, uint32_t hash, Args&&... args)
+{
+    const size_t bucket = probeBucket(key, hash);
+    if(m_buckets[bucket].m_cell != npos)
     {
-        return (m_size == 0);
+        /*Element exist*/
+        this->count(&FIFOHashMapStatistics::m_duplicates);
+        return std::make_pair(FIFOHashMapIterator{m_buckets[bucket].m_cell, this}, false);
     }
+    /*New element - the pair is constructed directly in its cell*/
+    const uint32_t index = insertNew(m_evictionSink, hash, bucket, std::forward<Args>(args)...);
+    return std::make_pair(FIFOHashMapIterator{index, this}, true);
+}
 
-    bool isFull() const;
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class KeyArg, class ValueArg, typename std::enable_if<std::is_same<typename std::decay<KeyArg>::type, K>::value, int>::type>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::emplaceImpl(KeyArg &&key, ValueArg &&value)
+{
+    const uint32_t hash = hashKey(key);
+    return emplaceHashed(key, hash, std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+}
 
-    /**
-     *
-     * @return Iterator to the first element.
-     */
-    FIFOHashMapIterator begin()
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Pair, typename std::enable_if<FIFOHashMapIsKeyedPair<typename std::decay<Pair>::type, K>::value, int>::type>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::emplaceImpl(Pair &&pair)
+{
+    const uint32_t hash = hashKey(pair.first);
+    return emplaceHashed(pair.first, hash, std::forward<Pair>(pair));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+std::pair<typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIterator, bool>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::emplaceImpl(Args&&... args)
+{
+    /*The key is only known once the pair is built*/
+    value_type value(std::forward<Args>(args)...);
+    const uint32_t hash = hashKey(value.first);
+    return emplaceHashed(value.first, hash, std::move(value));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Consumer, class... Args>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::insertNew(Consumer &&onEvict, uint32_t hash,
+                                                                                size_t bucket, Args&&... args)
+{
+    if(m_size >= capacity())
     {
-        return FIFOHashMapIterator{m_queue.m_pHead, &m_map};
+        /*An evicted element that is only destroyed is overwritten instead*/
+        if constexpr (std::is_same<typename std::decay<Consumer>::type, FIFOHashMapDiscardEvicted>::value &&
+                      FIFOHashMapCanRecycle<FIFOHashMapRecycler<K, V>, std::tuple<Args&&...>>::value)
+        {
+            return recycleVictim(hash, bucket, std::forward<Args>(args)...);
+        }
+        else
+        {
+            /*If table is full - pop the first one*/
+            const size_t freedBucket = evictVictim(onEvict);
+            this->count(&FIFOHashMapStatistics::m_evictions);
+            bucket = nearerBucket(hash, bucket, freedBucket);
+        }
     }
-    /**
-     *
-     * @return Iterator to the element following the last element.
-     */
-    FIFOHashMapIterator end()
+
+    uint32_t index;
+    if constexpr (IS_RING)
     {
-        return FIFOHashMapIterator{nullptr, &m_map};
+        const size_t position = m_queue.m_head + m_size;
+        index = static_cast<uint32_t>((position >= capacity()) ? position - capacity() : position);
     }
-    /**
-     *
-     * @return Returns a reverse iterator to the first element of the reversed queue.
-     * It corresponds to the last element of the non-reversed queue.
-     * If the vector is queue, the returned iterator is equal to rend().
-     */
-    FIFOHashMapIterator rbegin()
+    else
     {
-        return FIFOHashMapIterator{m_queue.m_pTail, &m_map, true};
+        index = m_freeHead;
     }
-    /**
-     *
-     * @return Returns a reverse iterator to the element following the last element of the reversed vector.
-     * It corresponds to the element preceding the first element of the non-reversed queue.
-     * This element acts as a placeholder, attempting to access it results in undefined behavior.
-     */
-    FIFOHashMapIterator rend()
+
+    Cell &cell = m_cells[index];
+    constructPair(cell, std::forward<Args>(args)...);
+    this->insertAggregated(index, cell.keyValPair().second);
+    cell.m_hash = hash;
+    if constexpr (EXPIRY)
     {
-        return FIFOHashMapIterator{nullptr, &m_map, true};
+        this->m_insertedAt[index] = this->m_clock.now();
+    }
+    if constexpr (!IS_RING)
+    {
+        m_freeHead = cell.m_next;
+        m_queue.addLast(m_cells.data(), index);
+        EvictionOrder order(*this);
+        m_evictionPolicy.on_insert(order, index);
     }
 
-};
-
-/*FIFOHashMap*/
-
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMap():m_map{}, m_queue{},m_size{0} {
-    m_map.reserve(N);
+    m_buckets.set(bucket, FIFOHashMapBucket{hash, index});
+    m_size++;
+    this->count(&FIFOHashMapStatistics::m_insertions);
+    return index;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMap(std::initializer_list<std::pair<const K, V>> initList):m_map{}, m_queue{}, m_size{0}
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class... Args>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::recycleVictim(uint32_t hash, size_t bucket,
+                                                                                    Args&&... args)
 {
-    m_map.reserve(N);
-    for (const auto &p: initList)
+    /*The new element is assigned over the one evicted, in the same cell, so the key and the value keep their
+     *storage - a full map of strings no longer frees a buffer and allocates another on every insertion.
+     *The cell is then unlinked and indexed again as if it was evicted and inserted.*/
+    EvictionOrder order(*this);
+    const uint32_t index = IS_RING ? m_queue.m_head : m_evictionPolicy.victim(order);
+    Cell &cell = m_cells[index];
+    const Lifted lifted = this->liftAggregates(cell.keyValPair().second);
+    try
+    {
+        FIFOHashMapRecycler<K, V>::assign(cell.mutableKeyValPair(), std::forward<Args>(args)...);
+    }
+    catch(...)
     {
-        //Insert return a <iterator,bool> pair.
-        auto resultPair = m_map.emplace(p.first,  FIFOHashMapCell<K,V>{p});
-        if(resultPair.second == true)
+        /*Half overwritten - evicted as usual, and the aggregates can no longer tell what it held*/
+        this->invalidateAggregates();
+        if constexpr (IS_RING)
         {
-            if(m_size >= N)
-            {
-                pop();
-            }
-
-            m_queue.addLast(&((resultPair.first)->second));
-            m_size++;
+            evictHead(FIFOHashMapDiscardEvicted{});
+        }
+        else
+        {
+            evictCell(index, FIFOHashMapDiscardEvicted{});
         }
+        this->count(&FIFOHashMapStatistics::m_evictions);
+        throw;
     }
-}
+    this->count(&FIFOHashMapStatistics::m_evictions);
+    this->eraseAggregated(index, lifted);
 
+    if constexpr (IS_RING)
+    {
+        /*The head becomes the tail*/
+        m_queue.m_head = (index + 1 == capacity()) ? 0 : index + 1;
+    }
+    else
+    {
+        m_evictionPolicy.on_erase(order, index);
+        m_queue.removeCell(m_cells.data(), index);
+        m_queue.addLast(m_cells.data(), index);
+    }
+    bucket = nearerBucket(hash, bucket, eraseBucket(cell.m_hash, index));
+    cell.m_hash = hash;
+    if constexpr (EXPIRY)
+    {
+        this->m_insertedAt[index] = this->m_clock.now();
+    }
+    if constexpr (!IS_RING)
+    {
+        m_evictionPolicy.on_insert(order, index);
+    }
+    this->insertAggregated(index, cell.keyValPair().second);
+    m_buckets.set(bucket, FIFOHashMapBucket{hash, index});
+    this->count(&FIFOHashMapStatistics::m_insertions);
+    return index;
+}
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-std::pair<typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator, bool>
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::insert(FIFOHashMap::value_type &&value)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::nearerBucket(uint32_t hash, size_t bucket,
+                                                                                 size_t freedBucket) const
 {
+    /*The bucket of the evicted element is the only new gap in the table: if the gap is on the probe path of the new
+     *key, in a group before the one of the empty bucket that ended the probe, the key belongs there instead.*/
+    const size_t groupMask = this->groupMask();
+    const size_t home = hash & groupMask;
+    const bool isNewGap = !DYNAMIC || (freedBucket != NO_BUCKET);
+    if(isNewGap && (((Buckets::groupOf(freedBucket) - home) & groupMask) <
+                    ((Buckets::groupOf(bucket) - home) & groupMask)))
+    {
+        return freedBucket;
+    }
+    return bucket;
+}
 
-    auto mapIter = m_map.find(value.first);
-    if(mapIter != m_map.end())
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Consumer>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::evictHead(Consumer &&consumer)
+{
+    if constexpr (IS_RING)
     {
-        /*Element exist*/
-        return std::make_pair(FIFOHashMapIterator{&(mapIter->second), &m_map}, false);
+        std::pair<K, V> &oldest = m_cells[m_queue.m_head].mutableKeyValPair();
+        const Lifted lifted = this->liftAggregates(oldest.second);
+        consumer(std::move(oldest.first), std::move(oldest.second));
+
+        /*The cell is left for the next insertion to overwrite*/
+        const uint32_t index = m_queue.m_head;
+        Cell &cell = m_cells[index];
+        this->eraseAggregated(index, lifted);
+        const size_t freedBucket = eraseBucket(cell.m_hash, index);
+        destroyPair(cell);
+        m_queue.m_head = (index + 1 == capacity()) ? 0 : index + 1;
+        m_size--;
+        return freedBucket;
     }
-    /*New element*/
-    if(m_size >= N)
+    else
     {
-        /*If table is full - pop the first one*/
-        pop();
+        return evictCell(m_queue.m_head, consumer);
     }
+}
 
-    auto resultPair = m_map.emplace(value.first,  FIFOHashMapCell<K,V>{std::move(value)});
-    if(resultPair.second == true)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Consumer>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::evictVictim(Consumer &&consumer)
+{
+    if constexpr (IS_RING)
+    {
+        return evictHead(consumer);
+    }
+    else
     {
-        m_queue.addLast(&((resultPair.first)->second));
-        m_size++;
-        return std::make_pair(FIFOHashMapIterator{m_queue.m_pTail, &m_map}, true);
+        EvictionOrder order(*this);
+        return evictCell(m_evictionPolicy.victim(order), consumer);
     }
+}
 
-    return std::make_pair(end(), false);
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Consumer>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::evictCell(uint32_t cellIndex, Consumer &&consumer)
+{
+    /*The pair is destroyed right after the consumer returns, so it may take the key too - like a node handle does.
+     *The map is not modified before that, so if the consumer throws it stays consistent.*/
+    std::pair<K, V> &evicted = m_cells[cellIndex].mutableKeyValPair();
+    const Lifted lifted = this->liftAggregates(evicted.second);
+    consumer(std::move(evicted.first), std::move(evicted.second));
+    return eraseCell(cellIndex, lifted);
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-std::pair<typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator, bool>FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::
-insert(const FIFOHashMap::value_type &value)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::eraseCell(uint32_t cellIndex)
+{
+    return eraseCell(cellIndex, this->liftAggregates(m_cells[cellIndex].keyValPair().second));
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+size_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::eraseCell(uint32_t cellIndex, const Lifted &lifted)
+{
+    this->eraseAggregated(cellIndex, lifted);
+    EvictionOrder order(*this);
+    m_evictionPolicy.on_erase(order, cellIndex);
+    Cell &cell = m_cells[cellIndex];
+    const size_t freedBucket = eraseBucket(cell.m_hash, cellIndex);
+    m_queue.removeCell(m_cells.data(), cellIndex);
+    destroyPair(cell);
+
+    /*Free cells have no previous cell - visitCells tells them apart by it*/
+    cell.m_prev = npos;
+    cell.m_next = m_freeHead;
+    m_freeHead = cellIndex;
+    m_size--;
+    return freedBucket;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class M>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::assignCell(uint32_t cellIndex, M &&obj)
 {
+    V &value = m_cells[cellIndex].keyValPair().second;
+    const Lifted lifted = this->liftAggregates(value);
+    value = std::forward<M>(obj);
+    this->assignAggregated(cellIndex, lifted, value);
+}
 
-    auto mapIter = m_map.find(value.first);
-    if(mapIter != m_map.end())
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::accessCell(uint32_t cellIndex)
+{
+    if constexpr (!IS_RING)
     {
-        /*Element exist*/
-        return std::make_pair(FIFOHashMapIterator{&(mapIter->second), &m_map}, false);
+        EvictionOrder order(*this);
+        m_evictionPolicy.on_access(order, cellIndex);
     }
-    /*New element*/
-    if(m_size >= N)
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::prefetchBucket(uint32_t hash) const
+{
+    m_buckets.prefetch(hash & this->groupMask());
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::countProbe(uint32_t hash, size_t bucket)
+{
+    if constexpr (STATS)
     {
-        /*If table is full - pop the first one*/
-        pop();
+        /*The probe ended in the group of bucket - found or not*/
+        const size_t groupMask = this->groupMask();
+        this->count(&FIFOHashMapStatistics::m_probes);
+        this->count(&FIFOHashMapStatistics::m_probeSteps, ((Buckets::groupOf(bucket) - (hash & groupMask)) & groupMask) + 1);
     }
+}
 
-    auto resultPair = m_map.emplace(value.first,  FIFOHashMapCell<K,V>{value});
-    if(resultPair.second == true)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::allocateStorage(size_t capacity)
+{
+    /*For an empty map without storage - a new one, or one that was moved from. Nothing changes if an allocation throws*/
+    std::vector<Cell, CellAllocator> cells(validCapacity(capacity), m_cells.get_allocator());
+    Buckets buckets(FIFOHashMapGroupCount(capacity, MaxLoad::percent), m_buckets.get_allocator());
+    if constexpr (EXPIRY)
+    {
+        this->m_insertedAt.resize(capacity);
+    }
+    this->reserveAggregates(capacity);
+    m_cells.swap(cells);
+    m_buckets.swap(buckets);
+    if constexpr (DYNAMIC)
+    {
+        this->m_capacity = capacity;
+        this->m_groupMask = m_buckets.groupCount() - 1;
+    }
+    if constexpr (IS_RING)
+    {
+        /*In ring order m_head is the position of the oldest element*/
+        m_queue.m_head = 0;
+    }
+    else
     {
-        m_queue.addLast(&((resultPair.first)->second));
-        m_size++;
-        return std::make_pair(FIFOHashMapIterator{m_queue.m_pTail, &m_map}, true);
+        initFreeList();
     }
+}
 
-    return std::make_pair(end(), false);
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::initFreeList()
+{
+    for(uint32_t index = 0; index < capacity(); index++)
+    {
+        m_cells[index].m_next = (index + 1 < capacity()) ? index + 1 : npos;
+    }
+    m_freeHead = 0;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-V &FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::operator[](K &&key)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::copyElements(const FIFOHashMap &other)
 {
-    auto mapIter = m_map.find(key);
-    if(mapIter == m_map.end())
-    {//New element - need to insert.
-        if(m_size >= N)
+    if constexpr (EXPIRY)
+    {
+        this->m_ttl = other.m_ttl;
+        this->m_clock = other.m_clock;
+    }
+    /*Re-inserting in FIFO order keeps the order of the copy*/
+    for(uint32_t index = other.headIndex(); index != npos; index = other.nextIndex(index))
+    {
+        const uint32_t copied = insert(other.m_cells[index].keyValPair()).first.m_index;
+        if constexpr (EXPIRY)
         {
-            /*If table is full - pop the first one*/
-            pop();
-        }
-        FIFOHashMapCell<K,V> &&newCell{std::move(key), V{}};
-        auto emplaceResultPair = m_map.emplace(newCell.m_key,  std::move(newCell));
-        mapIter = emplaceResultPair.first;
-        if(emplaceResultPair.second == true)
-        {//Insertion succeeded - add it to the end of the list.
-            m_queue.addLast(&((emplaceResultPair.first)->second));
-            m_size++;
-            return mapIter->second.m_value;
+            /*The copies are as old as the originals*/
+            this->m_insertedAt[copied] = other.m_insertedAt[index];
         }
     }
-    return mapIter->second.m_value;
+    if constexpr (STATS)
+    {
+        /*The inserts that made the copy are not operations on it*/
+        this->m_stats = FIFOHashMapStatistics{};
+    }
 }
 
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::headIndex() const
+{
+    if constexpr (IS_RING)
+    {
+        return (m_size == 0) ? npos : m_queue.m_head;
+    }
+    else
+    {
+        return m_queue.m_head;
+    }
+}
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-V &FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::
-operator[](const K &key)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::tailIndex() const
 {
-    auto mapIter = m_map.find(key);
-    if(mapIter == m_map.end())
-    {//New element - need to insert.
-        if(m_size >= N)
+    if constexpr (IS_RING)
+    {
+        if(m_size == 0)
         {
-            /*If table is full - pop the first one*/
-            pop();
-        }
-
-        auto emplaceResultPair = m_map.emplace(key,  FIFOHashMapCell<K,V>{key, V{}});
-        mapIter = emplaceResultPair.first;
-        if(emplaceResultPair.second == true)
-        {//Insertion succeeded - add it to the end of the list.
-            m_queue.addLast(&((emplaceResultPair.first)->second));
-            m_size++;
-            return mapIter->second.m_value;
+            return npos;
         }
+        const size_t position = m_queue.m_head + m_size - 1;
+        return static_cast<uint32_t>((position >= capacity()) ? position - capacity() : position);
+    }
+    else
+    {
+        return m_queue.m_tail;
     }
-    return mapIter->second.m_value;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMap::FIFOHashMapIterator
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::erase(FIFOHashMap::FIFOHashMapIterator pos) {
-    if((pos != end()) && (m_map.erase(pos->first) != 0))
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::nextIndex(uint32_t cellIndex) const
+{
+    if constexpr (IS_RING)
     {
-        m_queue.removeCell(pos.m_pCurrCell);
-        m_size--;
-        if(pos.m_pCurrCell->m_next == nullptr)
+        if(cellIndex == tailIndex())
         {
-            //pos is the last element.
-            return FIFOHashMapIterator{m_queue.m_pTail, &m_map};
+            return npos;
         }
-        return (++pos);
+        return (cellIndex + 1 == capacity()) ? 0 : cellIndex + 1;
+    }
+    else
+    {
+        return m_cells[cellIndex].getNext();
     }
-    return end();
 }
 
-
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-size_t FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::erase(const K &key)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+uint32_t FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::prevIndex(uint32_t cellIndex) const
 {
-    auto unorderedMapIter = m_map.find(key);
-    if(unorderedMapIter != m_map.end())
+    if constexpr (IS_RING)
     {
-        erase(FIFOHashMapIterator{&(unorderedMapIter->second), &m_map});
-        return 1;
+        if(cellIndex == m_queue.m_head)
+        {
+            return npos;
+        }
+        return (cellIndex == 0) ? static_cast<uint32_t>(capacity() - 1) : cellIndex - 1;
+    }
+    else
+    {
+        return m_cells[cellIndex].getPrev();
     }
-    return 0;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMap::FIFOHashMapIterator
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::find(const K &key)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Visit>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::visitCells(Visit &&visit, size_t threads) const
 {
-    auto unorderedMapIter = m_map.find(key);
-    if(unorderedMapIter != m_map.end())
+    const size_t size = m_size;
+    if(size == 0)
     {
-        return FIFOHashMap::FIFOHashMapIterator{&unorderedMapIter->second, &m_map};
+        return;
     }
-    return FIFOHashMap::FIFOHashMapIterator(nullptr, &m_map);
-}
+    threads = std::max<size_t>(1, std::min(threads, size / PARALLEL_MIN_ELEMENTS));
+    if(threads == 1)
+    {
+        size_t position = 0;
+        for(uint32_t index = headIndex(); index != npos; position++)
+        {
+            const uint32_t next = nextIndex(index);
+            visit(index, position);
+            index = next;
+        }
+        return;
+    }
+    if constexpr (IS_RING)
+    {
+        /*A position is an offset from the head*/
+        runThreads(threads, [this, &visit, size, threads](size_t thread)
+        {
+            const size_t last = size * (thread + 1) / threads;
+            for(size_t position = size * thread / threads; position < last; position++)
+            {
+                const size_t index = m_queue.m_head + position;
+                visit(static_cast<uint32_t>((index >= capacity()) ? index - capacity() : index), position);
+            }
+        });
+    }
+    else
+    {
+        /*The list is cut into sublists, which start at the head and at cells spread over the cell array. The threads
+         *first walk the sublists to measure them, the sublists are put in order to know the position each starts
+         *at, and then the threads walk them again calling visit*/
+        const size_t cellCount = m_cells.size();
+        const size_t wanted = threads * SUBLISTS_PER_THREAD;
+        std::vector<uint32_t> starts;
+        starts.reserve(wanted + 1);
+        for(size_t stretch = 0; stretch < wanted; stretch++)
+        {
+            /*The head is the one cell in use without a previous cell, and is added after*/
+            const size_t last = cellCount * (stretch + 1) / wanted;
+            for(size_t index = cellCount * stretch / wanted; index < last; index++)
+            {
+                if(m_cells[index].m_prev != npos)
+                {
+                    starts.push_back(static_cast<uint32_t>(index));
+                    break;
+                }
+            }
+        }
+        starts.insert(std::lower_bound(starts.begin(), starts.end(), m_queue.m_head), m_queue.m_head);
+        std::vector<bool> isStart(cellCount, false);
+        for(uint32_t start : starts)
+        {
+            isStart[start] = true;
+        }
+        auto sublistOf = [&starts](uint32_t index)
+        {
+            return static_cast<size_t>(std::lower_bound(starts.begin(), starts.end(), index) - starts.begin());
+        };
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::pop()
-{
-    K key = m_queue.m_pHead->m_key;
-    m_queue.removeFirst();
-    m_map.erase(key);
-    m_size--;
-}
+        std::vector<size_t> lengths(starts.size());
+        std::vector<size_t> following(starts.size());
+        std::atomic<size_t> nextSublist{0};
+        runThreads(threads, [&](size_t)
+        {
+            for(size_t sublist = nextSublist++; sublist < starts.size(); sublist = nextSublist++)
+            {
+                uint32_t index = starts[sublist];
+                size_t length = 0;
+                do
+                {
+                    length++;
+                    index = m_cells[index].m_next;
+                }
+                while((index != npos) && !isStart[index]);
+                lengths[sublist] = length;
+                following[sublist] = (index == npos) ? npos : sublistOf(index);
+            }
+        });
 
+        std::vector<size_t> firstPositions(starts.size());
+        size_t position = 0;
+        for(size_t sublist = sublistOf(m_queue.m_head); sublist != npos; sublist = following[sublist])
+        {
+            firstPositions[sublist] = position;
+            position += lengths[sublist];
+        }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::moveElementToTail(const K &key)
-{
-    auto unorderedMapIter = m_map.find(key);
-    if(unorderedMapIter != m_map.end())
-    {
-        FIFOHashMapCell<K,V> &cell = unorderedMapIter->second;
-        m_queue.removeCell(&cell);
-        cell.m_next = cell.m_prev = nullptr;
-        m_queue.addLast(&cell);
+        nextSublist = 0;
+        runThreads(threads, [&](size_t)
+        {
+            for(size_t sublist = nextSublist++; sublist < starts.size(); sublist = nextSublist++)
+            {
+                uint32_t index = starts[sublist];
+                for(size_t offset = 0; offset < lengths[sublist]; offset++)
+                {
+                    const uint32_t next = m_cells[index].m_next;
+                    visit(index, firstPositions[sublist] + offset);
+                    index = next;
+                }
+            }
+        });
     }
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::moveElementToHead(const K &key)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<class Task>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::runThreads(size_t threads, Task &&task)
 {
-    auto unorderedMapIter = m_map.find(key);
-    if(unorderedMapIter != m_map.end())
+    /*task(thread) runs on threads - 1 new threads and on this one, and the first exception thrown is kept*/
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto run = [&task, &error, &errorMutex](size_t thread)
     {
-        FIFOHashMapCell<K,V> &cell = unorderedMapIter->second;
-        m_queue.removeCell(&cell);
-        cell.m_prev = nullptr;
-        cell.m_next = m_queue.m_pHead;
-        m_queue.m_pHead->m_prev = &cell;
-        m_queue.m_pHead = &cell;
-
+        try
+        {
+            task(thread);
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    try
+    {
+        for(size_t thread = 1; thread < threads; thread++)
+        {
+            workers.emplace_back(run, thread);
+        }
+    }
+    catch(...)
+    {
+        for(std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        throw;
+    }
+    run(0);
+    for(std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    if(error)
+    {
+        std::rethrow_exception(error);
     }
 }
 
 /********************************************************************************/
 /*FIFOHashMapCell*/
 /********************************************************************************/
-template<class K, class V>
-K FIFOHashMapCell<K,V>::getKey() const {
-    return m_key;
+template<class K, class V, bool Linked>
+const K &FIFOHashMapCell<K,V,Linked>::getKey() const {
+    return keyValPair().first;
 }
 
-template<class K, class V>
-V FIFOHashMapCell<K,V>::getValue() const {
-    return m_value;
+template<class K, class V, bool Linked>
+const V &FIFOHashMapCell<K,V,Linked>::getValue() const {
+    return keyValPair().second;
 }
 
-template<class K, class V>
-FIFOHashMapCell<K,V> *FIFOHashMapCell<K,V>::getNext() const{
-    return m_next;
+template<class K, class V, bool Linked>
+uint32_t FIFOHashMapCell<K,V,Linked>::getNext() const{
+    return this->m_next;
 }
 
-template<class K, class V>
-FIFOHashMapCell<K,V> *FIFOHashMapCell<K,V>::getPrev() const{
-    return m_prev;
+template<class K, class V, bool Linked>
+uint32_t FIFOHashMapCell<K,V,Linked>::getPrev() const{
+    return this->m_prev;
 }
 
 /********************************************************************************/
 /*FIFOHashMapQueue*/
 /********************************************************************************/
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapQueue::addLast(Cell *cells, uint32_t index)
+{
+    cells[index].m_next = npos;
+    cells[index].m_prev = m_tail;
+    if(m_head == npos)
+    {
+        //First element
+        m_head = m_tail = index;
+        return;
+    }
+    cells[m_tail].m_next = index;
+    m_tail = index;
+}
+
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
 void
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapQueue::addLast( FIFOHashMapCell<K,V>* pCell)
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapQueue::addFirst(Cell *cells, uint32_t index)
 {
-    if(m_pHead == nullptr)
+    cells[index].m_prev = npos;
+    cells[index].m_next = m_head;
+    if(m_head == npos)
     {
         //First element
-        m_pHead = m_pTail = pCell;
+        m_head = m_tail = index;
         return;
     }
-    m_pTail->m_next = pCell;
-    pCell->m_prev = m_pTail;
-    m_pTail = pCell;
+    cells[m_head].m_prev = index;
+    m_head = index;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapQueue::removeLast()
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapQueue::removeLast(Cell *cells)
 {
-    if(m_pHead == m_pTail)
+    if(m_head == m_tail)
     {
-        m_pHead = m_pTail = nullptr;
+        m_head = m_tail = npos;
         return;
     }
-    m_pTail = m_pTail->m_prev;
-    m_pTail->m_next = nullptr;
+    m_tail = cells[m_tail].m_prev;
+    cells[m_tail].m_next = npos;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapQueue::removeFirst() {
-    if(m_pHead == nullptr)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapQueue::removeFirst(Cell *cells) {
+    if(m_head == npos)
     { // Maybe need to remove
         return;
     }
-    if(m_pHead == m_pTail)
+    if(m_head == m_tail)
     {
-        m_pHead = m_pTail = nullptr;
+        m_head = m_tail = npos;
         return;
     }
-    m_pHead = m_pHead->m_next;
-    m_pHead->m_prev = nullptr;
+    m_head = cells[m_head].m_next;
+    cells[m_head].m_prev = npos;
 }
 
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapQueue::removeCell(FIFOHashMapCell<K,V> *cell)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+void FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapQueue::removeCell(Cell *cells, uint32_t index)
 {
-    if(cell == nullptr)
-    {
-        return;
-    }
-    FIFOHashMapCell<K,V> *previousCell = cell->m_prev;
-    FIFOHashMapCell<K,V> *nextCell = cell->m_next;
-    if(previousCell == nextCell)
+    if(index == npos)
     {
-        m_pHead = m_pTail = nullptr;
         return;
     }
-    if(previousCell != nullptr)
+    const uint32_t previousCell = cells[index].m_prev;
+    const uint32_t nextCell = cells[index].m_next;
+    if(previousCell != npos)
     {
-        previousCell->m_next = nextCell;
+        cells[previousCell].m_next = nextCell;
     }
     else
     {
-        m_pHead = nextCell;
+        m_head = nextCell;
     }
 
-    if(nextCell != nullptr)
+    if(nextCell != npos)
     {
-        nextCell->m_prev = previousCell;
+        cells[nextCell].m_prev = previousCell;
     }
     else
     {
-        m_pTail = previousCell;
+        m_tail = previousCell;
     }
 }
 
@@ -633,85 +5660,95 @@ void FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapQueue::removeCe
 /*FIFOHashMapIterator*/
 /********************************************************************************/
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::FIFOHashMapIterator(FIFOHashMapCell<K,V> *pCellPtr,
-                                                                                          unordered_map *pMap,
-                                                                                          bool reverse):m_pCurrCell{pCellPtr}, m_pMap{pMap}, m_isReverse{reverse}
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::FIFOHashMapIteratorBase(uint32_t index, Map *pMap,
+                                                                                         bool reverse):
+        m_index{index}, m_pMap{pMap}, m_isReverse{reverse}
 {
 }
 
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+template<bool OTHER_CONST, typename std::enable_if<IS_CONST && !OTHER_CONST, int>::type>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::FIFOHashMapIteratorBase(
+        const FIFOHashMapIteratorBase<OTHER_CONST> &other):
+        m_index{other.m_index}, m_pMap{other.m_pMap}, m_isReverse{other.m_isReverse}
+{
+}
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-std::pair<const K, V &> &FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator*()
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST>::reference
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator*() const
 {
-    return m_pCurrCell->m_keyValPair;
+    return m_pMap->m_cells[m_index].keyValPair();
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-std::pair<const K, V &> *FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator->()
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST>::pointer
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator->() const
 {
-    return &m_pCurrCell->m_keyValPair;
+    return &m_pMap->m_cells[m_index].keyValPair();
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator& FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator++()
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST> &
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator++()
 {
     if(m_isReverse == false)
     {
-        m_pCurrCell = m_pCurrCell->getNext();
+        m_index = m_pMap->nextIndex(m_index);
     }
     else
     {
-        m_pCurrCell = m_pCurrCell->getPrev();
+        m_index = m_pMap->prevIndex(m_index);
     }
     return *this;
 }
 
-
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator& FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator++(int) {
-    FIFOHashMapIterator &result = (*this);
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator++(int)
+{
+    FIFOHashMapIteratorBase result = *this;
     ++(*this);
     return result;
 }
 
-
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator& FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator--() {
-    if(m_isReverse == false)
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST> &
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator--()
+{
+    /*The end of the order comes right after its last element*/
+    if(m_index == npos)
     {
-        m_pCurrCell = m_pCurrCell->getPrev();
+        m_index = m_isReverse ? m_pMap->headIndex() : m_pMap->tailIndex();
+    }
+    else if(m_isReverse == false)
+    {
+        m_index = m_pMap->prevIndex(m_index);
     }
     else
     {
-        m_pCurrCell = m_pCurrCell->getNext();
+        m_index = m_pMap->nextIndex(m_index);
     }
     return *this;
 }
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-typename FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator& FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::
-operator--(int) {
-    auto &result = *this;
+template<class K, class V, size_t N, class Allocator, class Hash, class KeyEqual, class... Policies>
+template<bool IS_CONST>
+typename FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::template FIFOHashMapIteratorBase<IS_CONST>
+FIFOHashMap<K, V, N, Allocator, Hash, KeyEqual, Policies...>::FIFOHashMapIteratorBase<IS_CONST>::operator--(int)
+{
+    FIFOHashMapIteratorBase result = *this;
     --(*this);
     return result;
 }
 
 
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-bool  FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::operator==(const FIFOHashMapIterator &other) {
-    return (m_pCurrCell == other.m_pCurrCell) && (m_pMap == other.m_pMap);
-}
-
-template<class K, class V, size_t N, class Hash, class KeyEqual, class Allocator>
-bool  FIFOHashMap<K, V, N, Hash, KeyEqual, Allocator>::FIFOHashMapIterator::operator!=(const FIFOHashMapIterator &other) {
-    return (m_pCurrCell != other.m_pCurrCell) || (m_pMap != other.m_pMap);
-}
-
-
 #endif //FIFOHashMap_FIFOHashMap_HPP
@@ -0,0 +1,369 @@
+#ifndef FIFOHashMap_FIFOHashMapIngest_HPP
+#define FIFOHashMap_FIFOHashMapIngest_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/**
+ *FIFO Hash Map Ingest
+
+A front-end for many threads that insert into one map, owned by one thread. Instead of taking a lock per insert, every
+producer thread pushes into its own buffer, and the owner thread drains all the buffers in batches and inserts the
+elements itself. Pushing and draining are lock free - the only shared writes are one index per batch on each side.
+
+ Order:
+
+The elements of one producer are inserted in the order it pushed them. Elements of different producers are
+interleaved by the order the owner drains their buffers in, since they have no common order to begin with.
+
+ Visibility:
+
+An element is in the map once the owner drained it. flush waits until everything the calling producer pushed was
+inserted. With a FIFOHashMap only the owner may then find it; with a SingleWriterFIFOHashMap any thread may, including
+the producer itself.
+
+ #include "FifoHashMapIngest.hpp"
+
+FIFOHashMap<int, Order, 1 << 20> orders;
+FIFOHashMapIngest<FIFOHashMap<int, Order, 1 << 20>> ingest(orders);
+
+auto &producer = ingest.producer();  // once per producer thread
+producer.push({id, order});
+producer.flush();                     // waits for the owner
+
+ingest.drain();                       // in the owner thread, in a loop
+ */
+
+/**
+ * @brief True if Map has insert_batch(value_type*, size_t), as FIFOHashMap does.
+ */
+template<class Map, class = void>
+struct FIFOHashMapIngestHasBatch : std::false_type {};
+
+template<class Map>
+struct FIFOHashMapIngestHasBatch<Map, std::void_t<decltype(std::declval<Map&>().insert_batch(
+        std::declval<typename Map::value_type*>(), size_t()))>> : std::true_type {};
+
+/**
+ *
+ * @tparam Map - The map, such as FIFOHashMap or SingleWriterFIFOHashMap. It needs value_type and insert(value_type&&).
+ * If it has insert_batch(value_type*, size_t) too, the owner inserts whole stretches of a buffer with it, so the map
+ * hashes and prefetches ahead across the batch; otherwise it inserts one element at a time.
+ * @tparam B - Size of every producer buffer, a power of two. A producer that fills it waits for the owner.
+ */
+template<class Map, size_t B = 1024>
+class FIFOHashMapIngest {
+
+    static_assert((B > 0) && ((B & (B - 1)) == 0), "The buffer size must be a power of two");
+
+public:
+    using value_type = typename Map::value_type;
+
+    /**
+     * @brief The buffer of one producer thread. Its methods may be called only by the thread that owns it.
+     */
+    class Producer {
+
+        friend class FIFOHashMapIngest;
+
+        /*Written by the producer. The indices only grow - a slot is index % B*/
+        alignas(64) std::atomic<size_t> m_tail;
+        size_t m_cachedHead;
+        /*Written by the owner, after the elements before it were inserted*/
+        alignas(64) std::atomic<size_t> m_head;
+        Producer *m_next;
+        alignas(alignof(value_type)) unsigned char m_slots[B][sizeof(value_type)];
+
+        Producer();
+        value_type *slot(size_t index);
+
+        template<class... Args>
+        bool tryPush(Args&&... args);
+
+    public:
+        Producer(const Producer &other) = delete;
+        Producer& operator=(const Producer &other) = delete;
+        ~Producer();
+
+        /**
+         * @brief Queue an element to be inserted by the owner.
+         * @return false if the buffer is full - nothing is queued.
+         */
+        bool try_push(const value_type &value);
+        bool try_push(value_type &&value);
+
+        /**
+         * @brief Queue an element to be inserted by the owner, waiting while the buffer is full.
+         */
+        void push(const value_type &value);
+        void push(value_type &&value);
+
+        /**
+         * @brief Waits until every element pushed by this producer was inserted into the map.
+         * The owner must keep draining meanwhile.
+         */
+        void flush() const;
+
+        /**
+         * @return Number of elements pushed but not inserted yet.
+         */
+        size_t pending() const;
+    };
+
+private:
+    /*Members*/
+    Map &m_map;
+    /*Producers are only added - at the front, so the owner can walk the list while it grows*/
+    std::atomic<Producer*> m_producers;
+
+    /*Private methods*/
+    size_t drainProducer(Producer &producer, size_t count);
+    static void destroySlots(Producer &producer, size_t first, size_t last);
+
+    /*Methods*/
+public:
+    /**
+     * @param map - The map to insert into. From now on only the owner thread may modify it.
+     */
+    explicit FIFOHashMapIngest(Map &map);
+    FIFOHashMapIngest(const FIFOHashMapIngest &other) = delete;
+    FIFOHashMapIngest& operator=(const FIFOHashMapIngest &other) = delete;
+    /**
+     * @brief Elements that were not drained are dropped. No producer may be in use.
+     */
+    ~FIFOHashMapIngest();
+
+    /**
+     * @brief Creates a buffer for the calling thread. Any thread may call it; the buffer lives as long as this object.
+     */
+    Producer &producer();
+
+    /**
+     * @brief Inserts everything pushed so far, one buffer at a time. Owner thread only.
+     * If an insert throws, the exception is passed on and the element is dropped - with insert_batch, so are the ones
+     * after it in the same stretch of the buffer, since the map does not tell how far it got.
+     * @param count - Maximum number of elements taken from each buffer.
+     * @return Number of elements inserted.
+     */
+    size_t drain(size_t count = SIZE_MAX);
+
+    /**
+     * @return The map. Owner thread only, unless the map itself allows concurrent readers.
+     */
+    Map &map()
+    {
+        return m_map;
+    }
+
+};
+
+/*FIFOHashMapIngest*/
+
+template<class Map, size_t B>
+FIFOHashMapIngest<Map, B>::FIFOHashMapIngest(Map &map) : m_map(map), m_producers(nullptr)
+{
+
+}
+
+template<class Map, size_t B>
+FIFOHashMapIngest<Map, B>::~FIFOHashMapIngest()
+{
+    Producer *producer = m_producers.load(std::memory_order_acquire);
+    while(producer)
+    {
+        Producer *next = producer->m_next;
+        delete producer;
+        producer = next;
+    }
+}
+
+template<class Map, size_t B>
+typename FIFOHashMapIngest<Map, B>::Producer &FIFOHashMapIngest<Map, B>::producer()
+{
+    Producer *producer = new Producer();
+    producer->m_next = m_producers.load(std::memory_order_relaxed);
+    while(!m_producers.compare_exchange_weak(producer->m_next, producer,
+                                             std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    return *producer;
+}
+
+template<class Map, size_t B>
+size_t FIFOHashMapIngest<Map, B>::drain(size_t count)
+{
+    size_t drained = 0;
+    for(Producer *producer = m_producers.load(std::memory_order_acquire); producer; producer = producer->m_next)
+    {
+        drained += drainProducer(*producer, count);
+    }
+    return drained;
+}
+
+/********************************************************************************/
+/*FIFOHashMapIngest - private*/
+/********************************************************************************/
+
+template<class Map, size_t B>
+size_t FIFOHashMapIngest<Map, B>::drainProducer(Producer &producer, size_t count)
+{
+    const size_t head = producer.m_head.load(std::memory_order_relaxed);
+    const size_t tail = producer.m_tail.load(std::memory_order_acquire);
+    const size_t end = (tail - head > count) ? head + count : tail;
+
+    /*The head is published once per batch - but also when an insert throws, so the failed element is not retried*/
+    size_t index = head;
+    if constexpr (FIFOHashMapIngestHasBatch<Map>::value)
+    {
+        /*The elements are contiguous up to the end of the buffer, so a batch is at most two stretches*/
+        size_t stretchEnd = index;
+        try
+        {
+            for(; index != end; index = stretchEnd)
+            {
+                stretchEnd = index + std::min(end - index, B - (index & (B - 1)));
+                m_map.insert_batch(producer.slot(index), stretchEnd - index);
+                destroySlots(producer, index, stretchEnd);
+            }
+        }
+        catch(...)
+        {
+            destroySlots(producer, index, stretchEnd);
+            producer.m_head.store(stretchEnd, std::memory_order_release);
+            throw;
+        }
+    }
+    else
+    {
+        try
+        {
+            for(; index != end; index++)
+            {
+                value_type *value = producer.slot(index);
+                m_map.insert(std::move(*value));
+                value->~value_type();
+            }
+        }
+        catch(...)
+        {
+            producer.slot(index)->~value_type();
+            producer.m_head.store(index + 1, std::memory_order_release);
+            throw;
+        }
+    }
+    producer.m_head.store(end, std::memory_order_release);
+    return end - head;
+}
+
+template<class Map, size_t B>
+void FIFOHashMapIngest<Map, B>::destroySlots(Producer &producer, size_t first, size_t last)
+{
+    for(size_t index = first; index != last; index++)
+    {
+        producer.slot(index)->~value_type();
+    }
+}
+
+/********************************************************************************/
+/*Producer*/
+/********************************************************************************/
+
+template<class Map, size_t B>
+FIFOHashMapIngest<Map, B>::Producer::Producer() : m_tail(0), m_cachedHead(0), m_head(0), m_next(nullptr)
+{
+
+}
+
+template<class Map, size_t B>
+FIFOHashMapIngest<Map, B>::Producer::~Producer()
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    for(size_t index = m_head.load(std::memory_order_relaxed); index != tail; index++)
+    {
+        slot(index)->~value_type();
+    }
+}
+
+template<class Map, size_t B>
+bool FIFOHashMapIngest<Map, B>::Producer::try_push(const value_type &value)
+{
+    return tryPush(value);
+}
+
+template<class Map, size_t B>
+bool FIFOHashMapIngest<Map, B>::Producer::try_push(value_type &&value)
+{
+    return tryPush(std::move(value));
+}
+
+template<class Map, size_t B>
+void FIFOHashMapIngest<Map, B>::Producer::push(const value_type &value)
+{
+    while(!tryPush(value))
+    {
+        std::this_thread::yield();
+    }
+}
+
+template<class Map, size_t B>
+void FIFOHashMapIngest<Map, B>::Producer::push(value_type &&value)
+{
+    /*tryPush moves from value only when it succeeds*/
+    while(!tryPush(std::move(value)))
+    {
+        std::this_thread::yield();
+    }
+}
+
+template<class Map, size_t B>
+void FIFOHashMapIngest<Map, B>::Producer::flush() const
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    while(m_head.load(std::memory_order_acquire) != tail)
+    {
+        std::this_thread::yield();
+    }
+}
+
+template<class Map, size_t B>
+size_t FIFOHashMapIngest<Map, B>::Producer::pending() const
+{
+    return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire);
+}
+
+/********************************************************************************/
+/*Producer - private*/
+/********************************************************************************/
+
+template<class Map, size_t B>
+typename FIFOHashMapIngest<Map, B>::value_type *FIFOHashMapIngest<Map, B>::Producer::slot(size_t index)
+{
+    return std::launder(reinterpret_cast<value_type*>(m_slots[index & (B - 1)]));
+}
+
+template<class Map, size_t B>
+template<class... Args>
+bool FIFOHashMapIngest<Map, B>::Producer::tryPush(Args&&... args)
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail - m_cachedHead == B)
+    {
+        /*Only now read the owner's index - its cache line is not touched while there is room*/
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if(tail - m_cachedHead == B)
+        {
+            return false;
+        }
+    }
+    new(m_slots[tail & (B - 1)]) value_type(std::forward<Args>(args)...);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+#endif //FIFOHashMap_FIFOHashMapIngest_HPP
@@ -0,0 +1,125 @@
+/*
+ * Thread scaling of ConcurrentFIFOHashMap against a FIFOHashMap behind one global mutex.
+ * Every thread runs the same mix of finds and inserts on random keys, for 1 to 64 threads.
+ * Usage: ConcurrentFIFOHashMap_bench [operations per thread]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/ConcurrentFifoHashMap.hpp"
+
+namespace
+{
+
+constexpr size_t CAPACITY = 1 << 20;
+constexpr int KEY_RANGE = 2 * CAPACITY;
+/*Out of every 10 operations*/
+constexpr int INSERTS = 2;
+
+struct GlobalLockMap
+{
+    std::mutex m_mutex;
+    FIFOHashMap<int, int, CAPACITY> m_map;
+
+    void insert(int key, int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_map.insert({key, value});
+    }
+
+    bool contains(int key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_map.find(key) != m_map.end();
+    }
+};
+
+struct ShardedMap
+{
+    ConcurrentFIFOHashMap<int, int, CAPACITY, 64> m_map;
+
+    void insert(int key, int value)
+    {
+        m_map.insert({key, value});
+    }
+
+    bool contains(int key)
+    {
+        return m_map.contains(key);
+    }
+};
+
+/**
+ * @return Million operations per second over all the threads.
+ */
+template<class Map>
+double run(Map &map, int threadCount, int operationsPerThread)
+{
+    std::vector<std::thread> threads;
+    std::vector<size_t> hits(threadCount);
+    const auto start = std::chrono::steady_clock::now();
+    for(int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&map, &hits, t, operationsPerThread]()
+        {
+            std::mt19937 generator(t + 1);
+            std::uniform_int_distribution<int> keyDistribution(0, KEY_RANGE - 1);
+            for(int i = 0; i < operationsPerThread; i++)
+            {
+                const int key = keyDistribution(generator);
+                if(i % 10 < INSERTS)
+                {
+                    map.insert(key, i);
+                }
+                else
+                {
+                    hits[t] += map.contains(key);
+                }
+            }
+        });
+    }
+    for(std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    return (static_cast<double>(threadCount) * operationsPerThread) / seconds.count() / 1e6;
+}
+
+template<class Map>
+std::unique_ptr<Map> filledMap()
+{
+    std::unique_ptr<Map> map = std::make_unique<Map>();
+    for(int key = 0; key < static_cast<int>(CAPACITY); key++)
+    {
+        map->insert(key * 2, key);
+    }
+    return map;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const int operationsPerThread = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+    std::printf("%u hardware threads, %d operations per thread, %d%% inserts\n",
+                std::thread::hardware_concurrency(), operationsPerThread, INSERTS * 10);
+    std::printf("%8s %18s %18s\n", "threads", "global lock Mop/s", "64 shards Mop/s");
+    for(int threadCount = 1; threadCount <= 64; threadCount *= 2)
+    {
+        std::unique_ptr<GlobalLockMap> globalLockMap = filledMap<GlobalLockMap>();
+        const double globalLock = run(*globalLockMap, threadCount, operationsPerThread);
+        globalLockMap.reset();
+
+        std::unique_ptr<ShardedMap> shardedMap = filledMap<ShardedMap>();
+        const double sharded = run(*shardedMap, threadCount, operationsPerThread);
+        std::printf("%8d %18.2f %18.2f\n", threadCount, globalLock, sharded);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/ConcurrentFifoHashMap.hpp"
+
+TEST(ConcurrentFIFOHashMapTest,SingleThread)
+{
+ConcurrentFIFOHashMap<int, std::string, 64, 4> concurrentMap;
+EXPECT_EQ(64, concurrentMap.capacity());
+EXPECT_EQ(4, concurrentMap.shard_count());
+
+EXPECT_TRUE(concurrentMap.insert({1, "One"}));
+EXPECT_FALSE(concurrentMap.insert({1, "Another one"}));
+EXPECT_EQ("One", concurrentMap.find(1).value());
+EXPECT_FALSE(concurrentMap.find(2).has_value());
+EXPECT_TRUE(concurrentMap.contains(1));
+
+EXPECT_FALSE(concurrentMap.insert_or_assign(1, "Uno"));
+EXPECT_TRUE(concurrentMap.insert_or_assign(2, "Two"));
+EXPECT_EQ("Uno", concurrentMap.find(1).value());
+
+concurrentMap.update(3, [](std::string &value) { value += "Three"; });
+EXPECT_EQ("Three", concurrentMap.find(3).value());
+EXPECT_TRUE(concurrentMap.visit(3, [](std::string &value) { value += "!"; }));
+EXPECT_FALSE(concurrentMap.visit(4, [](std::string &value) { value += "!"; }));
+EXPECT_EQ("Three!", concurrentMap.find(3).value());
+
+EXPECT_EQ(3, concurrentMap.size());
+EXPECT_EQ(1, concurrentMap.erase(2));
+EXPECT_EQ(0, concurrentMap.erase(2));
+EXPECT_EQ(2, concurrentMap.size());
+concurrentMap.clear();
+EXPECT_EQ(0, concurrentMap.size());
+}
+
+TEST(ConcurrentFIFOHashMapTest,EvictsPerShard)
+{
+ConcurrentFIFOHashMap<int, int, 256, 4> concurrentMap;
+for(int i = 0; i < 10000; i++)
+{
+concurrentMap.insert({i, i});
+}
+/*Every shard is full, and holds the newest keys that hash to it*/
+EXPECT_EQ(256, concurrentMap.size());
+for(int i = 10000 - 32; i < 10000; i++)
+{
+EXPECT_TRUE(concurrentMap.contains(i));
+}
+EXPECT_FALSE(concurrentMap.contains(0));
+}
+
+TEST(ConcurrentFIFOHashMapTest,ConcurrentInsertAndFind)
+{
+constexpr int threadCount = 8;
+constexpr int keysPerThread = 5000;
+ConcurrentFIFOHashMap<int, int, 1 << 17> concurrentMap;
+std::atomic<int> misses{0};
+
+std::vector<std::thread> threads;
+for(int t = 0; t < threadCount; t++)
+{
+threads.emplace_back([&concurrentMap, &misses, t]()
+{
+for(int i = 0; i < keysPerThread; i++)
+{
+const int key = t * keysPerThread + i;
+concurrentMap.insert({key, -key});
+if(concurrentMap.find(key) != -key)
+{
+misses++;
+}
+}
+});
+}
+for(std::thread &thread : threads)
+{
+thread.join();
+}
+
+EXPECT_EQ(0, misses.load());
+EXPECT_EQ(threadCount * keysPerThread, concurrentMap.size());
+for(int key = 0; key < threadCount * keysPerThread; key++)
+{
+ASSERT_EQ(-key, concurrentMap.find(key));
+}
+}
+
+TEST(ConcurrentFIFOHashMapTest,ConcurrentUpdates)
+{
+constexpr int threadCount = 8;
+constexpr int rounds = 2000;
+ConcurrentFIFOHashMap<int, long, 1024> concurrentMap;
+
+std::vector<std::thread> threads;
+for(int t = 0; t < threadCount; t++)
+{
+threads.emplace_back([&concurrentMap]()
+{
+for(int i = 0; i < rounds; i++)
+{
+concurrentMap.update(i % 16, [](long &value) { value++; });
+}
+});
+}
+for(std::thread &thread : threads)
+{
+thread.join();
+}
+
+long total = 0;
+for(int key = 0; key < 16; key++)
+{
+total += concurrentMap.find(key).value();
+}
+EXPECT_EQ(threadCount * rounds, total);
+}
+
+TEST(ConcurrentFIFOHashMapTest,StatsSumShards)
+{
+constexpr int threadCount = 4;
+constexpr int keysPerThread = 1000;
+ConcurrentFIFOHashMap<int, int, 1 << 14, 4, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapStats> concurrentMap;
+
+std::vector<std::thread> threads;
+for(int t = 0; t < threadCount; t++)
+{
+threads.emplace_back([&concurrentMap, t]()
+{
+for(int i = 0; i < keysPerThread; i++)
+{
+const int key = t * keysPerThread + i;
+concurrentMap.insert({key, key});
+concurrentMap.insert({key, -key});
+concurrentMap.contains(key);
+}
+});
+}
+for(std::thread &thread : threads)
+{
+thread.join();
+}
+
+FIFOHashMapStatistics stats = concurrentMap.stats();
+EXPECT_EQ(threadCount * keysPerThread, stats.m_insertions);
+EXPECT_EQ(threadCount * keysPerThread, stats.m_duplicates);
+EXPECT_EQ(threadCount * keysPerThread, stats.m_hits);
+EXPECT_EQ(0, stats.m_misses);
+EXPECT_EQ(0, stats.m_evictions);
+EXPECT_EQ(3 * threadCount * keysPerThread, stats.m_probes);
+
+concurrentMap.reset_stats();
+EXPECT_EQ(0, concurrentMap.stats().m_insertions);
+}
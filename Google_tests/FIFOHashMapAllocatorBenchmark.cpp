@@ -0,0 +1,84 @@
+/*
+ * Latency of inserting into a full FIFOHashMap whose values allocate - every insertion evicts the oldest element -
+ * with the values allocated by malloc (std::string) and from a FIFOHashMapPoolResource sized from the capacity
+ * (std::pmr::string in a FIFOHashMapPmr). The values are 16 to 200 characters, past the small string buffer.
+ * Prints percentiles of the time of one insert_or_assign, timed one by one.
+ * Usage: FIFOHashMap_allocator_bench [inserts]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
+
+namespace
+{
+
+constexpr size_t CAPACITY = 1 << 16;
+constexpr size_t MAX_VALUE = 200;
+
+template<class Map>
+void run(const char *name, Map &map, const std::vector<std::string_view> &values)
+{
+    /*Fill the map first, so every timed insertion evicts*/
+    uint64_t key = 0;
+    for(size_t i = 0; i < CAPACITY; i++, key++)
+    {
+        map.insert_or_assign(key, values[key % values.size()]);
+    }
+    std::vector<uint32_t> nanoseconds(values.size());
+    for(uint32_t &elapsed : nanoseconds)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        map.insert_or_assign(key, values[key % values.size()]);
+        elapsed = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        key++;
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    auto percentile = [&nanoseconds](double fraction)
+    {
+        return nanoseconds[std::min(nanoseconds.size() - 1, size_t(fraction * nanoseconds.size()))];
+    };
+    std::printf("  %-8s %8u %8u %8u %8u %8u\n", name, percentile(0.5), percentile(0.99), percentile(0.999),
+                percentile(0.9999), nanoseconds.back());
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const size_t inserts = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+    /*The values point into one buffer, so making them allocates nothing*/
+    const std::string text(MAX_VALUE, 'v');
+    std::mt19937_64 generator(1);
+    std::uniform_int_distribution<size_t> length(16, MAX_VALUE);
+    std::vector<std::string_view> values(inserts);
+    for(std::string_view &value : values)
+    {
+        value = std::string_view(text.data(), length(generator));
+    }
+
+    std::printf("insert_or_assign into a full map of %zu, ns\n", CAPACITY);
+    std::printf("  %-8s %8s %8s %8s %8s %8s\n", "values", "p50", "p99", "p99.9", "p99.99", "max");
+    {
+        auto map = std::make_unique<FIFOHashMap<uint64_t, std::string, CAPACITY>>();
+        run("malloc", *map, values);
+    }
+    {
+        /*One block per value - an insertion evicts before it constructs the new value*/
+        FIFOHashMapPoolResource pool(MAX_VALUE + 1, CAPACITY);
+        auto map = std::make_unique<FIFOHashMapPmr<uint64_t, std::pmr::string, CAPACITY>>(&pool);
+        run("pool", *map, values);
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Throughput of the batch operations of FIFOHashMap against loops of single operations, on a full map much larger
+ * than the last level cache:
+ *  - insert(first, last) against insert - every insert misses on its bucket and on the bucket of the element it evicts.
+ *  - find_batch against find, for batches of existing and missing keys.
+ * Usage: FIFOHashMap_batch_bench [capacity] [insert batch size] [find batch size]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
+
+namespace
+{
+
+using LinkedMap = FIFOHashMap<uint64_t, uint64_t, FIFOHashMapDynamicCapacity>;
+using RingMap = FIFOHashMap<uint64_t, uint64_t, FIFOHashMapDynamicCapacity,
+        std::allocator<std::pair<const uint64_t, uint64_t>>,
+        std::hash<uint64_t>, std::equal_to<uint64_t>, FIFOHashMapRingOrder>;
+
+/**
+ * @return Million inserts per second.
+ */
+template<class Map, bool Batched>
+double runInsert(size_t capacity, size_t batchSize)
+{
+    Map map(capacity);
+    std::mt19937_64 generator(1);
+    std::vector<std::pair<uint64_t, uint64_t>> batch(batchSize);
+    auto fill = [&generator, &batch]()
+    {
+        for(auto &pair : batch)
+        {
+            pair = {generator(), 0};
+        }
+    };
+
+    /*Fill the map first, so that every measured insert evicts*/
+    for(size_t filled = 0; filled < capacity; filled += batchSize)
+    {
+        fill();
+        map.insert(batch.begin(), batch.end());
+    }
+
+    const size_t inserts = 2 * capacity;
+    std::chrono::duration<double> seconds(0);
+    for(size_t done = 0; done < inserts; done += batchSize)
+    {
+        fill();
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (Batched)
+        {
+            map.insert(batch.begin(), batch.end());
+        }
+        else
+        {
+            for(const auto &pair : batch)
+            {
+                map.insert(pair);
+            }
+        }
+        seconds += std::chrono::steady_clock::now() - start;
+    }
+    return inserts / seconds.count() / 1e6;
+}
+
+/**
+ * @return Million lookups per second. Keys 0 to capacity - 1 exist, half of the looked up keys do not.
+ */
+template<class Map, bool Batched>
+double runFind(Map &map, size_t capacity, size_t batchSize)
+{
+    std::mt19937_64 generator(2);
+    std::uniform_int_distribution<uint64_t> keyDistribution(0, 2 * capacity - 1);
+    std::vector<uint64_t> keys(batchSize);
+    std::vector<typename Map::iterator> results(batchSize, map.end());
+
+    const size_t lookups = 2 * capacity;
+    std::chrono::duration<double> seconds(0);
+    for(size_t done = 0; done < lookups; done += batchSize)
+    {
+        for(uint64_t &key : keys)
+        {
+            key = keyDistribution(generator);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (Batched)
+        {
+            map.find_batch(keys.data(), batchSize, results.data());
+        }
+        else
+        {
+            for(size_t i = 0; i < batchSize; i++)
+            {
+                results[i] = map.find(keys[i]);
+            }
+        }
+        seconds += std::chrono::steady_clock::now() - start;
+    }
+    return lookups / seconds.count() / 1e6;
+}
+
+template<class Map>
+void printFind(const char *order, size_t capacity, size_t batchSize)
+{
+    Map map(capacity);
+    for(uint64_t key = 0; key < capacity; key++)
+    {
+        map.insert({key, key});
+    }
+    const double single = runFind<Map, false>(map, capacity, batchSize);
+    const double batched = runFind<Map, true>(map, capacity, batchSize);
+    std::printf("%8s %16.2f %16.2f\n", order, single, batched);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const size_t capacity = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : (size_t(1) << 24);
+    const size_t insertBatchSize = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 4096;
+    const size_t findBatchSize = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 256;
+    std::printf("capacity %zu, %.0f MB per map\n", capacity, LinkedMap(capacity).memory_usage() / 1e6);
+
+    std::printf("insert, batches of %zu\n", insertBatchSize);
+    std::printf("%8s %16s %16s\n", "order", "single Mop/s", "range Mop/s");
+    std::printf("%8s %16.2f %16.2f\n", "linked", runInsert<LinkedMap, false>(capacity, insertBatchSize),
+                runInsert<LinkedMap, true>(capacity, insertBatchSize));
+    std::printf("%8s %16.2f %16.2f\n", "ring", runInsert<RingMap, false>(capacity, insertBatchSize),
+                runInsert<RingMap, true>(capacity, insertBatchSize));
+
+    std::printf("find, batches of %zu\n", findBatchSize);
+    std::printf("%8s %16s %16s\n", "order", "single Mop/s", "batch Mop/s");
+    printFind<LinkedMap>("linked", capacity, findBatchSize);
+    printFind<RingMap>("ring", capacity, findBatchSize);
+    return 0;
+}
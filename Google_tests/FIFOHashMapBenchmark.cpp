@@ -0,0 +1,451 @@
+/*
+ * Single-thread operations of FIFOHashMap against two baselines, with Google Benchmark:
+ *  - ListMap - a std::list in FIFO order and a std::unordered_map from the keys to the list nodes, the textbook
+ *    way to get the same semantics.
+ *  - UnorderedMap - a plain std::unordered_map, which keeps no order and evicts an arbitrary element when full:
+ *    the cost of the hashing alone.
+ * Every map is filled to its capacity N before it is measured, and stays full.
+ * Keys and values are int/int, std::string/std::string (longer than the small string buffer) and int/256-byte blob.
+ * N goes from 1K to 10M for int/int and to 1M for the others - 10M strings or blobs need several GB per map.
+ * Usage: FIFOHashMap_bench [--benchmark_filter=<regex>] [--benchmark_out=<file> --benchmark_out_format=json]
+ * The FIFOHashMap_bench_json target runs all of it and writes FIFOHashMap_bench.json to the build directory.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
+
+namespace
+{
+
+struct Blob
+{
+    char m_bytes[256];
+};
+
+/**
+ * @return The i-th distinct key or value of a type. Keys are spread out, so that no map gets sequential int keys.
+ */
+template<class T>
+T makeItem(uint32_t i);
+
+template<>
+int makeItem<int>(uint32_t i)
+{
+    /*An odd multiplier is a bijection of the 32-bit integers*/
+    return static_cast<int>(i * 2654435761u);
+}
+
+template<>
+std::string makeItem<std::string>(uint32_t i)
+{
+    return "fifo-hash-map-item-" + std::to_string(i * 2654435761u);
+}
+
+template<>
+Blob makeItem<Blob>(uint32_t i)
+{
+    Blob blob{};
+    blob.m_bytes[0] = static_cast<char>(i);
+    return blob;
+}
+
+template<class K, class V>
+class FIFOMap
+{
+    FIFOHashMap<K, V, FIFOHashMapDynamicCapacity> m_map;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    static constexpr bool ORDERED = true;
+
+    explicit FIFOMap(size_t capacity) : m_map(capacity)
+    {
+    }
+
+    void insert(const K &key, const V &value)
+    {
+        m_map.insert({key, value});
+    }
+
+    bool contains(const K &key)
+    {
+        return m_map.find(key) != m_map.end();
+    }
+
+    V &operator[](const K &key)
+    {
+        return m_map[key];
+    }
+
+    void erase(const K &key)
+    {
+        m_map.erase(key);
+    }
+
+    void moveToTail(const K &key)
+    {
+        m_map.moveElementToTail(key);
+    }
+
+    void moveToHead(const K &key)
+    {
+        m_map.moveElementToHead(key);
+    }
+
+    template<class F>
+    void forEach(F &&f)
+    {
+        for(auto &pair : m_map)
+        {
+            f(pair.second);
+        }
+    }
+};
+
+template<class K, class V>
+class ListMap
+{
+    using List = std::list<std::pair<K, V>>;
+
+    List m_order;
+    std::unordered_map<K, typename List::iterator> m_index;
+    size_t m_capacity;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    static constexpr bool ORDERED = true;
+
+    explicit ListMap(size_t capacity) : m_capacity(capacity)
+    {
+        m_index.reserve(capacity);
+    }
+
+    void insert(const K &key, const V &value)
+    {
+        if(m_index.find(key) != m_index.end())
+        {
+            return;
+        }
+        if(m_index.size() == m_capacity)
+        {
+            m_index.erase(m_order.front().first);
+            m_order.pop_front();
+        }
+        m_order.emplace_back(key, value);
+        m_index.emplace(key, std::prev(m_order.end()));
+    }
+
+    bool contains(const K &key)
+    {
+        return m_index.find(key) != m_index.end();
+    }
+
+    V &operator[](const K &key)
+    {
+        auto it = m_index.find(key);
+        if(it == m_index.end())
+        {
+            insert(key, V());
+            return m_order.back().second;
+        }
+        return it->second->second;
+    }
+
+    void erase(const K &key)
+    {
+        auto it = m_index.find(key);
+        if(it != m_index.end())
+        {
+            m_order.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    void moveToTail(const K &key)
+    {
+        auto it = m_index.find(key);
+        if(it != m_index.end())
+        {
+            m_order.splice(m_order.end(), m_order, it->second);
+        }
+    }
+
+    void moveToHead(const K &key)
+    {
+        auto it = m_index.find(key);
+        if(it != m_index.end())
+        {
+            m_order.splice(m_order.begin(), m_order, it->second);
+        }
+    }
+
+    template<class F>
+    void forEach(F &&f)
+    {
+        for(auto &pair : m_order)
+        {
+            f(pair.second);
+        }
+    }
+};
+
+template<class K, class V>
+class UnorderedMap
+{
+    std::unordered_map<K, V> m_map;
+    size_t m_capacity;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    static constexpr bool ORDERED = false;
+
+    explicit UnorderedMap(size_t capacity) : m_capacity(capacity)
+    {
+        m_map.reserve(capacity);
+    }
+
+    void insert(const K &key, const V &value)
+    {
+        if(m_map.size() == m_capacity && m_map.find(key) == m_map.end())
+        {
+            m_map.erase(m_map.begin());
+        }
+        m_map.emplace(key, value);
+    }
+
+    bool contains(const K &key)
+    {
+        return m_map.find(key) != m_map.end();
+    }
+
+    V &operator[](const K &key)
+    {
+        return m_map[key];
+    }
+
+    void erase(const K &key)
+    {
+        m_map.erase(key);
+    }
+
+    template<class F>
+    void forEach(F &&f)
+    {
+        for(auto &pair : m_map)
+        {
+            f(pair.second);
+        }
+    }
+};
+
+/**
+ * @brief A full map of capacity N, holding keys[0, N), and the keys to look up.
+ * keys[N, 2N) are not in the map - inserting keys[i % 2N] in turn always inserts a new key and evicts.
+ */
+template<class Map>
+struct Fixture
+{
+    using K = typename Map::key_type;
+    using V = typename Map::mapped_type;
+    /*Lookups cycle through this many random keys - random enough to defeat the caches, small enough to stay cheap*/
+    static constexpr size_t PROBES = 1 << 16;
+
+    size_t m_capacity;
+    std::vector<K> m_keys;
+    std::vector<K> m_hits;
+    std::vector<K> m_misses;
+    V m_value;
+    Map m_map;
+
+    explicit Fixture(size_t capacity) : m_capacity(capacity), m_value(makeItem<V>(1)), m_map(capacity)
+    {
+        m_keys.reserve(2 * capacity);
+        for(size_t i = 0; i < 2 * capacity; i++)
+        {
+            m_keys.push_back(makeItem<K>(static_cast<uint32_t>(i)));
+        }
+        for(size_t i = 0; i < capacity; i++)
+        {
+            m_map.insert(m_keys[i], m_value);
+        }
+        std::mt19937_64 generator(1);
+        std::uniform_int_distribution<size_t> distribution(0, capacity - 1);
+        for(size_t i = 0; i < PROBES; i++)
+        {
+            const size_t index = distribution(generator);
+            m_hits.push_back(m_keys[index]);
+            m_misses.push_back(m_keys[capacity + index]);
+        }
+    }
+};
+
+template<class Map>
+void insertAtCapacity(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    const size_t keyCount = fixture.m_keys.size();
+    size_t next = fixture.m_capacity;
+    for(auto _ : state)
+    {
+        fixture.m_map.insert(fixture.m_keys[next], fixture.m_value);
+        next = (next + 1 == keyCount) ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class Map>
+void findHit(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(fixture.m_map.contains(fixture.m_hits[probe]));
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class Map>
+void findMiss(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(fixture.m_map.contains(fixture.m_misses[probe]));
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class Map>
+void subscriptHit(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(&fixture.m_map[fixture.m_hits[probe]]);
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Erases a key and inserts it back, which keeps the map full - the pair is one item.
+ */
+template<class Map>
+void eraseAndInsert(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        fixture.m_map.erase(fixture.m_hits[probe]);
+        fixture.m_map.insert(fixture.m_hits[probe], fixture.m_value);
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class Map>
+void moveToTail(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        fixture.m_map.moveToTail(fixture.m_hits[probe]);
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class Map>
+void moveToHead(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    size_t probe = 0;
+    for(auto _ : state)
+    {
+        fixture.m_map.moveToHead(fixture.m_hits[probe]);
+        probe = (probe + 1) % Fixture<Map>::PROBES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Visits every value - an item is an element.
+ */
+template<class Map>
+void iterate(benchmark::State &state)
+{
+    Fixture<Map> fixture(state.range(0));
+    for(auto _ : state)
+    {
+        fixture.m_map.forEach([](typename Map::mapped_type &value)
+                              {
+                                  benchmark::DoNotOptimize(&value);
+                              });
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.m_capacity);
+}
+
+using FIFOIntMap = FIFOMap<int, int>;
+using FIFOStringMap = FIFOMap<std::string, std::string>;
+using FIFOBlobMap = FIFOMap<int, Blob>;
+using ListIntMap = ListMap<int, int>;
+using ListStringMap = ListMap<std::string, std::string>;
+using ListBlobMap = ListMap<int, Blob>;
+using UnorderedIntMap = UnorderedMap<int, int>;
+using UnorderedStringMap = UnorderedMap<std::string, std::string>;
+using UnorderedBlobMap = UnorderedMap<int, Blob>;
+
+}
+
+#define FIFOHashMap_BENCHMARK(Function, Map, MaxCapacity) \
+    BENCHMARK_TEMPLATE(Function, Map)->RangeMultiplier(10)->Range(1000, MaxCapacity)
+
+/*Operations every map has*/
+#define FIFOHashMap_BENCHMARKS(Map, MaxCapacity) \
+    FIFOHashMap_BENCHMARK(insertAtCapacity, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(findHit, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(findMiss, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(subscriptHit, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(eraseAndInsert, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(iterate, Map, MaxCapacity)
+
+/*Operations on the FIFO order*/
+#define FIFOHashMap_ORDER_BENCHMARKS(Map, MaxCapacity) \
+    FIFOHashMap_BENCHMARK(moveToTail, Map, MaxCapacity); \
+    FIFOHashMap_BENCHMARK(moveToHead, Map, MaxCapacity)
+
+FIFOHashMap_BENCHMARKS(FIFOIntMap, 10000000);
+FIFOHashMap_ORDER_BENCHMARKS(FIFOIntMap, 10000000);
+FIFOHashMap_BENCHMARKS(ListIntMap, 10000000);
+FIFOHashMap_ORDER_BENCHMARKS(ListIntMap, 10000000);
+FIFOHashMap_BENCHMARKS(UnorderedIntMap, 10000000);
+
+FIFOHashMap_BENCHMARKS(FIFOStringMap, 1000000);
+FIFOHashMap_ORDER_BENCHMARKS(FIFOStringMap, 1000000);
+FIFOHashMap_BENCHMARKS(ListStringMap, 1000000);
+FIFOHashMap_ORDER_BENCHMARKS(ListStringMap, 1000000);
+FIFOHashMap_BENCHMARKS(UnorderedStringMap, 1000000);
+
+FIFOHashMap_BENCHMARKS(FIFOBlobMap, 1000000);
+FIFOHashMap_ORDER_BENCHMARKS(FIFOBlobMap, 1000000);
+FIFOHashMap_BENCHMARKS(ListBlobMap, 1000000);
+FIFOHashMap_ORDER_BENCHMARKS(ListBlobMap, 1000000);
+FIFOHashMap_BENCHMARKS(UnorderedBlobMap, 1000000);
+
+BENCHMARK_MAIN();
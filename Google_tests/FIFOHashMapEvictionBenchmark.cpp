@@ -0,0 +1,154 @@
+/*
+ * Hit ratio and throughput of the eviction policies of FIFOHashMap on skewed traces, used as a cache: every request
+ * looks its key up and inserts it on a miss.
+ *  - zipf a - keys drawn from a Zipf distribution of exponent a over the key range.
+ *  - zipf+scan - zipf 0.99, with a scan of keys that are never requested again after every 10 cache sizes of requests.
+ * Every trace runs at cache sizes of 0.1%, 1% and 10% of the key range.
+ * Usage: FIFOHashMap_eviction_bench [key range] [requests]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
+
+namespace
+{
+
+template<class EvictionPolicy>
+using CacheMap = FIFOHashMap<uint64_t, uint64_t, FIFOHashMapDynamicCapacity,
+        std::allocator<std::pair<const uint64_t, uint64_t>>,
+        std::hash<uint64_t>, std::equal_to<uint64_t>, EvictionPolicy>;
+
+/**
+ * @brief Draws ranks in [0, keyRange) with probability proportional to 1 / (rank + 1)^exponent, by binary search
+ * in the cumulative distribution. Rank 0 is the most popular key.
+ */
+class ZipfDistribution
+{
+    std::vector<double> m_cumulative;
+
+public:
+    ZipfDistribution(size_t keyRange, double exponent) : m_cumulative(keyRange)
+    {
+        double sum = 0;
+        for(size_t rank = 0; rank < keyRange; rank++)
+        {
+            sum += 1.0 / std::pow(double(rank + 1), exponent);
+            m_cumulative[rank] = sum;
+        }
+        for(double &value : m_cumulative)
+        {
+            value /= sum;
+        }
+    }
+
+    template<class Generator>
+    uint64_t operator()(Generator &generator)
+    {
+        const double u = std::uniform_real_distribution<double>(0, 1)(generator);
+        return std::lower_bound(m_cumulative.begin(), m_cumulative.end(), u) - m_cumulative.begin();
+    }
+};
+
+/**
+ * @brief The keys are scrambled ranks, so that popular keys are spread over the buckets.
+ */
+uint64_t keyOf(uint64_t rank)
+{
+    return rank * 0x9E3779B97F4A7C15ull;
+}
+
+std::vector<uint64_t> zipfTrace(size_t keyRange, size_t requests, double exponent)
+{
+    std::mt19937_64 generator(1);
+    ZipfDistribution zipf(keyRange, exponent);
+    std::vector<uint64_t> trace(requests);
+    for(uint64_t &key : trace)
+    {
+        key = keyOf(zipf(generator));
+    }
+    return trace;
+}
+
+std::vector<uint64_t> scanTrace(size_t keyRange, size_t requests, size_t cacheSize)
+{
+    std::vector<uint64_t> trace = zipfTrace(keyRange, requests, 0.99);
+    /*Scanned keys are outside the key range, and every scan uses new ones*/
+    uint64_t scanned = keyRange;
+    for(size_t start = 10 * cacheSize; start + cacheSize <= trace.size(); start += 10 * cacheSize)
+    {
+        for(size_t i = start; i < start + cacheSize; i++)
+        {
+            trace[i] = keyOf(scanned++);
+        }
+    }
+    return trace;
+}
+
+/**
+ * @brief Prints the hit ratio and the million requests per second of a cache of cacheSize on a trace.
+ */
+template<class EvictionPolicy>
+void run(const char *policy, const std::vector<uint64_t> &trace, size_t cacheSize)
+{
+    CacheMap<EvictionPolicy> cache(cacheSize);
+    size_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(uint64_t key : trace)
+    {
+        if(cache.find(key) != cache.end())
+        {
+            hits++;
+        }
+        else
+        {
+            cache.insert({key, key});
+        }
+    }
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    std::printf("  %-8s %10.4f %12.2f\n", policy, double(hits) / trace.size(), trace.size() / seconds.count() / 1e6);
+}
+
+void runAll(const char *name, const std::vector<uint64_t> &trace, size_t cacheSize)
+{
+    std::printf("%s, cache size %zu\n", name, cacheSize);
+    std::printf("  %-8s %10s %12s\n", "policy", "hit ratio", "Mreq/s");
+    run<FIFOHashMapFifoEviction>("fifo", trace, cacheSize);
+    run<FIFOHashMapLruEviction>("lru", trace, cacheSize);
+    run<FIFOHashMapClockEviction>("clock", trace, cacheSize);
+    run<FIFOHashMapSieveEviction>("sieve", trace, cacheSize);
+    run<FIFOHashMapS3FifoEviction<>>("s3-fifo", trace, cacheSize);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const size_t keyRange = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t requests = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    const size_t cacheSizes[] = {keyRange / 1000, keyRange / 100, keyRange / 10};
+
+    for(double exponent : {0.8, 0.99, 1.2})
+    {
+        const std::vector<uint64_t> trace = zipfTrace(keyRange, requests, exponent);
+        char name[32];
+        std::snprintf(name, sizeof(name), "zipf %.2f", exponent);
+        for(size_t cacheSize : cacheSizes)
+        {
+            runAll(name, trace, std::max<size_t>(cacheSize, 1));
+        }
+    }
+    for(size_t cacheSize : cacheSizes)
+    {
+        cacheSize = std::max<size_t>(cacheSize, 1);
+        runAll("zipf+scan", scanTrace(keyRange, requests, cacheSize), cacheSize);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
+#include "../sh-data-struct/FIFOHashMap/FifoHashMapIngest.hpp"
+#include "../sh-data-struct/FIFOHashMap/SingleWriterFifoHashMap.hpp"
+
+TEST(FIFOHashMapIngestTest,SingleThread)
+{
+FIFOHashMap<int, std::string, 8> fifoHashMap;
+FIFOHashMapIngest<FIFOHashMap<int, std::string, 8>, 4> ingest(fifoHashMap);
+auto &producer = ingest.producer();
+
+EXPECT_TRUE(producer.try_push({1, "One"}));
+producer.push({2, "Two"});
+EXPECT_EQ(2, producer.pending());
+EXPECT_TRUE(fifoHashMap.empty());
+
+EXPECT_EQ(2, ingest.drain());
+EXPECT_EQ(0, producer.pending());
+EXPECT_EQ("One", fifoHashMap.find(1)->second);
+EXPECT_EQ("Two", fifoHashMap.find(2)->second);
+producer.flush();
+
+/*The buffer holds 4 elements*/
+for(int i = 3; i <= 6; i++)
+{
+EXPECT_TRUE(producer.try_push({i, std::to_string(i)}));
+}
+EXPECT_FALSE(producer.try_push({7, "7"}));
+EXPECT_EQ(2, ingest.drain(2));
+EXPECT_TRUE(producer.try_push({7, "7"}));
+EXPECT_EQ(3, ingest.drain());
+
+std::vector<int> order;
+for(auto &pair : fifoHashMap)
+{
+order.push_back(pair.first);
+}
+EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5, 6, 7}), order);
+
+/*Elements that were never drained are destroyed with the ingest*/
+producer.push({8, std::string(100, '8')});
+}
+
+/*Passes batches on to a FIFOHashMap and records their sizes*/
+struct BatchRecordingMap
+{
+using value_type = FIFOHashMap<int, std::string, 16>::value_type;
+
+size_t insert_batch(value_type *values, size_t count)
+{
+m_batches.push_back(count);
+return m_map.insert_batch(values, count);
+}
+
+FIFOHashMap<int, std::string, 16> m_map;
+std::vector<size_t> m_batches;
+};
+
+TEST(FIFOHashMapIngestTest,DrainsInBatches)
+{
+static_assert(FIFOHashMapIngestHasBatch<FIFOHashMap<int, int, 8>>::value);
+static_assert(!FIFOHashMapIngestHasBatch<SingleWriterFIFOHashMap<int, int, 8>>::value);
+
+BatchRecordingMap recordingMap;
+FIFOHashMapIngest<BatchRecordingMap, 4> ingest(recordingMap);
+auto &producer = ingest.producer();
+
+for(int i = 1; i <= 3; i++)
+{
+producer.push({i, std::string(50, 'a' + i)});
+}
+EXPECT_EQ(3, ingest.drain());
+EXPECT_EQ(std::vector<size_t>({3}), recordingMap.m_batches);
+
+/*The buffer wraps around after the fourth slot, so this batch is two stretches*/
+for(int i = 4; i <= 7; i++)
+{
+producer.push({i, std::string(50, 'a' + i)});
+}
+recordingMap.m_batches.clear();
+EXPECT_EQ(4, ingest.drain());
+EXPECT_EQ(std::vector<size_t>({1, 3}), recordingMap.m_batches);
+
+std::vector<int> order;
+for(auto &pair : recordingMap.m_map)
+{
+EXPECT_EQ(std::string(50, 'a' + pair.first), pair.second);
+order.push_back(pair.first);
+}
+EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5, 6, 7}), order);
+}
+
+TEST(FIFOHashMapIngestTest,ProducersKeepTheirOrder)
+{
+constexpr int producerCount = 4;
+constexpr int keysPerProducer = 20000;
+using Map = FIFOHashMap<int, int, producerCount * keysPerProducer>;
+Map fifoHashMap;
+FIFOHashMapIngest<Map, 256> ingest(fifoHashMap);
+std::atomic<int> finished{0};
+
+std::vector<std::thread> producers;
+for(int p = 0; p < producerCount; p++)
+{
+producers.emplace_back([&ingest, &finished, p]()
+{
+auto &producer = ingest.producer();
+for(int i = 0; i < keysPerProducer; i++)
+{
+producer.push({p * keysPerProducer + i, p});
+}
+producer.flush();
+EXPECT_EQ(0, producer.pending());
+finished++;
+});
+}
+while(finished.load() < producerCount)
+{
+ingest.drain();
+}
+for(std::thread &producer : producers)
+{
+producer.join();
+}
+
+EXPECT_EQ(producerCount * keysPerProducer, fifoHashMap.size());
+std::vector<int> last(producerCount, -1);
+for(auto &pair : fifoHashMap)
+{
+ASSERT_LT(last[pair.second], pair.first);
+last[pair.second] = pair.first;
+}
+}
+
+TEST(FIFOHashMapIngestTest,FlushMakesWritesVisible)
+{
+constexpr int producerCount = 4;
+constexpr int keysPerProducer = 2000;
+using Map = SingleWriterFIFOHashMap<int, int, producerCount * keysPerProducer>;
+Map singleWriterMap;
+FIFOHashMapIngest<Map, 64> ingest(singleWriterMap);
+std::atomic<int> finished{0};
+std::atomic<int> missing{0};
+
+std::vector<std::thread> producers;
+for(int p = 0; p < producerCount; p++)
+{
+producers.emplace_back([&ingest, &singleWriterMap, &finished, &missing, p]()
+{
+auto &producer = ingest.producer();
+for(int i = 0; i < keysPerProducer; i++)
+{
+const int key = p * keysPerProducer + i;
+producer.push({key, -key});
+if(i % 100 == 99)
+{
+producer.flush();
+for(int j = i - 99; j <= i; j++)
+{
+if(singleWriterMap.find(p * keysPerProducer + j) != -(p * keysPerProducer + j))
+{
+missing++;
+}
+}
+}
+}
+finished++;
+});
+}
+while(finished.load() < producerCount)
+{
+ingest.drain();
+}
+for(std::thread &producer : producers)
+{
+producer.join();
+}
+
+EXPECT_EQ(0, missing.load());
+EXPECT_EQ(producerCount * keysPerProducer, singleWriterMap.size());
+}
@@ -4,6 +4,22 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include "../sh-data-struct/FIFOHashMap/FifoHashMap.hpp"
 #define MAX_ELEMENTS_TEST 10
 struct FIFOHashMapTest: public ::testing::Test
@@ -222,15 +238,15 @@ EXPECT_EQ(oldSize-1, pFifoMap->size());
 
 oldSize = pFifoMap->size();
 /*Insert a new element and remove it
- * Should return an iterator to the new last element.
+ * Should return end() - nothing follows the last element.
  * */
 insertResultIter = pFifoMap->insert({1,"One"}).first;
 oldSize = pFifoMap->size();
 
 eraseResultIter = pFifoMap->erase(insertResultIter);
 EXPECT_EQ(oldSize-1, pFifoMap->size());
-EXPECT_EQ(eraseResultIter->first, 4);
-EXPECT_EQ(eraseResultIter->second, (*pFifoMap)[4]);
+EXPECT_TRUE(pFifoMap->end() == eraseResultIter);
+EXPECT_EQ(4, std::prev(pFifoMap->end())->first);
 
 }
 
@@ -531,3 +547,2251 @@ i++;
 }
 
 }
+
+/**
+ * @brief Random insert/erase/move/pop churn, checked against a std::list based reference of the FIFO order.
+ * Exercises the backward shift deletion of the bucket array and the reuse of freed cells.
+ */
+template<class Map>
+void checkChurn(int keyRange)
+{
+constexpr size_t capacity = Map::capacity();
+Map fifoMap;
+std::list<std::pair<int,int>> reference;
+std::mt19937 generator(42);
+std::uniform_int_distribution<int> keyDistribution(0, keyRange);
+
+auto referenceFind = [&reference](int key)
+{
+return std::find_if(reference.begin(), reference.end(), [key](const std::pair<int,int> &p){return p.first == key;});
+};
+
+for(int step = 0; step < 20000; step++)
+{
+const int key = keyDistribution(generator);
+switch(step % 5)
+{
+case 0:
+case 1:
+{
+auto insertResult = fifoMap.insert({key, step});
+EXPECT_EQ(referenceFind(key) == reference.end(), insertResult.second);
+if(insertResult.second)
+{
+if(reference.size() == capacity)
+{
+reference.pop_front();
+}
+reference.emplace_back(key, step);
+}
+break;
+}
+case 2:
+{
+auto referenceIter = referenceFind(key);
+EXPECT_EQ(referenceIter == reference.end() ? 0 : 1, fifoMap.erase(key));
+if(referenceIter != reference.end())
+{
+reference.erase(referenceIter);
+}
+break;
+}
+case 3:
+{
+fifoMap.moveElementToTail(key);
+auto referenceIter = referenceFind(key);
+if(referenceIter != reference.end())
+{
+reference.splice(reference.end(), reference, referenceIter);
+}
+break;
+}
+default:
+{
+fifoMap.moveElementToHead(key);
+auto referenceIter = referenceFind(key);
+if(referenceIter != reference.end())
+{
+reference.splice(reference.begin(), reference, referenceIter);
+}
+break;
+}
+}
+
+ASSERT_EQ(reference.size(), fifoMap.size());
+}
+
+auto referenceIter = reference.begin();
+for(auto it = fifoMap.begin(); it != fifoMap.end(); it++)
+{
+EXPECT_EQ(referenceIter->first, it->first);
+EXPECT_EQ(referenceIter->second, it->second);
+EXPECT_EQ(referenceIter->second, fifoMap.find(it->first)->second);
+++referenceIter;
+}
+}
+
+TEST(FIFOHashMapStorageTest,ChurnMatchesReferenceModel)
+{
+checkChurn<FIFOHashMap<int,int,64>>(200);
+}
+
+TEST_F(FIFOHashMapTest,CopyAndMovePreserveOrder)
+{
+for(int i = 0 ; i < MAX_ELEMENTS_TEST; i++)
+{
+pFifoMap->insert(std::make_pair(i, strArray[i]));
+}
+
+FIFOHashMap<int,std::string,MAX_ELEMENTS_TEST> copiedMap(*pFifoMap);
+FIFOHashMap<int,std::string,MAX_ELEMENTS_TEST> movedMap(std::move(*pFifoMap));
+EXPECT_TRUE(pFifoMap->empty());
+EXPECT_EQ(MAX_ELEMENTS_TEST, copiedMap.size());
+EXPECT_EQ(MAX_ELEMENTS_TEST, movedMap.size());
+
+int i = 0;
+auto movedIter = movedMap.begin();
+for(auto it = copiedMap.begin(); it != copiedMap.end(); it++)
+{
+EXPECT_EQ(i, it->first);
+EXPECT_EQ(strArray[i], it->second);
+EXPECT_EQ(i, movedIter->first);
+EXPECT_EQ(strArray[i], movedIter->second);
+++movedIter;
+i++;
+}
+
+/*The moved-from map is still usable - it gave its storage away and allocates again*/
+EXPECT_EQ(sizeof(*pFifoMap), pFifoMap->memory_usage());
+EXPECT_TRUE(pFifoMap->begin() == pFifoMap->end());
+(*pFifoMap)[1] = "One";
+EXPECT_EQ("One", pFifoMap->find(1)->second);
+EXPECT_LT(sizeof(*pFifoMap), pFifoMap->memory_usage());
+}
+
+using RingFIFOHashMap = FIFOHashMap<int, std::string, MAX_ELEMENTS_TEST,
+        std::allocator<std::pair<const int, std::string>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapRingOrder>;
+
+TEST(FIFOHashMapRingOrderTest,CellsHaveNoLinks)
+{
+/*The pair and the cached hash of the key*/
+EXPECT_EQ(sizeof(std::pair<const int,int>) + sizeof(uint32_t), sizeof(FIFOHashMapCell<int,int,false>));
+EXPECT_LT(sizeof(FIFOHashMapCell<int,int,false>), sizeof(FIFOHashMapCell<int,int>));
+}
+
+TEST(FIFOHashMapRingOrderTest,InsertWrapsAround)
+{
+RingFIFOHashMap ringMap;
+EXPECT_TRUE(ringMap.empty());
+EXPECT_TRUE(ringMap.begin() == ringMap.end());
+
+for(int i = 0; i < 3 * MAX_ELEMENTS_TEST + 3; i++)
+{
+auto insertResult = ringMap.insert({i, std::to_string(i)});
+EXPECT_TRUE(insertResult.second);
+EXPECT_EQ(i, insertResult.first->first);
+EXPECT_FALSE(ringMap.insert({i, "duplicate"}).second);
+}
+EXPECT_EQ(MAX_ELEMENTS_TEST, ringMap.size());
+EXPECT_TRUE(ringMap.isFull());
+
+/*Only the last MAX_ELEMENTS_TEST elements are left, in insertion order*/
+int expectedKey = 2 * MAX_ELEMENTS_TEST + 3;
+for(auto it = ringMap.begin(); it != ringMap.end(); it++)
+{
+EXPECT_EQ(expectedKey, it->first);
+EXPECT_EQ(std::to_string(expectedKey), it->second);
+EXPECT_TRUE(ringMap.find(expectedKey) != ringMap.end());
+expectedKey++;
+}
+EXPECT_EQ(3 * MAX_ELEMENTS_TEST + 3, expectedKey);
+EXPECT_TRUE(ringMap.find(2 * MAX_ELEMENTS_TEST + 2) == ringMap.end());
+
+for(auto it = ringMap.rbegin(); it != ringMap.rend(); it++)
+{
+expectedKey--;
+EXPECT_EQ(expectedKey, it->first);
+}
+EXPECT_EQ(2 * MAX_ELEMENTS_TEST + 3, expectedKey);
+}
+
+TEST(FIFOHashMapRingOrderTest,PopAndSquareBrackets)
+{
+RingFIFOHashMap ringMap;
+for(int i = 0; i < MAX_ELEMENTS_TEST + 4; i++)
+{
+ringMap[i] = std::to_string(i);
+}
+ringMap.pop();
+ringMap.pop();
+EXPECT_EQ(MAX_ELEMENTS_TEST - 2, ringMap.size());
+EXPECT_EQ(6, ringMap.begin()->first);
+
+/*The free cells left by pop are refilled before anything is evicted*/
+ringMap[100] = "Hundred";
+ringMap[101] = "Hundred and one";
+EXPECT_EQ(6, ringMap.begin()->first);
+EXPECT_EQ(101, ringMap.rbegin()->first);
+EXPECT_EQ("Hundred", ringMap[100]);
+
+ringMap[102];
+EXPECT_EQ(7, ringMap.begin()->first);
+EXPECT_EQ("", ringMap.find(102)->second);
+
+ringMap.clear();
+EXPECT_TRUE(ringMap.empty());
+ringMap[1] = "One";
+EXPECT_EQ(1, ringMap.begin()->first);
+EXPECT_EQ(1, ringMap.rbegin()->first);
+}
+
+/**
+ * @brief Hash that counts its calls and collides a lot, to get long probe sequences.
+ */
+struct CountingHash
+{
+static size_t calls;
+size_t operator()(int key) const
+{
+calls++;
+return static_cast<size_t>(key % 7);
+}
+};
+size_t CountingHash::calls = 0;
+
+TEST(FIFOHashMapHashTest,InsertAtCapacityHashesOnce)
+{
+FIFOHashMap<int, int, MAX_ELEMENTS_TEST, std::allocator<std::pair<const int, int>>, CountingHash> fifoMap;
+for(int i = 0; i < MAX_ELEMENTS_TEST; i++)
+{
+fifoMap[i] = i;
+}
+
+CountingHash::calls = 0;
+fifoMap.insert({100, 100});
+EXPECT_EQ(1, CountingHash::calls);
+fifoMap[101] = 101;
+EXPECT_EQ(2, CountingHash::calls);
+fifoMap.pop();
+EXPECT_EQ(2, CountingHash::calls);
+
+/*Pre-hashed overloads never call the hash function*/
+const size_t hash = fifoMap.hash_function()(102);
+CountingHash::calls = 0;
+EXPECT_TRUE(fifoMap.insert({102, 102}, hash).second);
+EXPECT_FALSE(fifoMap.insert({102, 0}, hash).second);
+EXPECT_EQ(102, fifoMap.find(102, hash)->second);
+EXPECT_TRUE(fifoMap.find(103, fifoMap.hash_function()(103)) == fifoMap.end());
+EXPECT_EQ(1, CountingHash::calls);
+}
+
+/**
+ * @brief Insert-at-capacity places the new key in the bucket freed by the eviction when it is on its probe path.
+ * Checked with a colliding hash against a reference, over a long sliding window.
+ */
+TEST(FIFOHashMapHashTest,SlidingWindowWithCollisions)
+{
+FIFOHashMap<int, int, MAX_ELEMENTS_TEST, std::allocator<std::pair<const int, int>>, CountingHash> fifoMap;
+std::mt19937 generator(7);
+std::uniform_int_distribution<int> keyDistribution(0, 40);
+std::list<int> reference;
+for(int step = 0; step < 5000; step++)
+{
+const int key = keyDistribution(generator);
+const bool isNew = std::find(reference.begin(), reference.end(), key) == reference.end();
+EXPECT_EQ(isNew, fifoMap.insert({key, step}).second);
+if(isNew)
+{
+if(reference.size() == MAX_ELEMENTS_TEST)
+{
+reference.pop_front();
+}
+reference.push_back(key);
+}
+for(int k : reference)
+{
+ASSERT_TRUE(fifoMap.find(k) != fifoMap.end());
+}
+}
+auto referenceIter = reference.begin();
+for(auto it = fifoMap.begin(); it != fifoMap.end(); it++)
+{
+EXPECT_EQ(*referenceIter, it->first);
+++referenceIter;
+}
+}
+
+/**
+ * @brief Churn at 90% bucket load with only 7 distinct hashes: probe sequences cross many full groups, and erasing
+ * shifts buckets back across them.
+ */
+TEST(FIFOHashMapHashTest,ChurnAtMaxLoadWithCollisions)
+{
+/*8 groups of 7 buckets, 50 of them in use*/
+using Map = FIFOHashMap<int, int, 50, std::allocator<std::pair<const int, int>>, CountingHash, std::equal_to<int>,
+        FIFOHashMapMaxLoad<90>>;
+EXPECT_EQ(56, Map::bucket_count());
+checkChurn<Map>(150);
+}
+
+TEST(FIFOHashMapHashTest,GroupMatchesControlBytes)
+{
+FIFOHashMapBucketGroup group;
+EXPECT_EQ(FIFOHashMapBucketGroup::ALL, group.matchEmpty());
+EXPECT_EQ(0, group.match(0));
+
+/*Tags are the top 7 bits of the hash*/
+EXPECT_EQ(0x7f, FIFOHashMapBucketGroup::tag(UINT32_MAX));
+EXPECT_EQ(0, FIFOHashMapBucketGroup::tag(0x01ffffff));
+group.m_control[0] = 0x00;
+group.m_control[2] = 0x7f;
+group.m_control[3] = 0x00;
+group.m_control[6] = 0x01;
+EXPECT_EQ(0x9, group.match(0x00));
+EXPECT_EQ(0x4, group.match(0x7f));
+EXPECT_EQ(0x40, group.match(0x01));
+EXPECT_EQ(0, group.match(0x02));
+EXPECT_EQ(0x32, group.matchEmpty());
+
+/*The padding byte is never reported*/
+for(size_t i = 0; i < FIFOHashMapBucketGroup::WIDTH; i++)
+{
+group.m_control[i] = 0x05;
+}
+EXPECT_EQ(FIFOHashMapBucketGroup::ALL, group.match(0x05));
+EXPECT_EQ(0, group.matchEmpty());
+}
+
+TEST(FIFOHashMapEmplaceTest,MoveOnlyValues)
+{
+FIFOHashMap<int, std::unique_ptr<int>, 3> fifoMap;
+EXPECT_TRUE(fifoMap.emplace(1, std::make_unique<int>(1)).second);
+EXPECT_TRUE(fifoMap.try_emplace(2, std::make_unique<int>(2)).second);
+EXPECT_TRUE(fifoMap.insert_or_assign(3, std::make_unique<int>(3)).second);
+EXPECT_TRUE(fifoMap.insert(std::make_pair(4, std::make_unique<int>(4))).second);
+fifoMap[5] = std::make_unique<int>(5);
+
+EXPECT_EQ(3, fifoMap.size());
+int expectedKey = 3;
+for(auto it = fifoMap.begin(); it != fifoMap.end(); it++)
+{
+EXPECT_EQ(expectedKey, it->first);
+EXPECT_EQ(expectedKey, *it->second);
+expectedKey++;
+}
+
+EXPECT_FALSE(fifoMap.insert_or_assign(4, std::make_unique<int>(40)).second);
+EXPECT_EQ(40, *fifoMap.find(4)->second);
+EXPECT_EQ(3, fifoMap.begin()->first);
+}
+
+TEST_F(FIFOHashMapTest,TryEmplaceDoesNotMoveOnHit)
+{
+pFifoMap->insert({1,"One"});
+std::string value = "Another one";
+auto result = pFifoMap->try_emplace(1, std::move(value));
+EXPECT_FALSE(result.second);
+EXPECT_EQ("Another one", value);
+EXPECT_EQ("One", result.first->second);
+
+/*On insertion the string is moved in - the same heap buffer ends up in the map*/
+std::string longValue(100, 'x');
+const char *buffer = longValue.data();
+result = pFifoMap->try_emplace(2, std::move(longValue));
+EXPECT_TRUE(result.second);
+EXPECT_EQ(buffer, result.first->second.data());
+
+std::string constructedInPlace(3, 'y');
+EXPECT_TRUE(pFifoMap->try_emplace(3, 3, 'y').second);
+EXPECT_EQ(constructedInPlace, pFifoMap->find(3)->second);
+}
+
+TEST_F(FIFOHashMapTest,InsertOrAssign)
+{
+for(int i = 0 ; i < MAX_ELEMENTS_TEST; i++)
+{
+pFifoMap->insert(std::make_pair(i, strArray[i]));
+}
+auto result = pFifoMap->insert_or_assign(0, "Zero again");
+EXPECT_FALSE(result.second);
+EXPECT_EQ("Zero again", result.first->second);
+/*Assignment does not change the order - 0 is still the oldest and is evicted next*/
+EXPECT_EQ(0, pFifoMap->begin()->first);
+
+result = pFifoMap->insert_or_assign(MAX_ELEMENTS_TEST, "Ten");
+EXPECT_TRUE(result.second);
+EXPECT_TRUE(pFifoMap->find(0) == pFifoMap->end());
+EXPECT_EQ(MAX_ELEMENTS_TEST, pFifoMap->rbegin()->first);
+}
+
+TEST_F(FIFOHashMapTest,EmplaceForms)
+{
+EXPECT_TRUE(pFifoMap->emplace(1, "One").second);
+EXPECT_FALSE(pFifoMap->emplace(1, "Uno").second);
+EXPECT_TRUE(pFifoMap->emplace(std::make_pair(2, std::string("Two"))).second);
+EXPECT_TRUE(pFifoMap->emplace(std::piecewise_construct, std::forward_as_tuple(3), std::forward_as_tuple(5, 'c')).second);
+EXPECT_FALSE(pFifoMap->emplace(std::piecewise_construct, std::forward_as_tuple(3), std::forward_as_tuple(1, 'd')).second);
+
+EXPECT_EQ("One", (*pFifoMap)[1]);
+EXPECT_EQ("Two", (*pFifoMap)[2]);
+EXPECT_EQ("ccccc", (*pFifoMap)[3]);
+EXPECT_EQ(3, pFifoMap->size());
+
+/*A std::pair<K, V> temporary is moved in, key and value*/
+std::pair<int, std::string> pair{4, std::string(100, 'z')};
+const char *buffer = pair.second.data();
+auto result = pFifoMap->insert(std::move(pair));
+EXPECT_TRUE(result.second);
+EXPECT_EQ(buffer, result.first->second.data());
+}
+
+TEST(FIFOHashMapMemoryTest,MemoryUsage)
+{
+using IntMap = FIFOHashMap<int, int, 1000>;
+IntMap fifoMap;
+EXPECT_EQ(1000, IntMap::capacity());
+/*At most 87% full, in a power of two groups of 7 buckets*/
+EXPECT_EQ(256 * 7, IntMap::bucket_count());
+
+/*Each cell is the pair, the cached hash and two 32-bit links; each bucket is a cell index and a hash, 7 of them and
+ *their control bytes in a cache line*/
+EXPECT_EQ(sizeof(std::pair<const int, int>) + 3 * sizeof(uint32_t), sizeof(FIFOHashMapCell<int, int>));
+EXPECT_EQ(64, sizeof(FIFOHashMapBucketGroup));
+const size_t expected = sizeof(IntMap) + 1000 * sizeof(FIFOHashMapCell<int, int>) + 256 * sizeof(FIFOHashMapBucketGroup);
+EXPECT_EQ(expected, fifoMap.memory_usage());
+
+/*Preallocated - filling the map does not change it*/
+for(int i = 0; i < 2000; i++)
+{
+fifoMap[i] = i;
+}
+EXPECT_EQ(expected, fifoMap.memory_usage());
+EXPECT_DOUBLE_EQ(static_cast<double>(expected) / 1000, fifoMap.bytes_per_entry());
+EXPECT_LT(fifoMap.bytes_per_entry(), 40.0);
+}
+
+struct CollectingSink
+{
+std::vector<std::pair<int, std::string>> *pEvicted = nullptr;
+void operator()(int &&key, std::string &&value)
+{
+pEvicted->emplace_back(key, std::move(value));
+}
+};
+
+TEST(FIFOHashMapEvictionTest,SinkReceivesEvictedElements)
+{
+FIFOHashMap<int, std::string, 3, std::allocator<std::pair<const int, std::string>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapEvictionSink<CollectingSink>> fifoMap;
+std::vector<std::pair<int, std::string>> evicted;
+fifoMap.eviction_sink().pEvicted = &evicted;
+
+for(int i = 0; i < 5; i++)
+{
+fifoMap.insert({i, std::to_string(i) + " - a string long enough to be allocated"});
+}
+fifoMap[5];
+ASSERT_EQ(3, evicted.size());
+for(int i = 0; i < 3; i++)
+{
+EXPECT_EQ(i, evicted[i].first);
+EXPECT_EQ(std::to_string(i) + " - a string long enough to be allocated", evicted[i].second);
+}
+
+/*Explicit removals do not go to the sink*/
+fifoMap.pop();
+fifoMap.erase(4);
+fifoMap.clear();
+EXPECT_EQ(3, evicted.size());
+}
+
+TEST(FIFOHashMapEvictionTest,SinkInRingOrder)
+{
+std::vector<int> evicted;
+FIFOHashMap<int, int, 4, std::allocator<std::pair<const int, int>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapRingOrder, FIFOHashMapEvictionSink<std::function<void(int&&, int&&)>>> fifoMap;
+fifoMap.eviction_sink() = [&evicted](int &&key, int &&value) { evicted.push_back(key * 100 + value); };
+for(int i = 0; i < 10; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ((std::vector<int>{0, 101, 202, 303, 404, 505}), evicted);
+}
+
+TEST_F(FIFOHashMapTest,InsertReturnsEvicted)
+{
+std::optional<std::pair<int, std::string>> evicted;
+for(int i = 0; i < MAX_ELEMENTS_TEST; i++)
+{
+EXPECT_TRUE(pFifoMap->insert({i, strArray[i]}, evicted).second);
+EXPECT_FALSE(evicted.has_value());
+}
+
+EXPECT_TRUE(pFifoMap->insert({10, "Ten"}, evicted).second);
+ASSERT_TRUE(evicted.has_value());
+EXPECT_EQ(0, evicted->first);
+EXPECT_EQ("Zero", evicted->second);
+
+/*Existing key - nothing is inserted or evicted*/
+EXPECT_FALSE(pFifoMap->insert({10, "Ten"}, evicted).second);
+EXPECT_FALSE(evicted.has_value());
+EXPECT_EQ(1, pFifoMap->begin()->first);
+}
+
+TEST_F(FIFOHashMapTest,PopAndDrainMoveOut)
+{
+for(int i = 0; i < MAX_ELEMENTS_TEST; i++)
+{
+pFifoMap->insert({i, strArray[i]});
+}
+
+std::pair<int, std::string> oldest;
+EXPECT_TRUE(pFifoMap->pop(oldest));
+EXPECT_EQ(0, oldest.first);
+EXPECT_EQ("Zero", oldest.second);
+
+std::vector<std::pair<int, std::string>> drained;
+EXPECT_EQ(4, pFifoMap->drain(4, std::back_inserter(drained)));
+ASSERT_EQ(4, drained.size());
+for(int i = 0; i < 4; i++)
+{
+EXPECT_EQ(i + 1, drained[i].first);
+EXPECT_EQ(strArray[i + 1], drained[i].second);
+EXPECT_TRUE(pFifoMap->find(i + 1) == pFifoMap->end());
+}
+EXPECT_EQ(5, pFifoMap->size());
+EXPECT_EQ(5, pFifoMap->begin()->first);
+
+/*Asking for more than there is drains the map*/
+EXPECT_EQ(5, pFifoMap->drain(100, std::back_inserter(drained)));
+EXPECT_EQ(9, drained.back().first);
+EXPECT_TRUE(pFifoMap->empty());
+EXPECT_FALSE(pFifoMap->pop(oldest));
+EXPECT_EQ(0, oldest.first);
+}
+
+using StatsFIFOHashMap = FIFOHashMap<int, int, 4, std::allocator<std::pair<const int, int>>, std::hash<int>,
+        std::equal_to<int>, FIFOHashMapStats>;
+
+TEST(FIFOHashMapStatsTest,CountsOperations)
+{
+/*Without the policy there are no counters*/
+EXPECT_TRUE(std::is_empty<FIFOHashMapCounters<false>>::value);
+EXPECT_EQ(sizeof(FIFOHashMap<int, int, 4>) + sizeof(FIFOHashMapStatistics), sizeof(StatsFIFOHashMap));
+
+StatsFIFOHashMap fifoMap;
+fifoMap.insert({1, 1});
+fifoMap.insert({1, 2});
+fifoMap.emplace(2, 2);
+fifoMap.try_emplace(2, 3);
+fifoMap[3] = 3;
+fifoMap[3]++;
+EXPECT_TRUE(fifoMap.find(1) != fifoMap.end());
+EXPECT_TRUE(fifoMap.find(9) == fifoMap.end());
+fifoMap.insert({4, 4});
+/*Evicts 1*/
+fifoMap.insert({5, 5});
+fifoMap.moveElementToTail(2);
+fifoMap.moveElementToHead(9);
+fifoMap.moveElementToHead(5);
+EXPECT_EQ(1, fifoMap.erase(4));
+EXPECT_EQ(0, fifoMap.erase(9));
+fifoMap.pop();
+std::vector<std::pair<int, int>> drained;
+EXPECT_EQ(1, fifoMap.drain(1, std::back_inserter(drained)));
+const int keys[] = {2, 3};
+uint64_t found = 0;
+EXPECT_EQ(1, fifoMap.contains_batch(keys, 2, &found));
+
+FIFOHashMapStatistics stats = fifoMap.stats();
+EXPECT_EQ(3, stats.m_hits);
+EXPECT_EQ(3, stats.m_misses);
+EXPECT_EQ(0.5, stats.hit_ratio());
+EXPECT_EQ(5, stats.m_insertions);
+EXPECT_EQ(2, stats.m_duplicates);
+EXPECT_EQ(1, stats.m_evictions);
+EXPECT_EQ(1, stats.m_erasures);
+EXPECT_EQ(1, stats.m_movesToTail);
+EXPECT_EQ(1, stats.m_movesToHead);
+EXPECT_EQ(2, stats.m_pops);
+/*A single group - every probe reads just the one*/
+EXPECT_EQ(17, stats.m_probes);
+EXPECT_EQ(17, stats.m_probeSteps);
+EXPECT_EQ(1.0, stats.average_probe_length());
+
+/*clear is not counted as pops*/
+fifoMap.clear();
+EXPECT_EQ(2, fifoMap.stats().m_pops);
+fifoMap.reset_stats();
+stats = fifoMap.stats();
+EXPECT_EQ(0, stats.m_insertions);
+EXPECT_EQ(0, stats.m_probes);
+EXPECT_EQ(0.0, stats.hit_ratio());
+EXPECT_EQ(0.0, stats.average_probe_length());
+}
+
+/*All the counters of stats are 0*/
+void expectNoCounts(const FIFOHashMapStatistics &stats)
+{
+const uint64_t counters[] = {stats.m_hits, stats.m_misses, stats.m_insertions, stats.m_duplicates, stats.m_evictions,
+                             stats.m_erasures, stats.m_movesToTail, stats.m_movesToHead, stats.m_pops,
+                             stats.m_expirations, stats.m_probes, stats.m_probeSteps};
+for(uint64_t counter : counters)
+{
+EXPECT_EQ(0, counter);
+}
+}
+
+TEST(FIFOHashMapStatsTest,CopiesStartAtZero)
+{
+StatsFIFOHashMap fifoMap;
+for(int i = 0; i < 5; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_TRUE(fifoMap.find(9) == fifoMap.end());
+
+StatsFIFOHashMap copiedMap(fifoMap);
+EXPECT_EQ(4, copiedMap.size());
+expectNoCounts(copiedMap.stats());
+
+/*The counters the assigned map had are dropped too*/
+StatsFIFOHashMap assignedMap;
+assignedMap.insert({7, 7});
+assignedMap = fifoMap;
+EXPECT_EQ(4, assignedMap.size());
+expectNoCounts(assignedMap.stats());
+EXPECT_EQ(5, fifoMap.stats().m_insertions);
+}
+
+TEST(FIFOHashMapStatsTest,ProbeLengthWithCollisions)
+{
+/*Keys 0, 7, 14... share a home group - the 8th of them is in the group after it*/
+FIFOHashMap<int, int, 48, std::allocator<std::pair<const int, int>>, CountingHash, std::equal_to<int>,
+        FIFOHashMapStats> fifoMap;
+for(int i = 0; i < 8; i++)
+{
+fifoMap.insert({7 * i, i});
+}
+fifoMap.reset_stats();
+EXPECT_TRUE(fifoMap.find(0) != fifoMap.end());
+EXPECT_TRUE(fifoMap.find(49) != fifoMap.end());
+EXPECT_EQ(3, fifoMap.stats().m_probeSteps);
+}
+
+using LruFIFOHashMap = FIFOHashMap<int, int, 4, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapLruEviction>;
+
+template<class Map>
+std::vector<int> keysInOrder(Map &fifoMap)
+{
+std::vector<int> keys;
+for(const auto &pair : fifoMap)
+{
+keys.push_back(pair.first);
+}
+return keys;
+}
+
+TEST(FIFOHashMapEvictionPolicyTest,LruPromotesOnLookup)
+{
+LruFIFOHashMap fifoMap;
+for(int i = 1; i <= 4; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_TRUE(fifoMap.find(1) != fifoMap.end());
+fifoMap[2]++;
+const int keys[] = {3, 9};
+std::vector<LruFIFOHashMap::iterator> results(2, fifoMap.end());
+fifoMap.find_batch(keys, 2, results.data());
+EXPECT_EQ((std::vector<int>{4, 1, 2, 3}), keysInOrder(fifoMap));
+
+/*Evicts 4, the least recently used, instead of the oldest*/
+fifoMap.insert({5, 5});
+EXPECT_EQ((std::vector<int>{1, 2, 3, 5}), keysInOrder(fifoMap));
+
+/*Misses, contains_batch and duplicate inserts do not promote*/
+EXPECT_TRUE(fifoMap.find(4) == fifoMap.end());
+uint64_t found = 0;
+fifoMap.contains_batch(keys, 1, &found);
+EXPECT_FALSE(fifoMap.insert({1, 10}).second);
+fifoMap.insert({6, 6});
+EXPECT_EQ((std::vector<int>{2, 3, 5, 6}), keysInOrder(fifoMap));
+EXPECT_EQ(3, fifoMap[3]);
+EXPECT_EQ((std::vector<int>{2, 5, 6, 3}), keysInOrder(fifoMap));
+}
+
+TEST(FIFOHashMapEvictionPolicyTest,LruWithDynamicCapacity)
+{
+FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapLruEviction> fifoMap(4);
+for(int i = 1; i <= 4; i++)
+{
+fifoMap.insert({i, i});
+}
+fifoMap.find(1);
+fifoMap.find(2);
+/*Shrinking evicts the least recently used too*/
+fifoMap.set_capacity(2);
+EXPECT_EQ((std::vector<int>{1, 2}), keysInOrder(fifoMap));
+fifoMap.set_capacity(3);
+fifoMap.insert({5, 5});
+fifoMap.find(1);
+fifoMap.insert({6, 6});
+EXPECT_EQ((std::vector<int>{5, 1, 6}), keysInOrder(fifoMap));
+}
+
+/**
+ * @brief A plug-in policy: evicts the most recently inserted element and counts the removals it is told about.
+ */
+struct MostRecentEviction : FIFOHashMapFifoEviction
+{
+size_t m_erased = 0;
+
+template<class Order>
+void on_erase(Order&, uint32_t)
+{
+m_erased++;
+}
+
+template<class Order>
+uint32_t victim(Order &order)
+{
+return order.tail();
+}
+};
+
+TEST(FIFOHashMapEvictionPolicyTest,CustomPolicy)
+{
+std::vector<int> evicted;
+FIFOHashMap<int, int, 4, std::allocator<std::pair<const int, int>>, std::hash<int>,
+        std::equal_to<int>, FIFOHashMapEvictionSink<std::function<void(int&&, int&&)>>, MostRecentEviction> fifoMap;
+fifoMap.eviction_sink() = [&evicted](int &&key, int &&) { evicted.push_back(key); };
+for(int i = 1; i <= 6; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ((std::vector<int>{4, 5}), evicted);
+EXPECT_EQ((std::vector<int>{1, 2, 3, 6}), keysInOrder(fifoMap));
+fifoMap.erase(2);
+fifoMap.pop();
+EXPECT_EQ(4, fifoMap.eviction_policy().m_erased);
+EXPECT_EQ((std::vector<int>{3, 6}), keysInOrder(fifoMap));
+}
+
+template<class EvictionPolicy, size_t N = 4>
+using RecordingFIFOHashMap = FIFOHashMap<int, int, N, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapEvictionSink<std::function<void(int&&, int&&)>>,
+        EvictionPolicy>;
+
+TEST(FIFOHashMapEvictionPolicyTest,ClockGivesVisitedASecondChance)
+{
+std::vector<int> evicted;
+RecordingFIFOHashMap<FIFOHashMapClockEviction> fifoMap;
+fifoMap.eviction_sink() = [&evicted](int &&key, int &&) { evicted.push_back(key); };
+for(int i = 1; i <= 4; i++)
+{
+fifoMap.insert({i, i});
+}
+fifoMap.find(1);
+fifoMap.find(3);
+/*Hits only mark - the order is unchanged until an eviction*/
+EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), keysInOrder(fifoMap));
+EXPECT_TRUE(fifoMap.eviction_policy().visited(0));
+fifoMap.insert({5, 5});
+EXPECT_EQ((std::vector<int>{3, 4, 1, 5}), keysInOrder(fifoMap));
+fifoMap.insert({6, 6});
+EXPECT_EQ((std::vector<int>{1, 5, 3, 6}), keysInOrder(fifoMap));
+EXPECT_EQ((std::vector<int>{2, 4}), evicted);
+}
+
+TEST(FIFOHashMapEvictionPolicyTest,SieveKeepsVisitedInPlace)
+{
+std::vector<int> evicted;
+RecordingFIFOHashMap<FIFOHashMapSieveEviction> fifoMap;
+fifoMap.eviction_sink() = [&evicted](int &&key, int &&) { evicted.push_back(key); };
+for(int i = 1; i <= 4; i++)
+{
+fifoMap.insert({i, i});
+}
+fifoMap.find(1);
+fifoMap.find(3);
+fifoMap.insert({5, 5});
+EXPECT_EQ((std::vector<int>{1, 3, 4, 5}), keysInOrder(fifoMap));
+/*The hand continues from 3, not from the head*/
+fifoMap.find(1);
+fifoMap.insert({6, 6});
+fifoMap.insert({7, 7});
+EXPECT_EQ((std::vector<int>{1, 3, 6, 7}), keysInOrder(fifoMap));
+EXPECT_EQ((std::vector<int>{2, 4, 5}), evicted);
+/*Erasing the element under the hand moves it on*/
+fifoMap.erase(6);
+fifoMap.insert({8, 8});
+fifoMap.insert({9, 9});
+EXPECT_EQ((std::vector<int>{1, 3, 8, 9}), keysInOrder(fifoMap));
+EXPECT_EQ((std::vector<int>{2, 4, 5, 7}), evicted);
+}
+
+TEST(FIFOHashMapEvictionPolicyTest,S3FifoFiltersOneHitWonders)
+{
+std::vector<int> evicted;
+RecordingFIFOHashMap<FIFOHashMapS3FifoEviction<25>, 8> fifoMap;
+fifoMap.eviction_sink() = [&evicted](int &&key, int &&) { evicted.push_back(key); };
+for(int i = 1; i <= 8; i++)
+{
+fifoMap.insert({i, i});
+}
+fifoMap.find(1);
+fifoMap[2]++;
+/*1 and 2 were hit in the small queue and move to the main one, 3 is evicted to the ghost queue*/
+fifoMap.insert({9, 9});
+EXPECT_EQ((std::vector<int>{3}), evicted);
+EXPECT_EQ((std::pair<size_t, size_t>{6, 2}), fifoMap.eviction_policy().queue_sizes());
+/*A ghost comes back into the main queue*/
+fifoMap.insert({3, 3});
+EXPECT_EQ((std::vector<int>{3, 4}), evicted);
+EXPECT_EQ((std::pair<size_t, size_t>{5, 3}), fifoMap.eviction_policy().queue_sizes());
+
+/*A scan of new keys only goes through the small queue*/
+for(int i = 100; i < 120; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_TRUE(fifoMap.find(1) != fifoMap.end());
+EXPECT_TRUE(fifoMap.find(2) != fifoMap.end());
+EXPECT_TRUE(fifoMap.find(3) != fifoMap.end());
+EXPECT_EQ(8, fifoMap.size());
+EXPECT_EQ(22, evicted.size());
+}
+
+/**
+ * @brief Random inserts, lookups, erasures, pops and capacity changes under an eviction policy. What the sink receives
+ * must be exactly what left the map, and the map must stay within its capacity.
+ */
+template<class EvictionPolicy>
+void checkPolicyChurn()
+{
+FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapEvictionSink<std::function<void(int&&, int&&)>>,
+        EvictionPolicy> fifoMap(64);
+std::set<int> reference;
+fifoMap.eviction_sink() = [&reference](int &&key, int &&) { EXPECT_EQ(1, reference.erase(key)); };
+std::mt19937 generator(7);
+std::uniform_int_distribution<int> keyDistribution(0, 300);
+for(int step = 0; step < 20000; step++)
+{
+const int key = keyDistribution(generator);
+switch(step % 7)
+{
+case 0:
+case 1:
+case 2:
+if(fifoMap.insert({key, key}).second)
+{
+reference.insert(key);
+}
+break;
+case 3:
+case 4:
+ASSERT_EQ(reference.count(key) != 0, fifoMap.find(key) != fifoMap.end());
+break;
+case 5:
+EXPECT_EQ(reference.erase(key), fifoMap.erase(key));
+break;
+default:
+if(step % 700 == 6)
+{
+fifoMap.set_capacity(16 + key / 3);
+}
+else if(!fifoMap.empty())
+{
+reference.erase(fifoMap.begin()->first);
+fifoMap.pop();
+}
+break;
+}
+ASSERT_EQ(reference.size(), fifoMap.size());
+ASSERT_LE(fifoMap.size(), fifoMap.capacity());
+}
+
+auto copy = fifoMap;
+copy.eviction_sink() = [](int&&, int&&) {};
+for(int key : reference)
+{
+EXPECT_TRUE(copy.find(key) != copy.end());
+}
+for(int key = 1000; key < 1000 + int(copy.capacity()); key++)
+{
+copy.insert({key, key});
+}
+EXPECT_EQ(copy.capacity(), copy.size());
+}
+
+TEST(FIFOHashMapEvictionPolicyTest,ChurnKeepsSinkAndMapInStep)
+{
+checkPolicyChurn<FIFOHashMapLruEviction>();
+checkPolicyChurn<FIFOHashMapClockEviction>();
+checkPolicyChurn<FIFOHashMapSieveEviction>();
+checkPolicyChurn<FIFOHashMapS3FifoEviction<>>();
+}
+
+/**
+ * @brief A clock that only moves when the test says so.
+ */
+struct ManualClock
+{
+using duration = std::chrono::milliseconds;
+using rep = duration::rep;
+using period = duration::period;
+using time_point = std::chrono::time_point<ManualClock>;
+static constexpr bool is_steady = true;
+
+time_point m_now{};
+
+time_point now() const
+{
+return m_now;
+}
+
+void advance(int milliseconds)
+{
+m_now += duration(milliseconds);
+}
+};
+
+template<size_t N, class... Policies>
+using ExpiringFIFOHashMap = FIFOHashMap<int, int, N, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapExpiry<ManualClock>, Policies...>;
+
+TEST(FIFOHashMapExpiryTest,ExpireRemovesFromTheHead)
+{
+ExpiringFIFOHashMap<8, FIFOHashMapStats> fifoMap;
+EXPECT_EQ(ManualClock::duration::max(), fifoMap.ttl());
+fifoMap.set_ttl(std::chrono::milliseconds(10));
+fifoMap.insert({1, 1});
+fifoMap.insert({2, 2});
+fifoMap.clock().advance(5);
+fifoMap.insert({3, 3});
+fifoMap.emplace(4, 4);
+fifoMap.clock().advance(4);
+EXPECT_EQ(0, fifoMap.expire(fifoMap.clock().now()));
+fifoMap.clock().advance(1);
+EXPECT_EQ(2, fifoMap.expire(fifoMap.clock().now()));
+EXPECT_EQ((std::vector<int>{3, 4}), keysInOrder(fifoMap));
+
+fifoMap.clock().advance(5);
+std::vector<std::pair<int, int>> expired;
+EXPECT_EQ(2, fifoMap.expire(fifoMap.clock().now(), std::back_inserter(expired)));
+EXPECT_EQ((std::vector<std::pair<int, int>>{{3, 3}, {4, 4}}), expired);
+EXPECT_TRUE(fifoMap.empty());
+EXPECT_EQ(4, fifoMap.stats().m_expirations);
+}
+
+TEST(FIFOHashMapExpiryTest,LookupsSkipExpired)
+{
+ExpiringFIFOHashMap<8> fifoMap;
+fifoMap.set_ttl(std::chrono::milliseconds(10));
+fifoMap.insert({1, 1});
+fifoMap.clock().advance(5);
+fifoMap.insert({2, 2});
+fifoMap[3] = 3;
+fifoMap.clock().advance(7);
+EXPECT_TRUE(fifoMap.find(1) == fifoMap.end());
+EXPECT_EQ(2, fifoMap.size());
+EXPECT_EQ(2, fifoMap.find(2)->second);
+
+/*An insert replaces an expired element instead of keeping it, and the new one is stamped now*/
+fifoMap.insert({4, 4});
+fifoMap.clock().advance(3);
+EXPECT_TRUE(fifoMap.insert({2, 20}).second);
+EXPECT_EQ(0, fifoMap[3]);
+EXPECT_EQ((std::vector<int>{4, 2, 3}), keysInOrder(fifoMap));
+const int keys[] = {2, 4};
+uint64_t found = 0;
+fifoMap.clock().advance(9);
+EXPECT_EQ(1, fifoMap.contains_batch(keys, 2, &found));
+EXPECT_EQ(1, found);
+EXPECT_EQ((std::vector<int>{2, 3}), keysInOrder(fifoMap));
+
+/*Moved elements keep their age*/
+fifoMap.moveElementToTail(2);
+fifoMap.clock().advance(1);
+EXPECT_EQ(2, fifoMap.expire(fifoMap.clock().now()));
+EXPECT_TRUE(fifoMap.empty());
+}
+
+TEST(FIFOHashMapExpiryTest,RingOrderExpiresUpToTheFoundElement)
+{
+ExpiringFIFOHashMap<4, FIFOHashMapRingOrder> fifoMap;
+fifoMap.set_ttl(std::chrono::milliseconds(10));
+for(int i = 1; i <= 6; i++)
+{
+fifoMap.insert({i, i});
+fifoMap.clock().advance(1);
+}
+/*3 was inserted 10 ms ago - so were the ones before it*/
+fifoMap.clock().advance(6);
+EXPECT_TRUE(fifoMap.find(4) != fifoMap.end());
+EXPECT_TRUE(fifoMap.find(3) == fifoMap.end());
+EXPECT_EQ((std::vector<int>{4, 5, 6}), keysInOrder(fifoMap));
+fifoMap.clock().advance(2);
+EXPECT_EQ(2, fifoMap.expire(fifoMap.clock().now()));
+EXPECT_EQ((std::vector<int>{6}), keysInOrder(fifoMap));
+}
+
+TEST(FIFOHashMapExpiryTest,CapacityChangesAndCopiesKeepTheAge)
+{
+ExpiringFIFOHashMap<FIFOHashMapDynamicCapacity> fifoMap(4);
+ExpiringFIFOHashMap<FIFOHashMapDynamicCapacity, FIFOHashMapRingOrder> ringMap(3);
+fifoMap.set_ttl(std::chrono::milliseconds(10));
+ringMap.set_ttl(std::chrono::milliseconds(10));
+for(int i = 1; i <= 5; i++)
+{
+fifoMap.insert({i, i});
+ringMap.insert({i, i});
+fifoMap.clock().advance(1);
+ringMap.clock().advance(1);
+}
+fifoMap.erase(3);
+fifoMap.set_capacity(8);
+fifoMap.insert({6, 6});
+/*The ring wraps around - growing moves its head*/
+ringMap.set_capacity(6);
+fifoMap.set_capacity(3);
+EXPECT_EQ((std::vector<int>{4, 5, 6}), keysInOrder(fifoMap));
+
+fifoMap.clock().advance(8);
+ringMap.clock().advance(8);
+auto copy = fifoMap;
+auto ringCopy = ringMap;
+EXPECT_EQ(1, copy.expire(copy.clock().now()));
+EXPECT_EQ(2, ringCopy.expire(ringCopy.clock().now()));
+EXPECT_EQ((std::vector<int>{5, 6}), keysInOrder(copy));
+EXPECT_EQ((std::vector<int>{5}), keysInOrder(ringCopy));
+EXPECT_EQ(1, fifoMap.expire(fifoMap.clock().now()));
+EXPECT_EQ(2, ringMap.expire(ringMap.clock().now()));
+}
+
+TEST(FIFOHashMapSnapshotTest,SaveAndLoadKeepOrder)
+{
+const std::string path = testing::TempDir() + "fifo_map_snapshot.bin";
+FIFOHashMap<int, double, 1000> fifoMap;
+for(int i = 0; i < 1500; i++)
+{
+fifoMap.insert({i, i * 0.5});
+}
+fifoMap.erase(700);
+fifoMap.moveElementToTail(600);
+fifoMap.save(path);
+
+FIFOHashMap<int, double, 1000> loaded;
+loaded.insert({-1, -1});
+loaded.load(path);
+EXPECT_EQ(fifoMap.size(), loaded.size());
+EXPECT_TRUE(loaded.find(-1) == loaded.end());
+auto it = loaded.begin();
+for(const auto &pair : fifoMap)
+{
+ASSERT_EQ(pair, *it);
+++it;
+}
+EXPECT_EQ(600, loaded.rbegin()->first);
+EXPECT_EQ(350.5, loaded.find(701)->second);
+/*Loaded maps work as usual*/
+loaded.insert({5000, 1});
+loaded.insert({5001, 1});
+EXPECT_TRUE(loaded.find(500) == loaded.end());
+EXPECT_TRUE(loaded.find(501) != loaded.end());
+EXPECT_EQ(1000, loaded.size());
+
+/*A smaller map keeps the newest elements, and so does a ring*/
+FIFOHashMap<int, double, FIFOHashMapDynamicCapacity> small(10);
+small.load(path);
+EXPECT_EQ(10, small.size());
+EXPECT_EQ(1491, small.begin()->first);
+EXPECT_EQ(600, small.rbegin()->first);
+FIFOHashMap<int, double, 4, std::allocator<std::pair<const int, double>>, std::hash<int>,
+        std::equal_to<int>, FIFOHashMapRingOrder> ring;
+ring.insert({1, 1});
+ring.insert({2, 2});
+ring.insert({3, 3});
+ring.load(path);
+std::vector<int> keys;
+for(const auto &pair : ring)
+{
+keys.push_back(pair.first);
+}
+EXPECT_EQ((std::vector<int>{1497, 1498, 1499, 600}), keys);
+std::remove(path.c_str());
+}
+
+TEST(FIFOHashMapSnapshotTest,StringsAndEmptyMaps)
+{
+const std::string path = testing::TempDir() + "fifo_map_strings.bin";
+FIFOHashMap<std::string, std::string, 8> fifoMap;
+fifoMap.save(path);
+fifoMap.insert({"stale", "stale"});
+fifoMap.load(path);
+EXPECT_TRUE(fifoMap.empty());
+
+fifoMap.insert({"", "empty key"});
+fifoMap.insert({"a long key that does not fit in the small string buffer", "value"});
+fifoMap.insert({"c", ""});
+fifoMap.save(path);
+FIFOHashMap<std::string, std::string, 8> loaded;
+loaded.load(path);
+EXPECT_EQ(3, loaded.size());
+EXPECT_EQ("empty key", loaded.begin()->second);
+EXPECT_EQ("value", loaded.find("a long key that does not fit in the small string buffer")->second);
+EXPECT_EQ("", loaded.find("c")->second);
+std::remove(path.c_str());
+}
+
+TEST(FIFOHashMapSnapshotTest,BadFilesThrow)
+{
+const std::string path = testing::TempDir() + "fifo_map_bad.bin";
+FIFOHashMap<int, int, 8> fifoMap;
+EXPECT_THROW(fifoMap.load(testing::TempDir() + "no_such_snapshot.bin"), std::runtime_error);
+
+FIFOHashMap<int, int64_t, 8> otherTypes;
+otherTypes.insert({1, 1});
+otherTypes.save(path);
+EXPECT_THROW(fifoMap.load(path), std::runtime_error);
+
+for(int i = 0; i < 5; i++)
+{
+fifoMap.insert({i, i});
+}
+fifoMap.save(path);
+{
+std::ifstream in(path, std::ios::binary);
+std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+contents.resize(contents.size() - 3);
+std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+FIFOHashMap<int, int, 8> loaded;
+EXPECT_THROW(loaded.load(path), std::runtime_error);
+/*What was read before the end is there*/
+EXPECT_EQ(4, loaded.size());
+EXPECT_EQ(3, loaded.find(3)->second);
+
+{
+std::ofstream(path, std::ios::binary | std::ios::trunc) << "FIFOHMAQ and more";
+}
+EXPECT_THROW(loaded.load(path), std::runtime_error);
+std::remove(path.c_str());
+}
+
+using DynamicFIFOHashMap = FIFOHashMap<int, int, FIFOHashMapDynamicCapacity>;
+using DynamicRingFIFOHashMap = FIFOHashMap<int, int, FIFOHashMapDynamicCapacity,
+        std::allocator<std::pair<const int, int>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapRingOrder>;
+
+TEST(FIFOHashMapDynamicCapacityTest,CapacityIsSetAtRunTime)
+{
+DynamicFIFOHashMap fifoMap(3);
+EXPECT_EQ(3, fifoMap.capacity());
+EXPECT_EQ(7, fifoMap.bucket_count());
+for(int i = 0; i < 5; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ(3, fifoMap.size());
+EXPECT_EQ(2, fifoMap.begin()->first);
+EXPECT_TRUE(fifoMap.find(1) == fifoMap.end());
+
+DynamicFIFOHashMap copiedMap(fifoMap);
+EXPECT_EQ(3, copiedMap.capacity());
+EXPECT_EQ(2, copiedMap.begin()->first);
+
+EXPECT_THROW(DynamicFIFOHashMap(0), std::invalid_argument);
+EXPECT_THROW(fifoMap.set_capacity(0), std::invalid_argument);
+EXPECT_EQ(3, fifoMap.capacity());
+
+/*A compile time N keeps its map free of capacity state*/
+EXPECT_LT(sizeof(FIFOHashMap<int, int, 3>), sizeof(fifoMap));
+}
+
+TEST(FIFOHashMapDynamicCapacityTest,MoveTakesTheStorage)
+{
+using Map = FIFOHashMap<int, int, 8>;
+static_assert(std::is_nothrow_move_constructible<Map>::value, "Moving a map allocates nothing");
+static_assert(std::is_nothrow_move_assignable<Map>::value, "Moving a map allocates nothing");
+
+/*A vector of maps moves them when it grows, so the elements stay where they are*/
+std::vector<Map> maps(1);
+maps[0].insert({1, 1});
+const std::pair<const int, int> *element = &*maps[0].begin();
+maps.resize(maps.capacity() + 1);
+EXPECT_EQ(element, &*maps[0].begin());
+
+/*A moved-from map keeps its capacity, and so does one that was moved from twice*/
+DynamicFIFOHashMap dynamicMap(3);
+dynamicMap.insert({1, 1});
+DynamicFIFOHashMap movedMap(std::move(dynamicMap));
+DynamicFIFOHashMap movedAgain(std::move(dynamicMap));
+EXPECT_EQ(3, dynamicMap.capacity());
+EXPECT_EQ(3, movedAgain.capacity());
+EXPECT_TRUE(movedAgain.find(1) == movedAgain.end());
+dynamicMap.set_capacity(5);
+for(int i = 0; i < 7; i++)
+{
+dynamicMap.insert({i, i});
+}
+EXPECT_EQ(5, dynamicMap.size());
+EXPECT_EQ(2, dynamicMap.begin()->first);
+
+RingFIFOHashMap ringMap;
+ringMap.insert({1, "One"});
+RingFIFOHashMap movedRing(std::move(ringMap));
+ringMap = movedRing;
+EXPECT_EQ("One", ringMap.find(1)->second);
+RingFIFOHashMap emptyRing(std::move(movedRing));
+EXPECT_EQ(1, emptyRing.size());
+EXPECT_EQ(0, movedRing.size());
+movedRing.insert({2, "Two"});
+EXPECT_EQ(2, movedRing.begin()->first);
+}
+
+TEST(FIFOHashMapDynamicCapacityTest,ShrinkEvictsOldestToSink)
+{
+FIFOHashMap<int, std::string, FIFOHashMapDynamicCapacity,
+        std::allocator<std::pair<const int, std::string>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapEvictionSink<CollectingSink>> fifoMap(10);
+std::vector<std::pair<int, std::string>> evicted;
+fifoMap.eviction_sink().pEvicted = &evicted;
+for(int i = 0; i < 10; i++)
+{
+fifoMap.insert({i, std::to_string(i)});
+}
+
+fifoMap.set_capacity(4);
+EXPECT_EQ(4, fifoMap.capacity());
+EXPECT_EQ(4, fifoMap.size());
+ASSERT_EQ(6, evicted.size());
+for(int i = 0; i < 6; i++)
+{
+EXPECT_EQ(i, evicted[i].first);
+EXPECT_EQ(std::to_string(i), evicted[i].second);
+}
+
+int expectedKey = 6;
+for(auto it = fifoMap.begin(); it != fifoMap.end(); it++)
+{
+EXPECT_EQ(expectedKey, it->first);
+EXPECT_EQ(std::to_string(expectedKey), fifoMap.find(expectedKey)->second);
+expectedKey++;
+}
+fifoMap.insert({10, "10"});
+EXPECT_EQ(6, evicted.back().first);
+EXPECT_EQ(7, fifoMap.begin()->first);
+}
+
+TEST(FIFOHashMapDynamicCapacityTest,GrowMigratesBucketsIncrementally)
+{
+DynamicFIFOHashMap fifoMap(1000);
+for(int i = 0; i < 1000; i++)
+{
+fifoMap.insert({i, i});
+}
+const size_t smallUsage = fifoMap.memory_usage();
+
+fifoMap.set_capacity(5000);
+EXPECT_EQ(1024 * 7, fifoMap.bucket_count());
+/*Both bucket arrays are held until the old one is drained*/
+EXPECT_EQ(smallUsage + 4000 * sizeof(FIFOHashMapCell<int, int>) + 1024 * sizeof(FIFOHashMapBucketGroup), fifoMap.memory_usage());
+for(int i = 0; i < 1000; i++)
+{
+ASSERT_FALSE(fifoMap.find(i) == fifoMap.end());
+EXPECT_EQ(i, fifoMap.find(i)->second);
+}
+EXPECT_TRUE(fifoMap.find(1000) == fifoMap.end());
+EXPECT_EQ(sizeof(fifoMap) + 5000 * sizeof(FIFOHashMapCell<int, int>) + 1024 * sizeof(FIFOHashMapBucketGroup), fifoMap.memory_usage());
+
+for(int i = 1000; i < 6000; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ(5000, fifoMap.size());
+EXPECT_EQ(1000, fifoMap.begin()->first);
+}
+
+/**
+ * @brief Random insert/erase/pop churn with random capacity changes, checked against a std::list based reference.
+ */
+template<class Map, bool Erase>
+void checkResizeChurn()
+{
+size_t capacity = 16;
+Map fifoMap(capacity);
+std::list<std::pair<int,int>> reference;
+std::mt19937 generator(7);
+std::uniform_int_distribution<int> keyDistribution(0, 2000);
+std::uniform_int_distribution<size_t> capacityDistribution(1, 700);
+
+auto referenceFind = [&reference](int key)
+{
+return std::find_if(reference.begin(), reference.end(), [key](const std::pair<int,int> &p){return p.first == key;});
+};
+
+for(int step = 0; step < 30000; step++)
+{
+const int key = keyDistribution(generator);
+if(step % 500 == 0)
+{
+capacity = capacityDistribution(generator);
+fifoMap.set_capacity(capacity);
+while(reference.size() > capacity)
+{
+reference.pop_front();
+}
+}
+else if(Erase && (step % 4 == 0))
+{
+if constexpr (Erase)
+{
+auto referenceIter = referenceFind(key);
+EXPECT_EQ(referenceIter == reference.end() ? 0 : 1, fifoMap.erase(key));
+if(referenceIter != reference.end())
+{
+reference.erase(referenceIter);
+}
+}
+}
+else if(step % 7 == 0)
+{
+auto it = fifoMap.find(key);
+auto referenceIter = referenceFind(key);
+ASSERT_EQ(referenceIter == reference.end(), it == fifoMap.end());
+if(referenceIter != reference.end())
+{
+EXPECT_EQ(referenceIter->second, it->second);
+}
+}
+else
+{
+auto insertResult = fifoMap.insert({key, step});
+EXPECT_EQ(referenceFind(key) == reference.end(), insertResult.second);
+if(insertResult.second)
+{
+if(reference.size() == capacity)
+{
+reference.pop_front();
+}
+reference.emplace_back(key, step);
+}
+}
+ASSERT_EQ(reference.size(), fifoMap.size());
+}
+
+auto referenceIter = reference.begin();
+for(auto it = fifoMap.begin(); it != fifoMap.end(); it++)
+{
+EXPECT_EQ(referenceIter->first, it->first);
+EXPECT_EQ(referenceIter->second, it->second);
+EXPECT_EQ(referenceIter->second, fifoMap.find(it->first)->second);
+++referenceIter;
+}
+}
+
+TEST(FIFOHashMapDynamicCapacityTest,ResizeChurnMatchesReferenceModel)
+{
+checkResizeChurn<DynamicFIFOHashMap, true>();
+}
+
+TEST(FIFOHashMapDynamicCapacityTest,RingResizeChurnMatchesReferenceModel)
+{
+checkResizeChurn<DynamicRingFIFOHashMap, false>();
+}
+
+/**
+ * @brief Inserts random batches with repeated keys into two maps, as a range and one by one, and compares them.
+ */
+template<class Map>
+void checkInsertRange()
+{
+Map batchMap;
+Map singleMap;
+std::mt19937 generator(11);
+std::uniform_int_distribution<int> keyDistribution(0, 3 * MAX_ELEMENTS_TEST);
+std::uniform_int_distribution<size_t> lengthDistribution(0, 3 * MAX_ELEMENTS_TEST);
+
+for(int round = 0; round < 2000; round++)
+{
+std::vector<std::pair<int,std::string>> batch(lengthDistribution(generator));
+for(auto &pair : batch)
+{
+pair.first = keyDistribution(generator);
+pair.second = std::to_string(round);
+}
+size_t inserted = 0;
+for(auto &pair : batch)
+{
+inserted += singleMap.insert(pair).second;
+}
+if(round % 2 == 0)
+{
+ASSERT_EQ(inserted, batchMap.insert(batch.begin(), batch.end()));
+}
+else
+{
+/*A forward only range*/
+std::list<std::pair<int,std::string>> list(batch.begin(), batch.end());
+ASSERT_EQ(inserted, batchMap.insert(list.begin(), list.end()));
+}
+
+ASSERT_EQ(singleMap.size(), batchMap.size());
+auto singleIter = singleMap.begin();
+for(auto it = batchMap.begin(); it != batchMap.end(); it++, singleIter++)
+{
+ASSERT_EQ(singleIter->first, it->first);
+ASSERT_EQ(singleIter->second, it->second);
+}
+}
+}
+
+TEST(FIFOHashMapBatchTest,InsertRangeMatchesSingleInserts)
+{
+checkInsertRange<FIFOHashMap<int, std::string, MAX_ELEMENTS_TEST>>();
+}
+
+TEST(FIFOHashMapBatchTest,RingInsertRangeMatchesSingleInserts)
+{
+checkInsertRange<RingFIFOHashMap>();
+}
+
+TEST(FIFOHashMapBatchTest,InsertBatchMovesFrom)
+{
+FIFOHashMap<std::string, std::string, 4> fifoMap;
+fifoMap.insert({"b", "Old"});
+std::pair<std::string, std::string> batch[] = {{"a", "One"}, {"b", "Two"}, {"c", "Three"}};
+
+EXPECT_EQ(2, fifoMap.insert_batch(batch, 3));
+EXPECT_EQ(3, fifoMap.size());
+EXPECT_EQ("One", fifoMap.find("a")->second);
+EXPECT_EQ("Old", fifoMap.find("b")->second);
+EXPECT_TRUE(batch[0].second.empty());
+/*Not inserted - not moved from*/
+EXPECT_EQ("b", batch[1].first);
+EXPECT_EQ("Two", batch[1].second);
+}
+
+/**
+ * @brief find_batch and contains_batch against find, with absent keys and repeated keys in the batch.
+ */
+template<class Map>
+void checkFindBatch(Map &fifoMap, int keyRange)
+{
+std::mt19937 generator(5);
+std::uniform_int_distribution<int> keyDistribution(0, keyRange);
+std::uniform_int_distribution<size_t> lengthDistribution(0, 300);
+for(int round = 0; round < 200; round++)
+{
+std::vector<int> keys(lengthDistribution(generator));
+for(int &key : keys)
+{
+key = keyDistribution(generator);
+}
+std::vector<typename Map::iterator> results(keys.size(), fifoMap.end());
+std::vector<uint64_t> found((keys.size() + 63) / 64, ~uint64_t(0));
+fifoMap.find_batch(keys.data(), keys.size(), results.data());
+const size_t total = fifoMap.contains_batch(keys.data(), keys.size(), found.data());
+
+size_t expectedTotal = 0;
+for(size_t i = 0; i < keys.size(); i++)
+{
+auto it = fifoMap.find(keys[i]);
+ASSERT_TRUE(results[i] == it);
+ASSERT_EQ(it != fifoMap.end(), ((found[i / 64] >> (i % 64)) & 1) != 0);
+expectedTotal += (it != fifoMap.end());
+}
+EXPECT_EQ(expectedTotal, total);
+if(keys.size() % 64 != 0)
+{
+EXPECT_EQ(0, found.back() >> (keys.size() % 64));
+}
+}
+}
+
+TEST(FIFOHashMapBatchTest,FindBatchMatchesFind)
+{
+FIFOHashMap<int, int, 1000> fifoMap;
+for(int key = 0; key < 3000; key += 2)
+{
+fifoMap.insert({key, key});
+}
+checkFindBatch(fifoMap, 3000);
+
+RingFIFOHashMap ringMap;
+for(int key = 0; key < 20; key++)
+{
+ringMap.insert({key, std::to_string(key)});
+}
+checkFindBatch(ringMap, 30);
+}
+
+TEST(FIFOHashMapBatchTest,FindBatchWhileMigrating)
+{
+DynamicFIFOHashMap fifoMap(100);
+for(int key = 0; key < 100; key++)
+{
+fifoMap.insert({key, key});
+}
+fifoMap.set_capacity(5000);
+checkFindBatch(fifoMap, 200);
+}
+
+/*An allocator with state - every copy counts into the same counter*/
+template<class T>
+struct CountingAllocator
+{
+using value_type = T;
+std::shared_ptr<size_t> allocations;
+
+explicit CountingAllocator(std::shared_ptr<size_t> counter) : allocations(std::move(counter)) {}
+template<class U>
+CountingAllocator(const CountingAllocator<U> &other) : allocations(other.allocations) {}
+
+T *allocate(size_t count)
+{
+++*allocations;
+return std::allocator<T>().allocate(count);
+}
+
+void deallocate(T *pointer, size_t count)
+{
+std::allocator<T>().deallocate(pointer, count);
+}
+
+template<class U>
+bool operator==(const CountingAllocator<U> &other) const
+{
+return allocations == other.allocations;
+}
+
+template<class U>
+bool operator!=(const CountingAllocator<U> &other) const
+{
+return allocations != other.allocations;
+}
+};
+
+/*A hash with state*/
+struct SeededHash
+{
+size_t seed = 0;
+size_t operator()(int key) const
+{
+return std::hash<int>()(key) ^ seed;
+}
+};
+
+TEST(FIFOHashMapAllocatorTest,StatefulHashAndAllocator)
+{
+using Map = FIFOHashMap<int, int, 8, CountingAllocator<std::pair<const int, int>>, SeededHash>;
+auto counter = std::make_shared<size_t>(0);
+Map fifoMap(SeededHash{42}, std::equal_to<int>(), Map::allocator_type(counter));
+/*The cells and the buckets*/
+EXPECT_EQ(2, *counter);
+EXPECT_EQ(42, fifoMap.hash_function().seed);
+EXPECT_TRUE(fifoMap.get_allocator() == Map::allocator_type(counter));
+for(int i = 0; i < 20; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ(2, *counter);
+
+Map copy(fifoMap);
+EXPECT_EQ(4, *counter);
+EXPECT_EQ(42, copy.hash_function().seed);
+EXPECT_EQ(19, copy.find(19)->second);
+
+/*Move assignment between maps of different allocators copies the elements*/
+Map other(Map::allocator_type(std::make_shared<size_t>(0)));
+other = std::move(copy);
+EXPECT_EQ(42, other.hash_function().seed);
+EXPECT_EQ(8, other.size());
+EXPECT_TRUE(copy.empty());
+EXPECT_EQ(12, other.begin()->first);
+
+using DynamicMap = FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, CountingAllocator<std::pair<const int, int>>>;
+DynamicMap dynamicMap(4, DynamicMap::allocator_type(counter));
+for(int i = 0; i < 4; i++)
+{
+dynamicMap.insert({i, i});
+}
+dynamicMap.set_capacity(1000);
+dynamicMap.set_capacity(2);
+EXPECT_EQ(2, dynamicMap.size());
+EXPECT_LT(6, *counter);
+}
+
+TEST(FIFOHashMapAllocatorTest,PmrElementsUseThePool)
+{
+/*Any allocation from the default resource fails*/
+std::pmr::memory_resource *defaultResource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+{
+/*A key and a value per element, and the key of the next insertion*/
+FIFOHashMapPoolResource pool(64, 2 * 16 + 1, std::pmr::new_delete_resource());
+FIFOHashMapPmr<std::pmr::string, std::pmr::string, 16> fifoMap(&pool);
+const size_t arrays = pool.upstream_allocations();
+const std::string text(40, 'x');
+for(int i = 0; i < 1000; i++)
+{
+std::pmr::string key(text + std::to_string(i), &pool);
+fifoMap.try_emplace(std::move(key), text.c_str());
+}
+EXPECT_EQ(16, fifoMap.size());
+EXPECT_EQ(&pool, fifoMap.begin()->first.get_allocator().resource());
+EXPECT_EQ(&pool, fifoMap.begin()->second.get_allocator().resource());
+EXPECT_EQ(2 * 16, pool.blocks_in_use());
+EXPECT_EQ(arrays, pool.upstream_allocations());
+
+/*Larger than a block - from upstream*/
+fifoMap.insert_or_assign(std::pmr::string("k", &pool), std::string(100, 'y'));
+EXPECT_EQ(arrays + 1, pool.upstream_allocations());
+fifoMap.clear();
+EXPECT_EQ(0, pool.blocks_in_use());
+}
+std::pmr::set_default_resource(defaultResource);
+}
+
+/*Counts the allocations passed to new_delete_resource*/
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+size_t allocations = 0;
+
+protected:
+void *do_allocate(size_t bytes, size_t alignment) override
+{
+allocations++;
+return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+{
+std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+{
+return this == &other;
+}
+};
+
+TEST(FIFOHashMapRecycleTest,FullMapReusesTheEvictedStorage)
+{
+CountingResource resource;
+FIFOHashMapPmr<int, std::pmr::string, 8> fifoMap(&resource);
+const std::string text(40, 'x');
+for(int i = 0; i < 8; i++)
+{
+fifoMap.insert_or_assign(i, text);
+}
+const size_t allocations = resource.allocations;
+
+/*Every insertion evicts - the value is assigned into the string of the evicted element*/
+for(int i = 8; i < 100; i++)
+{
+fifoMap.insert_or_assign(i, text);
+}
+for(int i = 100; i < 110; i++)
+{
+fifoMap[i] = text;
+}
+for(int i = 110; i < 120; i++)
+{
+fifoMap.try_emplace(i, text);
+}
+EXPECT_EQ(allocations, resource.allocations);
+EXPECT_EQ(8, fifoMap.size());
+int expected = 112;
+for(auto &element : fifoMap)
+{
+EXPECT_EQ(expected++, element.first);
+EXPECT_EQ(text, std::string_view(element.second));
+}
+EXPECT_TRUE(fifoMap.find(111) == fifoMap.end());
+EXPECT_EQ(text, std::string_view(fifoMap.find(119)->second));
+}
+
+/*Assignment throws while armed*/
+struct ThrowingValue
+{
+static bool armed;
+int value = 0;
+
+ThrowingValue() = default;
+ThrowingValue(int v) : value(v) {}
+ThrowingValue(const ThrowingValue &other) = default;
+ThrowingValue &operator=(const ThrowingValue &other)
+{
+if(armed)
+{
+throw std::runtime_error("assignment");
+}
+value = other.value;
+return *this;
+}
+};
+bool ThrowingValue::armed = false;
+
+TEST(FIFOHashMapRecycleTest,ThrowingAssignmentEvicts)
+{
+FIFOHashMap<int, ThrowingValue, 4> fifoMap;
+for(int i = 0; i < 4; i++)
+{
+fifoMap.insert({i, ThrowingValue(i)});
+}
+ThrowingValue::armed = true;
+const ThrowingValue value(4);
+EXPECT_THROW(fifoMap.insert({4, value}), std::runtime_error);
+ThrowingValue::armed = false;
+
+/*The victim is gone and the new element was not inserted*/
+EXPECT_EQ(3, fifoMap.size());
+EXPECT_TRUE(fifoMap.find(0) == fifoMap.end());
+EXPECT_TRUE(fifoMap.find(4) == fifoMap.end());
+fifoMap.insert({5, ThrowingValue(5)});
+fifoMap.insert({6, ThrowingValue(6)});
+EXPECT_EQ(4, fifoMap.size());
+EXPECT_TRUE(fifoMap.find(1) == fifoMap.end());
+EXPECT_EQ(6, fifoMap.find(6)->second.value);
+EXPECT_EQ(2, fifoMap.begin()->first);
+}
+
+TEST(FIFOHashMapTraversalTest,IteratorsAreBidirectional)
+{
+using Map = FIFOHashMap<int, int, 8>;
+static_assert(std::is_same<std::bidirectional_iterator_tag,
+        std::iterator_traits<Map::iterator>::iterator_category>::value, "");
+static_assert(std::is_same<const std::pair<const int, int>&,
+        std::iterator_traits<Map::const_iterator>::reference>::value, "");
+static_assert(std::is_convertible<Map::iterator, Map::const_iterator>::value, "");
+static_assert(!std::is_convertible<Map::const_iterator, Map::iterator>::value, "");
+
+Map fifoMap;
+for(int i = 0; i < 5; i++)
+{
+fifoMap.insert({i, i * 10});
+}
+Map::iterator it = fifoMap.begin();
+EXPECT_EQ(0, (it++)->first);
+EXPECT_EQ(1, it->first);
+EXPECT_EQ(1, (it--)->first);
+EXPECT_EQ(0, it->first);
+EXPECT_EQ(4, std::prev(fifoMap.end())->first);
+EXPECT_EQ(0, std::prev(fifoMap.rend())->first);
+EXPECT_TRUE(Map::iterator{} == Map::iterator{});
+
+const Map &constMap = fifoMap;
+EXPECT_EQ(5, std::distance(constMap.begin(), constMap.end()));
+EXPECT_TRUE(Map::const_iterator(fifoMap.begin()) == fifoMap.cbegin());
+auto found = std::find_if(fifoMap.cbegin(), fifoMap.cend(), [](const std::pair<const int, int> &element)
+{
+    return element.second == 30;
+});
+EXPECT_EQ(3, found->first);
+std::vector<int> reversed;
+std::transform(constMap.rbegin(), constMap.rend(), std::back_inserter(reversed),
+               [](const std::pair<const int, int> &element) { return element.first; });
+EXPECT_EQ(std::vector<int>({4, 3, 2, 1, 0}), reversed);
+std::vector<int> backwards;
+for(auto last = fifoMap.cend(); last != fifoMap.cbegin(); )
+{
+    backwards.push_back((--last)->first);
+}
+EXPECT_EQ(reversed, backwards);
+}
+
+TEST(FIFOHashMapTraversalTest,EraseReturnsTheFollowingIterator)
+{
+using Map = FIFOHashMap<int, int, 8>;
+Map fifoMap;
+for(int i = 0; i < 6; i++)
+{
+fifoMap.insert({i, i});
+}
+
+/*Erasing every other element in the usual loop visits each element once*/
+std::vector<int> visited;
+for(auto it = fifoMap.begin(); it != fifoMap.end(); )
+{
+visited.push_back(it->first);
+it = (it->first % 2 == 0) ? fifoMap.erase(it) : std::next(it);
+}
+EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), visited);
+EXPECT_EQ(3, fifoMap.size());
+
+/*The last element - 5 - is followed by end()*/
+EXPECT_TRUE(fifoMap.erase(std::prev(fifoMap.end())) == fifoMap.end());
+
+/*Through a reverse iterator the following element is the previous one, and rend() follows the first*/
+fifoMap.insert({6, 6});
+Map::iterator it = fifoMap.erase(fifoMap.rbegin());
+EXPECT_EQ(3, it->first);
+EXPECT_EQ(1, (++it)->first);
+EXPECT_TRUE(++it == fifoMap.rend());
+it = fifoMap.erase(std::prev(fifoMap.rend()));
+EXPECT_TRUE(it == fifoMap.rend());
+EXPECT_EQ(1, fifoMap.size());
+EXPECT_EQ(3, fifoMap.begin()->first);
+}
+
+TEST(FIFOHashMapTraversalTest,ForEachGivesPositions)
+{
+FIFOHashMap<int, int, 8> fifoMap;
+for(int i = 0; i < 12; i++)
+{
+fifoMap.insert({i, 0});
+}
+fifoMap.erase(6);
+fifoMap.for_each([](std::pair<const int, int> &element, size_t position)
+{
+    element.second = static_cast<int>(position);
+});
+std::vector<std::pair<int, int>> elements;
+const auto &constMap = fifoMap;
+constMap.for_each([&elements](const std::pair<const int, int> &element, size_t)
+{
+    elements.emplace_back(element.first, element.second);
+});
+EXPECT_EQ((std::vector<std::pair<int, int>>{{4, 0}, {5, 1}, {7, 2}, {8, 3}, {9, 4}, {10, 5}, {11, 6}}), elements);
+
+/*Small maps run on the calling thread*/
+std::vector<size_t> positions;
+fifoMap.for_each_parallel([&positions](std::pair<const int, int> &, size_t position)
+{
+    positions.push_back(position);
+}, 4);
+EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3, 4, 5, 6}), positions);
+}
+
+/*Runs for_each_parallel on a map whose list order is not the cell order, and erase_if on the elements at odd
+ *positions, checking both against a serial walk*/
+template<bool CAN_ERASE, class Map>
+void checkParallelTraversal(Map &fifoMap)
+{
+std::vector<int> order;
+for(const auto &element : fifoMap)
+{
+    order.push_back(element.first);
+}
+std::vector<int> byPosition(order.size(), -1);
+std::atomic<size_t> calls{0};
+fifoMap.for_each_parallel([&byPosition, &calls](std::pair<const int, int> &element, size_t position)
+{
+    byPosition[position] = element.first;
+    calls++;
+}, 4);
+EXPECT_EQ(order.size(), calls.load());
+EXPECT_EQ(order, byPosition);
+
+if constexpr (CAN_ERASE)
+{
+    const size_t erased = fifoMap.erase_if([](const std::pair<const int, int> &, size_t position)
+    {
+        return position % 2 == 1;
+    }, 4);
+    EXPECT_EQ(order.size() / 2, erased);
+    std::vector<int> kept;
+    for(size_t i = 0; i < order.size(); i += 2)
+    {
+        kept.push_back(order[i]);
+    }
+    std::vector<int> remaining;
+    for(const auto &element : fifoMap)
+    {
+        remaining.push_back(element.first);
+    }
+    EXPECT_EQ(kept, remaining);
+    EXPECT_EQ(kept.size(), fifoMap.size());
+    EXPECT_TRUE(fifoMap.find(order[1]) == fifoMap.end());
+    EXPECT_EQ(order[2], fifoMap.find(order[2])->first);
+}
+}
+
+TEST(FIFOHashMapTraversalTest,ParallelMatchesSerial)
+{
+using LruMap = FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapLruEviction>;
+LruMap lruMap(200000);
+std::mt19937 generator(7);
+for(int i = 0; i < 250000; i++)
+{
+lruMap.insert({i, i});
+if(i % 5 == 0)
+{
+    lruMap.erase(static_cast<int>(generator() % (i + 1)));
+}
+if(i % 3 == 0)
+{
+    lruMap.find(static_cast<int>(generator() % (i + 1)));
+}
+}
+checkParallelTraversal<true>(lruMap);
+
+using RingMap = FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, std::allocator<std::pair<const int, int>>,
+        std::hash<int>, std::equal_to<int>, FIFOHashMapRingOrder>;
+RingMap ringMap(100000);
+for(int i = 0; i < 130000; i++)
+{
+ringMap.insert({i, i});
+}
+checkParallelTraversal<false>(ringMap);
+}
+
+TEST(FIFOHashMapTraversalTest,EraseIfAndExceptions)
+{
+FIFOHashMap<int, int, 16> fifoMap;
+for(int i = 0; i < 16; i++)
+{
+fifoMap.insert({i, i});
+}
+EXPECT_EQ(8, fifoMap.erase_if([](const std::pair<const int, int> &element, size_t)
+{
+    return element.first % 2 == 0;
+}));
+EXPECT_EQ(8, fifoMap.size());
+EXPECT_EQ(1, fifoMap.begin()->first);
+EXPECT_EQ(15, std::prev(fifoMap.end())->first);
+fifoMap.insert({16, 16});
+EXPECT_EQ(16, std::prev(fifoMap.end())->first);
+
+FIFOHashMap<int, int, FIFOHashMapDynamicCapacity> largeMap(100000);
+for(int i = 0; i < 100000; i++)
+{
+largeMap.insert({i, i});
+}
+EXPECT_THROW(largeMap.for_each_parallel([](std::pair<const int, int> &element, size_t)
+{
+    if(element.first == 77777)
+    {
+        throw std::runtime_error("visit");
+    }
+}, 4), std::runtime_error);
+EXPECT_EQ(100000, largeMap.size());
+}
+
+/*Checks every aggregate of fifoMap against the values it holds*/
+template<class Map>
+void checkAggregates(Map &fifoMap)
+{
+long long sum = 0;
+int minimum = std::numeric_limits<int>::max();
+int maximum = std::numeric_limits<int>::lowest();
+for(const auto &element : fifoMap)
+{
+    sum += element.second;
+    minimum = std::min(minimum, element.second);
+    maximum = std::max(maximum, element.second);
+}
+ASSERT_EQ(fifoMap.size(), fifoMap.template aggregate<FIFOHashMapCount>());
+ASSERT_EQ(sum, fifoMap.template aggregate<FIFOHashMapSum<long long>>());
+ASSERT_EQ(minimum, fifoMap.template aggregate<FIFOHashMapMin<int>>());
+ASSERT_EQ(maximum, fifoMap.template aggregate<FIFOHashMapMax<int>>());
+}
+
+using IntAggregates = FIFOHashMapAggregates<FIFOHashMapCount, FIFOHashMapSum<long long>, FIFOHashMapMin<int>,
+        FIFOHashMapMax<int>>;
+
+/*Random inserts, assignments, erasures, pops and lookups, checking the aggregates after each*/
+template<bool CAN_ERASE, class... Policies>
+void checkAggregateChurn()
+{
+FIFOHashMap<int, int, FIFOHashMapDynamicCapacity, std::allocator<std::pair<const int, int>>, std::hash<int>,
+        std::equal_to<int>, IntAggregates, Policies...> fifoMap(64);
+std::mt19937 generator(11);
+for(int i = 0; i < 20000; i++)
+{
+    const int key = static_cast<int>(generator() % 200);
+    const int value = static_cast<int>(generator() % 1000) - 500;
+    switch(generator() % 10)
+    {
+        case 0:
+            fifoMap.insert_or_assign(key, value);
+            break;
+        case 1:
+            if constexpr (CAN_ERASE)
+            {
+                fifoMap.erase(key);
+            }
+            break;
+        case 2:
+            fifoMap.pop();
+            break;
+        case 3:
+            if(value % 2 == 0)
+            {
+                fifoMap.find(key);
+            }
+            else
+            {
+                fifoMap[key] += value;
+            }
+            break;
+        case 4:
+            if(i % 1000 == 4)
+            {
+                fifoMap.set_capacity(16 + generator() % 100);
+            }
+            break;
+        default:
+            fifoMap.insert({key, value});
+            break;
+    }
+    checkAggregates(fifoMap);
+}
+fifoMap.clear();
+checkAggregates(fifoMap);
+}
+
+TEST(FIFOHashMapAggregatesTest,SlidingWindow)
+{
+FIFOHashMap<int, double, 4, std::allocator<std::pair<const int, double>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapAggregates<FIFOHashMapCount, FIFOHashMapSum<double>, FIFOHashMapMean<double>,
+                FIFOHashMapMin<double>, FIFOHashMapMax<double>>> window;
+EXPECT_EQ(0, window.aggregate<FIFOHashMapCount>());
+EXPECT_TRUE(std::isnan(window.aggregate<FIFOHashMapMean<double>>()));
+EXPECT_EQ(std::numeric_limits<double>::infinity(), window.aggregate<FIFOHashMapMin<double>>());
+
+for(int i = 0; i < 4; i++)
+{
+window.insert({i, double(i + 1)});
+}
+EXPECT_EQ(10.0, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(2.5, window.aggregate<FIFOHashMapMean<double>>());
+EXPECT_EQ(1.0, window.aggregate<FIFOHashMapMin<double>>());
+EXPECT_EQ(4.0, window.aggregate<FIFOHashMapMax<double>>());
+
+/*{2, 3, 4, 0.5} - the minimum leaves with the oldest element*/
+window.insert({4, 0.5});
+EXPECT_EQ(9.5, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(0.5, window.aggregate<FIFOHashMapMin<double>>());
+EXPECT_EQ(4.0, window.aggregate<FIFOHashMapMax<double>>());
+
+/*{2, 3, 10, 0.5}*/
+window.insert_or_assign(3, 10.0);
+EXPECT_EQ(15.5, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(10.0, window.aggregate<FIFOHashMapMax<double>>());
+/*{3, 10, 0.5}*/
+window.pop();
+EXPECT_EQ(3, window.aggregate<FIFOHashMapCount>());
+EXPECT_EQ(13.5, window.aggregate<FIFOHashMapSum<double>>());
+/*{3, 0.5, 0} - operator[] inserts a default value, and the assignments are the ones of insert_or_assign*/
+window.erase(3);
+window[5];
+EXPECT_EQ(3, window.aggregate<FIFOHashMapCount>());
+EXPECT_EQ(0.0, window.aggregate<FIFOHashMapMin<double>>());
+window.insert_or_assign(5, 7.0);
+EXPECT_EQ(10.5, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(7.0, window.aggregate<FIFOHashMapMax<double>>());
+/*{3, 0.5, 8} - and so are the writes through operator[]*/
+window[5] += 1.0;
+EXPECT_EQ(8.0, window.aggregate<FIFOHashMapMax<double>>());
+window[5] = 6.0;
+window[4] = -1.0;
+EXPECT_EQ(8.0, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(-1.0, window.aggregate<FIFOHashMapMin<double>>());
+window[4] = 0.5;
+window[5] = 7.0;
+
+/*Writes through a reference need a refresh*/
+window.find(5)->second = 1.0;
+window.refresh_aggregates();
+EXPECT_EQ(4.5, window.aggregate<FIFOHashMapSum<double>>());
+EXPECT_EQ(3.0, window.aggregate<FIFOHashMapMax<double>>());
+EXPECT_EQ(1.5, window.aggregate<FIFOHashMapMean<double>>());
+}
+
+TEST(FIFOHashMapAggregatesTest,MatchesARescan)
+{
+checkAggregateChurn<true>();
+checkAggregateChurn<false, FIFOHashMapRingOrder>();
+checkAggregateChurn<true, FIFOHashMapLruEviction>();
+checkAggregateChurn<true, FIFOHashMapSieveEviction>();
+}
+
+/*A minimum that counts the values it lifts*/
+struct CountingMin : FIFOHashMapMin<int>
+{
+static size_t lifts;
+
+template<class V>
+static int lift(const V &value)
+{
+    lifts++;
+    return value;
+}
+};
+size_t CountingMin::lifts = 0;
+
+TEST(FIFOHashMapAggregatesTest,MinIsIncrementalInFifoOrder)
+{
+FIFOHashMap<int, int, 1000, std::allocator<std::pair<const int, int>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapAggregates<CountingMin>> window;
+std::mt19937 generator(5);
+std::vector<int> values;
+for(int i = 0; i < 100000; i++)
+{
+values.push_back(static_cast<int>(generator() % 100000));
+window.insert_or_assign(i, values.back());
+if(values.size() > 1000)
+{
+    values.erase(values.begin());
+}
+if(i % 7 == 6)
+{
+    /*The head goes in order too*/
+    window.pop();
+    values.erase(values.begin());
+}
+ASSERT_EQ(*std::min_element(values.begin(), values.end()), window.aggregate<CountingMin>());
+}
+/*Each value was lifted once going in and at most once going out - the heap was never rebuilt*/
+EXPECT_GE(2 * 100000, CountingMin::lifts);
+}
+
+TEST(FIFOHashMapAggregatesTest,MinIsIncrementalOutOfOrder)
+{
+FIFOHashMap<int, int, 1000, std::allocator<std::pair<const int, int>>, std::hash<int>, std::equal_to<int>,
+        FIFOHashMapAggregates<CountingMin>> window;
+for(int i = 0; i < 1000; i++)
+{
+window.insert({i, i});
+}
+CountingMin::lifts = 0;
+/*Updates and erasures anywhere in the window, each followed by a query*/
+std::mt19937 generator(9);
+std::map<int, int> reference;
+for(const auto &element : window)
+{
+reference.insert(element);
+}
+for(int i = 0; i < 20000; i++)
+{
+const int key = static_cast<int>(generator() % 1000);
+const int value = static_cast<int>(generator() % 100000);
+switch(i % 3)
+{
+    case 0:
+        window.insert_or_assign(key, value);
+        reference[key] = value;
+        break;
+    case 1:
+        window[key] = value;
+        reference[key] = value;
+        break;
+    default:
+        window.erase(key);
+        reference.erase(key);
+        break;
+}
+int minimum = std::numeric_limits<int>::max();
+for(const auto &element : reference)
+{
+    minimum = std::min(minimum, element.second);
+}
+ASSERT_EQ(minimum, window.aggregate<CountingMin>());
+}
+/*A few lifts per change - a rescan of the window would take hundreds*/
+EXPECT_GE(3 * 20000, CountingMin::lifts);
+}
+
+TEST(FIFOHashMapStringKeysTest,LooksUpWithoutAString)
+{
+FIFOHashMapStringKeys<int, 4> fifoMap;
+fifoMap.insert({"alpha", 1});
+fifoMap.insert({"beta", 2});
+fifoMap.insert({"a key longer than the small string buffer", 3});
+
+const char buffer[] = "beta|alpha";
+const std::string_view beta(buffer, 4);
+EXPECT_EQ(2, fifoMap.find(beta)->second);
+EXPECT_EQ(1, fifoMap.find(std::string_view(buffer + 5, 5))->second);
+EXPECT_EQ(3, fifoMap.find("a key longer than the small string buffer")->second);
+EXPECT_TRUE(fifoMap.find(std::string_view(buffer, 3)) == fifoMap.end());
+EXPECT_EQ(2, fifoMap.find(std::string("beta"))->second);
+
+/*beta, then alpha, are the oldest*/
+fifoMap.moveElementToTail(std::string_view("alpha"));
+fifoMap.moveElementToHead(beta);
+EXPECT_EQ("beta", fifoMap.begin()->first);
+EXPECT_EQ("alpha", std::prev(fifoMap.end())->first);
+EXPECT_EQ(1, fifoMap.erase(beta));
+EXPECT_EQ(0, fifoMap.erase("beta"));
+EXPECT_EQ(2, fifoMap.size());
+/*erase of an iterator is still erase of an iterator*/
+fifoMap.erase(fifoMap.begin());
+EXPECT_EQ("alpha", fifoMap.begin()->first);
+}
+
+TEST(FIFOHashMapStringKeysTest,InlineString)
+{
+using Key = FIFOHashMapInlineString<32>;
+static_assert(sizeof(Key) == 32, "");
+const Key empty;
+EXPECT_TRUE(empty.empty());
+EXPECT_TRUE(empty.is_inline());
+
+const std::string longest(31, 's');
+const std::string tooLong(32, 'l');
+Key shortKey(longest);
+Key longKey(tooLong);
+EXPECT_TRUE(shortKey.is_inline());
+EXPECT_FALSE(longKey.is_inline());
+EXPECT_EQ(longest, shortKey.view());
+EXPECT_EQ(tooLong, longKey.view());
+EXPECT_TRUE(shortKey == Key(longest));
+EXPECT_TRUE(longKey == Key(tooLong));
+EXPECT_TRUE(shortKey != longKey);
+EXPECT_TRUE(Key("ab") != Key("abc"));
+EXPECT_TRUE(Key("abc") == "abc");
+EXPECT_TRUE(std::string("abc") == Key("abc"));
+EXPECT_TRUE(Key("abc") != std::string_view("abd"));
+EXPECT_EQ(std::hash<std::string_view>{}(tooLong), std::hash<Key>{}(longKey));
+EXPECT_EQ(FIFOHashMapStringHash{}(std::string("abc")), FIFOHashMapStringHash{}(Key("abc")));
+
+/*Copies own their characters, moves take them*/
+Key copy(longKey);
+Key moved(std::move(longKey));
+EXPECT_EQ(tooLong, copy.view());
+EXPECT_EQ(tooLong, moved.view());
+EXPECT_TRUE(longKey.empty());
+copy = shortKey;
+EXPECT_EQ(longest, copy.view());
+moved = std::move(copy);
+EXPECT_EQ(longest, moved.view());
+moved = moved;
+EXPECT_EQ(longest, moved.view());
+}
+
+TEST(FIFOHashMapStringKeysTest,InlineStringKeys)
+{
+const std::string path = testing::TempDir() + "fifo_map_inline_keys.bin";
+FIFOHashMapInlineStringKeys<int, 64> fifoMap;
+for(int i = 0; i < 100; i++)
+{
+/*Every tenth key is too long to be inline*/
+fifoMap.insert({"key-" + std::to_string(i) + ((i % 10 == 0) ? std::string(40, 'x') : std::string()), i});
+}
+EXPECT_EQ(64, fifoMap.size());
+EXPECT_TRUE(fifoMap.find("key-35") == fifoMap.end());
+EXPECT_EQ(36, fifoMap.find("key-36")->second);
+EXPECT_EQ(90, fifoMap.find("key-90" + std::string(40, 'x'))->second);
+EXPECT_EQ(99, fifoMap.find(std::string_view("key-99"))->second);
+fifoMap.insert_or_assign("key-99", -99);
+EXPECT_EQ(-99, fifoMap["key-99"]);
+EXPECT_EQ(1, fifoMap.erase("key-98"));
+
+fifoMap.save(path);
+FIFOHashMapInlineStringKeys<int, 64> loaded;
+loaded.load(path);
+EXPECT_EQ(63, loaded.size());
+EXPECT_EQ("key-36", loaded.begin()->first.view());
+EXPECT_EQ(90, loaded.find("key-90" + std::string(40, 'x'))->second);
+std::remove(path.c_str());
+}
@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <csignal>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../sh-data-struct/FIFOHashMap/SharedFifoHashMap.hpp"
+
+namespace
+{
+
+/*A name per test and process, removed when the test ends*/
+class SharedName
+{
+    std::string m_name;
+
+public:
+    explicit SharedName(const char *test) : m_name("/fifohashmap-" + std::string(test) + "-" + std::to_string(::getpid()))
+    {
+        SharedFIFOHashMap<int, int, 1>::remove(m_name);
+    }
+
+    ~SharedName()
+    {
+        SharedFIFOHashMap<int, int, 1>::remove(m_name);
+    }
+
+    const std::string &str() const
+    {
+        return m_name;
+    }
+};
+
+/*Runs child in a forked process and returns its exit code*/
+template<class Child>
+int runChild(Child child)
+{
+    const pid_t pid = ::fork();
+    if(pid == 0)
+    {
+        ::_exit(child());
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+}
+
+TEST(SharedFIFOHashMapTest,SingleProcess)
+{
+SharedName name("single");
+SharedFIFOHashMap<int, double, 4> sharedMap(name.str(), SharedFIFOHashMapMode::CREATE);
+EXPECT_EQ(4, sharedMap.capacity());
+EXPECT_TRUE(sharedMap.empty());
+
+EXPECT_TRUE(sharedMap.insert({1, 1.5}));
+EXPECT_FALSE(sharedMap.insert({1, 2.5}));
+EXPECT_EQ(1.5, sharedMap.find(1).value());
+EXPECT_FALSE(sharedMap.find(2).has_value());
+EXPECT_FALSE(sharedMap.insert_or_assign(1, 3.5));
+EXPECT_TRUE(sharedMap.insert_or_assign(2, 4.5));
+EXPECT_EQ(3.5, sharedMap.find(1).value());
+
+/*1 is the oldest*/
+sharedMap.insert({3, 0});
+sharedMap.insert({4, 0});
+sharedMap.insert({5, 0});
+EXPECT_EQ(4, sharedMap.size());
+EXPECT_FALSE(sharedMap.contains(1));
+EXPECT_TRUE(sharedMap.pop());
+EXPECT_FALSE(sharedMap.contains(2));
+EXPECT_EQ(1, sharedMap.erase(4));
+EXPECT_EQ(0, sharedMap.erase(4));
+EXPECT_EQ(2, sharedMap.size());
+sharedMap.clear();
+EXPECT_TRUE(sharedMap.empty());
+EXPECT_FALSE(sharedMap.pop());
+
+/*Churn through the free list and the buckets*/
+for(int i = 0; i < 1000; i++)
+{
+    sharedMap.insert({i, double(i)});
+    if(i % 3 == 0)
+    {
+        sharedMap.erase(i - 2);
+    }
+}
+for(int i : {996, 998, 999})
+{
+    EXPECT_EQ(double(i), sharedMap.find(i).value());
+}
+EXPECT_FALSE(sharedMap.contains(997));
+}
+
+TEST(SharedFIFOHashMapTest,AttachSeesTheSameMap)
+{
+SharedName name("attach");
+SharedFIFOHashMap<int, int, 64> creator(name.str(), SharedFIFOHashMapMode::CREATE);
+creator.insert({1, 10});
+
+EXPECT_THROW((SharedFIFOHashMap<int, int, 64>(name.str(), SharedFIFOHashMapMode::CREATE)), std::system_error);
+SharedFIFOHashMap<int, int, 64> attached(name.str(), SharedFIFOHashMapMode::ATTACH);
+EXPECT_EQ(10, attached.find(1).value());
+attached.insert({2, 20});
+EXPECT_EQ(20, creator.find(2).value());
+EXPECT_EQ(2, creator.size());
+
+/*The region must hold the same capacity and sizes of types*/
+EXPECT_THROW((SharedFIFOHashMap<int, int, 32>(name.str(), SharedFIFOHashMapMode::ATTACH)), std::runtime_error);
+EXPECT_THROW((SharedFIFOHashMap<int, double, 64>(name.str(), SharedFIFOHashMapMode::ATTACH)), std::runtime_error);
+EXPECT_THROW((SharedFIFOHashMap<int, int, 64>(name.str() + "-missing", SharedFIFOHashMapMode::ATTACH)),
+             std::system_error);
+}
+
+TEST(SharedFIFOHashMapTest,AcrossProcesses)
+{
+SharedName name("processes");
+using Map = SharedFIFOHashMap<uint64_t, uint64_t, 1 << 15>;
+Map sharedMap(name.str());
+
+/*Each child attaches and inserts its own keys while the others do*/
+constexpr int CHILDREN = 4;
+constexpr uint64_t KEYS = 4000;
+pid_t children[CHILDREN];
+for(int child = 0; child < CHILDREN; child++)
+{
+    children[child] = ::fork();
+    if(children[child] == 0)
+    {
+        Map childMap(name.str(), SharedFIFOHashMapMode::ATTACH);
+        for(uint64_t key = 0; key < KEYS; key++)
+        {
+            childMap.insert({child * KEYS + key, key});
+        }
+        ::_exit(0);
+    }
+}
+for(pid_t child : children)
+{
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+EXPECT_EQ(CHILDREN * KEYS, sharedMap.size());
+for(uint64_t key = 0; key < CHILDREN * KEYS; key++)
+{
+    EXPECT_EQ(key % KEYS, sharedMap.find(key).value());
+}
+
+/*And sees the changes of the parent*/
+sharedMap.erase(0);
+EXPECT_EQ(0, runChild([&name]
+{
+    Map childMap(name.str(), SharedFIFOHashMapMode::ATTACH);
+    return (!childMap.contains(0) && childMap.contains(1)) ? 0 : 1;
+}));
+}
+
+TEST(SharedFIFOHashMapTest,ProcessKilledWhileWriting)
+{
+/*A caller-mapped region, shared with the child by fork*/
+using Map = SharedFIFOHashMap<int, int, 256>;
+void *region = ::mmap(nullptr, Map::region_size(), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+ASSERT_NE(MAP_FAILED, region);
+{
+    Map sharedMap(region, true);
+    for(int round = 0; round < 20; round++)
+    {
+        const pid_t child = ::fork();
+        if(child == 0)
+        {
+            Map childMap(region, false);
+            for(int key = 0; ; key++)
+            {
+                childMap.insert_or_assign(key % 1000, key % 1000);
+                childMap.erase((key + 500) % 1000);
+            }
+        }
+        ::usleep(1000 * (round % 5));
+        ::kill(child, SIGKILL);
+        ::waitpid(child, nullptr, 0);
+
+        /*The mutex is taken over. The map is either intact or cleared, and keeps working*/
+        EXPECT_LE(sharedMap.size(), sharedMap.capacity());
+        size_t found = 0;
+        for(int key = 0; key < 1000; key++)
+        {
+            std::optional<int> value = sharedMap.find(key);
+            if(value.has_value())
+            {
+                EXPECT_EQ(key, *value);
+                found++;
+            }
+        }
+        EXPECT_EQ(found, sharedMap.size());
+        EXPECT_TRUE(sharedMap.insert_or_assign(-1, -1));
+        EXPECT_EQ(1, sharedMap.erase(-1));
+    }
+}
+::munmap(region, Map::region_size());
+}
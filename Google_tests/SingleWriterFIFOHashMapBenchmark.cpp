@@ -0,0 +1,157 @@
+/*
+ * Reader scaling of SingleWriterFIFOHashMap against a FIFOHashMap behind a std::shared_mutex.
+ * One writer thread inserts new keys as fast as it can while 1 to 64 reader threads look up recent keys.
+ * Usage: SingleWriterFIFOHashMap_bench [milliseconds per run]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/SingleWriterFifoHashMap.hpp"
+
+namespace
+{
+
+constexpr size_t CAPACITY = 1 << 20;
+
+struct SharedLockMap
+{
+    std::shared_mutex m_mutex;
+    FIFOHashMap<uint64_t, uint64_t, CAPACITY> m_map;
+
+    void insert(uint64_t key, uint64_t value)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_map.insert({key, value});
+    }
+
+    bool contains(uint64_t key)
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_map.find(key) != m_map.end();
+    }
+};
+
+struct SingleWriterMap
+{
+    SingleWriterFIFOHashMap<uint64_t, uint64_t, CAPACITY> m_map;
+
+    void insert(uint64_t key, uint64_t value)
+    {
+        m_map.insert({key, value});
+    }
+
+    bool contains(uint64_t key)
+    {
+        return m_map.contains(key);
+    }
+};
+
+struct Throughput
+{
+    double m_reads;
+    double m_writes;
+};
+
+/**
+ * @return Million reads per second over all the readers, and million inserts per second of the writer.
+ */
+template<class Map>
+Throughput run(Map &map, int readerCount, int milliseconds)
+{
+    std::atomic<uint64_t> published{CAPACITY};
+    std::atomic<bool> done{false};
+    std::vector<uint64_t> reads(readerCount);
+    std::vector<uint64_t> hits(readerCount);
+    std::vector<std::thread> readers;
+    for(int r = 0; r < readerCount; r++)
+    {
+        readers.emplace_back([&map, &published, &done, &reads, &hits, r]()
+        {
+            std::mt19937_64 generator(r + 1);
+            /*Counted locally - neighbouring counters in the vectors would share a cache line*/
+            uint64_t readCount = 0;
+            uint64_t hitCount = 0;
+            while(!done.load(std::memory_order_relaxed))
+            {
+                const uint64_t newest = published.load(std::memory_order_relaxed);
+                hitCount += map.contains(newest - 1 - generator() % CAPACITY);
+                readCount++;
+            }
+            reads[r] = readCount;
+            hits[r] = hitCount;
+        });
+    }
+
+    /*The writer is timed from outside - behind a reader preferring lock it may not get to insert at all*/
+    uint64_t key = CAPACITY;
+    std::thread writer([&map, &published, &done, &key]()
+    {
+        while(!done.load(std::memory_order_relaxed))
+        {
+            map.insert(key, key);
+            key++;
+            if(key % 1024 == 0)
+            {
+                published.store(key, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    done.store(true);
+    writer.join();
+    for(std::thread &reader : readers)
+    {
+        reader.join();
+    }
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    uint64_t totalReads = 0;
+    for(uint64_t count : reads)
+    {
+        totalReads += count;
+    }
+    return {totalReads / seconds.count() / 1e6, (key - CAPACITY) / seconds.count() / 1e6};
+}
+
+template<class Map>
+std::unique_ptr<Map> filledMap()
+{
+    std::unique_ptr<Map> map = std::make_unique<Map>();
+    for(uint64_t key = 0; key < CAPACITY; key++)
+    {
+        map->insert(key, key);
+    }
+    return map;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const int milliseconds = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    std::printf("%u hardware threads, %d ms per run, 1 writer\n", std::thread::hardware_concurrency(), milliseconds);
+    std::printf("%8s %22s %22s\n", "readers", "shared_mutex read/write", "single writer read/write");
+    for(int readerCount = 1; readerCount <= 64; readerCount *= 2)
+    {
+        std::unique_ptr<SharedLockMap> sharedLockMap = filledMap<SharedLockMap>();
+        const Throughput sharedLock = run(*sharedLockMap, readerCount, milliseconds);
+        sharedLockMap.reset();
+
+        std::unique_ptr<SingleWriterMap> singleWriterMap = filledMap<SingleWriterMap>();
+        const Throughput singleWriter = run(*singleWriterMap, readerCount, milliseconds);
+        std::printf("%8d %11.2f %10.2f %11.2f %10.2f\n", readerCount,
+                    sharedLock.m_reads, sharedLock.m_writes, singleWriter.m_reads, singleWriter.m_writes);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../sh-data-struct/FIFOHashMap/SingleWriterFifoHashMap.hpp"
+
+TEST(SingleWriterFIFOHashMapTest,SingleThread)
+{
+SingleWriterFIFOHashMap<int, double, 4> singleWriterMap;
+EXPECT_EQ(4, singleWriterMap.capacity());
+EXPECT_TRUE(singleWriterMap.empty());
+
+EXPECT_TRUE(singleWriterMap.insert({1, 1.5}));
+EXPECT_FALSE(singleWriterMap.insert({1, 2.5}));
+EXPECT_EQ(1.5, singleWriterMap.find(1).value());
+EXPECT_FALSE(singleWriterMap.find(2).has_value());
+double value = 0;
+EXPECT_FALSE(singleWriterMap.find(2, value));
+EXPECT_TRUE(singleWriterMap.find(1, value));
+EXPECT_EQ(1.5, value);
+
+EXPECT_FALSE(singleWriterMap.insert_or_assign(1, 3.5));
+EXPECT_TRUE(singleWriterMap.insert_or_assign(2, 4.5));
+EXPECT_EQ(3.5, singleWriterMap.find(1).value());
+EXPECT_EQ(2, singleWriterMap.size());
+
+/*1 is the oldest - assigning does not refresh it*/
+singleWriterMap.insert({3, 0});
+singleWriterMap.insert({4, 0});
+singleWriterMap.insert({5, 0});
+EXPECT_EQ(4, singleWriterMap.size());
+EXPECT_FALSE(singleWriterMap.contains(1));
+EXPECT_TRUE(singleWriterMap.contains(2));
+EXPECT_TRUE(singleWriterMap.contains(5));
+
+EXPECT_TRUE(singleWriterMap.pop());
+EXPECT_FALSE(singleWriterMap.contains(2));
+singleWriterMap.clear();
+EXPECT_TRUE(singleWriterMap.empty());
+EXPECT_FALSE(singleWriterMap.pop());
+EXPECT_FALSE(singleWriterMap.contains(5));
+}
+
+TEST(SingleWriterFIFOHashMapTest,ChurnMatchesWindow)
+{
+constexpr int capacity = 1000;
+SingleWriterFIFOHashMap<uint64_t, uint64_t, capacity> singleWriterMap;
+std::mt19937_64 generator(7);
+/*Keys collide in the low bits, so evictions keep shifting long clusters*/
+for(uint64_t i = 0; i < 100000; i++)
+{
+singleWriterMap.insert({i << 20, i});
+if(i % 997 == 0)
+{
+for(uint64_t j = (i >= capacity) ? i - capacity + 1 : 0; j <= i; j++)
+{
+ASSERT_EQ(j, singleWriterMap.find(j << 20).value());
+}
+}
+const uint64_t absent = generator() % (i + 1);
+if(absent + capacity <= i)
+{
+ASSERT_FALSE(singleWriterMap.contains(absent << 20));
+}
+}
+}
+
+namespace
+{
+
+struct Record
+{
+    uint64_t m_key;
+    uint64_t m_inverse;
+    uint64_t m_triple;
+};
+
+}
+
+TEST(SingleWriterFIFOHashMapTest,ReadersDuringIngest)
+{
+constexpr size_t capacity = 4096;
+constexpr uint64_t inserts = 200000;
+constexpr int readerCount = 4;
+SingleWriterFIFOHashMap<uint64_t, Record, capacity> singleWriterMap;
+/*Keys below published are inserted, keys at least capacity below it may be evicted*/
+std::atomic<uint64_t> published{0};
+std::atomic<bool> done{false};
+std::atomic<int> tornReads{0};
+std::atomic<int> missedKeys{0};
+
+std::vector<std::thread> readers;
+for(int r = 0; r < readerCount; r++)
+{
+readers.emplace_back([&, r]()
+{
+std::mt19937_64 generator(r + 1);
+while(!done.load())
+{
+const uint64_t before = published.load();
+if(before == 0)
+{
+continue;
+}
+const uint64_t key = before - 1 - generator() % std::min<uint64_t>(before, 2 * capacity);
+const std::optional<Record> record = singleWriterMap.find(key);
+const uint64_t after = published.load();
+if(record)
+{
+if((record->m_key != key) || (record->m_inverse != ~key) || (record->m_triple != key * 3))
+{
+tornReads++;
+}
+}
+else if(key + capacity > after)
+{
+missedKeys++;
+}
+}
+});
+}
+
+for(uint64_t key = 0; key < inserts; key++)
+{
+singleWriterMap.insert({key, Record{key, ~key, key * 3}});
+published.store(key + 1);
+}
+done.store(true);
+for(std::thread &reader : readers)
+{
+reader.join();
+}
+
+EXPECT_EQ(0, tornReads.load());
+EXPECT_EQ(0, missedKeys.load());
+EXPECT_EQ(capacity, singleWriterMap.size());
+}
+
+TEST(SingleWriterFIFOHashMapTest,StatsCountReadersAndWriter)
+{
+constexpr size_t capacity = 1024;
+constexpr int readerCount = 4;
+constexpr int lookupsPerReader = 10000;
+SingleWriterFIFOHashMap<uint64_t, uint64_t, capacity, std::hash<uint64_t>, std::equal_to<uint64_t>,
+        FIFOHashMapStats> singleWriterMap;
+
+for(uint64_t key = 0; key < 2 * capacity; key++)
+{
+singleWriterMap.insert({key, key});
+}
+EXPECT_FALSE(singleWriterMap.insert({2 * capacity - 1, 0}));
+EXPECT_TRUE(singleWriterMap.pop());
+
+/*Keys capacity + 1 to 2 * capacity - 1 are left*/
+std::vector<std::thread> readers;
+for(int r = 0; r < readerCount; r++)
+{
+readers.emplace_back([&singleWriterMap]()
+{
+for(int i = 0; i < lookupsPerReader; i++)
+{
+singleWriterMap.contains(i % (2 * capacity));
+}
+});
+}
+for(std::thread &reader : readers)
+{
+reader.join();
+}
+
+FIFOHashMapStatistics stats = singleWriterMap.stats();
+EXPECT_EQ(2 * capacity, stats.m_insertions);
+EXPECT_EQ(1, stats.m_duplicates);
+EXPECT_EQ(capacity, stats.m_evictions);
+EXPECT_EQ(1, stats.m_pops);
+EXPECT_EQ(readerCount * lookupsPerReader, stats.m_hits + stats.m_misses);
+EXPECT_EQ(readerCount * lookupsPerReader, stats.m_probes);
+EXPECT_LE(stats.m_probes, stats.m_probeSteps);
+
+/*Each reader looks up every key about the same number of times, and finds a little under half of them*/
+size_t expectedHits = 0;
+for(int i = 0; i < lookupsPerReader; i++)
+{
+expectedHits += (i % (2 * capacity)) > capacity;
+}
+EXPECT_EQ(readerCount * expectedHits, stats.m_hits);
+
+singleWriterMap.reset_stats();
+EXPECT_EQ(0, singleWriterMap.stats().m_hits);
+}
@@ -0,0 +1,665 @@
+#ifndef FIFOHashMap_SharedFIFOHashMap_HPP
+#define FIFOHashMap_SharedFIFOHashMap_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FifoHashMap.hpp"
+
+/**
+ *Shared FIFO Hash Map
+
+A FIFO hash map that lives entirely in one block of shared memory, so several processes on a host can use the same
+map - one copy of the data and one hit ratio, instead of one per process. POSIX only.
+
+ Region:
+
+The block holds a header, N cells and the buckets, and nothing outside it points into it: cells are linked, and
+buckets refer to cells, by 32-bit indices into the cell array, so every process can map the block at its own address.
+The size is fixed by N (see region_size()). The map is either in a named POSIX shared memory object, which the first
+process creates and the others attach to, or in a block the caller mapped, e.g. a file mapped with MAP_SHARED.
+Attaching checks the header and does nothing else - there is nothing to rebuild.
+
+ Synchronization:
+
+Every operation takes a process-shared mutex in the header. The mutex is robust: if a process dies holding it, the
+next one to lock it takes it over. If the process died in the middle of a change, the map is cleared first - it is a
+cache, and a consistent empty map is better than a corrupt one.
+
+Since the data is shared by address-independent copies, K and V must be trivially copyable, and Hash must give the
+same hash in every process (std::hash of integers does). Lookups return copies of the values.
+
+ #include "SharedFifoHashMap.hpp"
+
+SharedFIFOHashMap<uint64_t, Quote, 1 << 20> quotes("/quotes");   // in every process
+quotes.insert({id, quote});
+std::optional<Quote> quote = quotes.find(id);
+ */
+
+/**
+ * @brief What the named constructor of SharedFIFOHashMap does if the shared memory object exists, or does not.
+ */
+enum class SharedFIFOHashMapMode
+{
+    /*Create the object - throws if it exists*/
+    CREATE,
+    /*Attach to the object - throws if it does not exist*/
+    ATTACH,
+    /*Attach to the object, or create it if it does not exist*/
+    CREATE_OR_ATTACH
+};
+
+/**
+ *
+ * @tparam K - key. Trivially copyable.
+ * @tparam V - Value. Trivially copyable and default constructible.
+ * @tparam N - The capacity.
+ * @tparam Hash, KeyEqual - Same as FIFOHashMap. Hash must be the same function in all the processes.
+ */
+template<
+        class K,
+        class V,
+        size_t N,
+        class Hash = std::hash<K>,
+        class KeyEqual = std::equal_to<K>
+>
+class SharedFIFOHashMap {
+
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "Elements are shared by all the processes that map the region - K and V must be trivially copyable");
+    static_assert((N > 0) && (N < UINT32_MAX), "The capacity must be positive and fit in 32 bits");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "The ready flag is shared between processes");
+
+    static constexpr uint32_t npos = UINT32_MAX;
+    static constexpr size_t BUCKETS = FIFOHashMapBucketCount(N);
+    static constexpr size_t BUCKET_MASK = BUCKETS - 1;
+    static constexpr uint64_t MAGIC = 0x50414d4846495348ULL;
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t READY = 1;
+
+    struct Cell {
+        K m_key;
+        V m_value;
+        uint32_t m_hash;
+        uint32_t m_prev;
+        uint32_t m_next;
+    };
+
+    struct Header {
+        /*Written once by the process that creates the region, and checked by the ones that attach - types are checked by size*/
+        uint64_t m_magic;
+        uint32_t m_version;
+        uint32_t m_keySize;
+        uint32_t m_valueSize;
+        uint32_t m_cellSize;
+        uint64_t m_capacity;
+        uint64_t m_regionSize;
+        /*0 while the creator initializes the region, READY after*/
+        std::atomic<uint32_t> m_state;
+
+        /*Guarded by m_mutex*/
+        pthread_mutex_t m_mutex;
+        /*Set while a change is in progress - still set when the mutex is taken over from a dead process*/
+        uint32_t m_changing;
+        uint32_t m_head;
+        uint32_t m_tail;
+        uint32_t m_freeHead;
+        uint64_t m_size;
+    };
+
+    static constexpr size_t alignUp(size_t offset)
+    {
+        return (offset + 63) & ~size_t(63);
+    }
+
+    static constexpr size_t CELLS_OFFSET = alignUp(sizeof(Header));
+    static constexpr size_t BUCKETS_OFFSET = alignUp(CELLS_OFFSET + N * sizeof(Cell));
+    static constexpr size_t REGION_SIZE = alignUp(BUCKETS_OFFSET + BUCKETS * sizeof(FIFOHashMapBucket));
+
+    /**
+     * @brief Holds the mutex of the region. A change marks the header while it is in progress.
+     */
+    class Lock {
+        SharedFIFOHashMap &m_map;
+        const bool m_change;
+
+    public:
+        Lock(SharedFIFOHashMap &map, bool change);
+        ~Lock();
+        Lock(const Lock&) = delete;
+        Lock &operator=(const Lock&) = delete;
+    };
+
+    /*Members - the region, mapped at an address of this process*/
+    Header *m_header = nullptr;
+    Cell *m_cells = nullptr;
+    FIFOHashMapBucket *m_buckets = nullptr;
+    /*Set if this object mapped the region itself, from a shared memory object*/
+    void *m_mapping = nullptr;
+    Hash m_hasher;
+    KeyEqual m_keyEqual;
+
+    /*Private methods*/
+    void attach(void *region, bool initialize);
+    void reset();
+    size_t findBucket(const K &key, uint32_t hash) const;
+    void insertNew(uint32_t hash, const K &key, const V &value);
+    void removeCell(uint32_t cellIndex);
+    void removeBucket(size_t hole);
+
+    static void waitFor(const std::string &name, bool (*ready)(int, void*), int fd, void *argument);
+
+    /*Methods*/
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+    /**
+     * @brief Maps the named POSIX shared memory object, creating and initializing it if needed.
+     * @param name - The name of the object, starting with '/', e.g. "/quotes".
+     * Throws std::system_error if the object can not be created, opened or mapped, and std::runtime_error if it
+     * holds a map of other types or capacity.
+     */
+    explicit SharedFIFOHashMap(const std::string &name, SharedFIFOHashMapMode mode = SharedFIFOHashMapMode::CREATE_OR_ATTACH);
+
+    /**
+     * @brief Uses a block of memory that the caller mapped and keeps mapped while the map is used.
+     * @param region - region_size() bytes, 64-byte aligned, shared by the processes (e.g. MAP_SHARED).
+     * @param initialize - true for the first user of the block, which makes it an empty map. The others pass false,
+     * and wait until it is done.
+     */
+    SharedFIFOHashMap(void *region, bool initialize);
+
+    SharedFIFOHashMap(const SharedFIFOHashMap &other) = delete;
+    SharedFIFOHashMap& operator=(const SharedFIFOHashMap &other) = delete;
+
+    /**
+     * @brief Unmaps the region - the map stays in it for the other processes. See remove().
+     */
+    ~SharedFIFOHashMap();
+
+    /**
+     * @brief Removes the named shared memory object. Processes that mapped it keep using it until they unmap it.
+     * @return false if there was no such object.
+     */
+    static bool remove(const std::string &name);
+
+    /**
+     * @return The bytes of shared memory a map takes.
+     */
+    static constexpr size_t region_size()
+    {
+        return REGION_SIZE;
+    }
+
+    /**
+     * @brief Insert new element to the map. If the key is already exist - do nothing.
+     * If the map is full, the oldest element is evicted.
+     * @return true if insertion happened, false if it did not.
+     */
+    bool insert(const value_type &value);
+
+    /**
+     * @brief If the key exists, assigns obj to its value. Otherwise inserts it like insert does.
+     * @return true if insertion took place and false if the assignment took place.
+     */
+    template<class M>
+    bool insert_or_assign(const K &key, M &&obj);
+
+    /**
+     * @brief Copies the value mapped to key.
+     * @return false if there is no such element - value is not modified.
+     */
+    bool find(const K &key, V &value);
+
+    /**
+     * @return A copy of the value mapped to key, or an empty optional if there is no such element.
+     */
+    std::optional<V> find(const K &key);
+
+    bool contains(const K &key);
+
+    /**
+     * @return Number of elements removed (0 or 1).
+     */
+    size_t erase(const K &key);
+
+    /**
+     * @brief Removes the oldest element.
+     * @return false if the map was empty.
+     */
+    bool pop();
+
+    void clear();
+
+    size_t size();
+
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+};
+
+/*SharedFIFOHashMap*/
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::SharedFIFOHashMap(const std::string &name, SharedFIFOHashMapMode mode)
+{
+    bool created = false;
+    int fd = -1;
+    if(mode != SharedFIFOHashMapMode::ATTACH)
+    {
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        created = (fd >= 0);
+        if(!created && ((errno != EEXIST) || (mode == SharedFIFOHashMapMode::CREATE)))
+        {
+            throw std::system_error(errno, std::generic_category(), "SharedFIFOHashMap: can not create " + name);
+        }
+    }
+    if(!created)
+    {
+        fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if(fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "SharedFIFOHashMap: can not open " + name);
+        }
+        /*The creator may not have sized it yet*/
+        waitFor(name, [](int descriptor, void*)
+        {
+            struct stat status{};
+            return (::fstat(descriptor, &status) == 0) && (status.st_size != 0);
+        }, fd, nullptr);
+    }
+    else if(::ftruncate(fd, REGION_SIZE) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "SharedFIFOHashMap: can not size " + name);
+    }
+
+    struct stat status{};
+    if((::fstat(fd, &status) != 0) || (static_cast<size_t>(status.st_size) != REGION_SIZE))
+    {
+        ::close(fd);
+        throw std::runtime_error("SharedFIFOHashMap: " + name + " holds a map of another size");
+    }
+    void *mapping = ::mmap(nullptr, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    /*The mapping keeps the object*/
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        throw std::system_error(error, std::generic_category(), "SharedFIFOHashMap: can not map " + name);
+    }
+    m_mapping = mapping;
+    try
+    {
+        attach(mapping, created);
+    }
+    catch(...)
+    {
+        ::munmap(mapping, REGION_SIZE);
+        throw;
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::SharedFIFOHashMap(void *region, bool initialize)
+{
+    attach(region, initialize);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::~SharedFIFOHashMap()
+{
+    if(m_mapping != nullptr)
+    {
+        ::munmap(m_mapping, REGION_SIZE);
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::remove(const std::string &name)
+{
+    return ::shm_unlink(name.c_str()) == 0;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::insert(const value_type &value)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(value.first));
+    Lock lock(*this, true);
+    if(m_buckets[findBucket(value.first, hash)].m_cell != npos)
+    {
+        return false;
+    }
+    insertNew(hash, value.first, value.second);
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+template<class M>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::insert_or_assign(const K &key, M &&obj)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    const V value(std::forward<M>(obj));
+    Lock lock(*this, true);
+    const uint32_t cellIndex = m_buckets[findBucket(key, hash)].m_cell;
+    if(cellIndex != npos)
+    {
+        m_cells[cellIndex].m_value = value;
+        return false;
+    }
+    insertNew(hash, key, value);
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::find(const K &key, V &value)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    Lock lock(*this, false);
+    const uint32_t cellIndex = m_buckets[findBucket(key, hash)].m_cell;
+    if(cellIndex == npos)
+    {
+        return false;
+    }
+    value = m_cells[cellIndex].m_value;
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+std::optional<V> SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::find(const K &key)
+{
+    V value;
+    if(!find(key, value))
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::contains(const K &key)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    Lock lock(*this, false);
+    return m_buckets[findBucket(key, hash)].m_cell != npos;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+size_t SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::erase(const K &key)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    Lock lock(*this, true);
+    const size_t bucket = findBucket(key, hash);
+    if(m_buckets[bucket].m_cell == npos)
+    {
+        return 0;
+    }
+    removeCell(m_buckets[bucket].m_cell);
+    return 1;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::pop()
+{
+    Lock lock(*this, true);
+    if(m_header->m_size == 0)
+    {
+        return false;
+    }
+    removeCell(m_header->m_head);
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::clear()
+{
+    Lock lock(*this, true);
+    reset();
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+size_t SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::size()
+{
+    Lock lock(*this, false);
+    return m_header->m_size;
+}
+
+/********************************************************************************/
+/*SharedFIFOHashMap - private*/
+/********************************************************************************/
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::attach(void *region, bool initialize)
+{
+    if(reinterpret_cast<uintptr_t>(region) % 64 != 0)
+    {
+        throw std::invalid_argument("SharedFIFOHashMap: the region must be 64-byte aligned");
+    }
+    char *base = static_cast<char*>(region);
+    m_header = reinterpret_cast<Header*>(base);
+    m_cells = reinterpret_cast<Cell*>(base + CELLS_OFFSET);
+    m_buckets = reinterpret_cast<FIFOHashMapBucket*>(base + BUCKETS_OFFSET);
+
+    if(initialize)
+    {
+        ::new (static_cast<void*>(&m_header->m_state)) std::atomic<uint32_t>(0);
+        m_header->m_magic = MAGIC;
+        m_header->m_version = VERSION;
+        m_header->m_keySize = sizeof(K);
+        m_header->m_valueSize = sizeof(V);
+        m_header->m_cellSize = sizeof(Cell);
+        m_header->m_capacity = N;
+        m_header->m_regionSize = REGION_SIZE;
+
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        const int result = pthread_mutex_init(&m_header->m_mutex, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        if(result != 0)
+        {
+            throw std::system_error(result, std::generic_category(), "SharedFIFOHashMap: can not create the mutex");
+        }
+        reset();
+        m_header->m_changing = 0;
+        /*Publishes the initialized region to the processes waiting to attach*/
+        m_header->m_state.store(READY, std::memory_order_release);
+        return;
+    }
+
+    waitFor("the region", [](int, void *header)
+    {
+        return static_cast<Header*>(header)->m_state.load(std::memory_order_acquire) == READY;
+    }, -1, m_header);
+    if((m_header->m_magic != MAGIC) || (m_header->m_version != VERSION) || (m_header->m_keySize != sizeof(K)) ||
+       (m_header->m_valueSize != sizeof(V)) || (m_header->m_cellSize != sizeof(Cell)) ||
+       (m_header->m_capacity != N) || (m_header->m_regionSize != REGION_SIZE))
+    {
+        throw std::runtime_error("SharedFIFOHashMap: the region holds a map of other types or capacity");
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::waitFor(const std::string &name, bool (*ready)(int, void*), int fd,
+                                                         void *argument)
+{
+    /*Another process is initializing - it takes well under a second, unless it died*/
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while(!ready(fd, argument))
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+        {
+            if(fd >= 0)
+            {
+                ::close(fd);
+            }
+            throw std::runtime_error("SharedFIFOHashMap: " + name + " was never initialized");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::reset()
+{
+    for(uint32_t index = 0; index < N; index++)
+    {
+        m_cells[index].m_next = (index + 1 < N) ? index + 1 : npos;
+    }
+    for(size_t bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        m_buckets[bucket] = FIFOHashMapBucket{};
+    }
+    m_header->m_head = npos;
+    m_header->m_tail = npos;
+    m_header->m_freeHead = 0;
+    m_header->m_size = 0;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+size_t SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::findBucket(const K &key, uint32_t hash) const
+{
+    /*Linear probing. A miss returns the empty bucket that ended the probe*/
+    for(size_t bucket = hash & BUCKET_MASK; ; bucket = (bucket + 1) & BUCKET_MASK)
+    {
+        const FIFOHashMapBucket &current = m_buckets[bucket];
+        if((current.m_cell == npos) ||
+           ((current.m_hash == hash) && m_keyEqual(m_cells[current.m_cell].m_key, key)))
+        {
+            return bucket;
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::insertNew(uint32_t hash, const K &key, const V &value)
+{
+    if(m_header->m_size == N)
+    {
+        removeCell(m_header->m_head);
+    }
+    /*Probed after the eviction - its bucket may now end the probe sequence of key*/
+    const size_t bucket = findBucket(key, hash);
+
+    const uint32_t index = m_header->m_freeHead;
+    Cell &cell = m_cells[index];
+    m_header->m_freeHead = cell.m_next;
+    cell.m_key = key;
+    cell.m_value = value;
+    cell.m_hash = hash;
+    cell.m_prev = m_header->m_tail;
+    cell.m_next = npos;
+    if(m_header->m_tail != npos)
+    {
+        m_cells[m_header->m_tail].m_next = index;
+    }
+    else
+    {
+        m_header->m_head = index;
+    }
+    m_header->m_tail = index;
+
+    m_buckets[bucket] = FIFOHashMapBucket{hash, index};
+    m_header->m_size++;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::removeCell(uint32_t cellIndex)
+{
+    Cell &cell = m_cells[cellIndex];
+    size_t bucket = cell.m_hash & BUCKET_MASK;
+    while(m_buckets[bucket].m_cell != cellIndex)
+    {
+        bucket = (bucket + 1) & BUCKET_MASK;
+    }
+    removeBucket(bucket);
+
+    (cell.m_prev != npos ? m_cells[cell.m_prev].m_next : m_header->m_head) = cell.m_next;
+    (cell.m_next != npos ? m_cells[cell.m_next].m_prev : m_header->m_tail) = cell.m_prev;
+    cell.m_prev = npos;
+    cell.m_next = m_header->m_freeHead;
+    m_header->m_freeHead = cellIndex;
+    m_header->m_size--;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+void SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::removeBucket(size_t hole)
+{
+    /*Backward shift deletion - the hole is refilled with a later key whose probe path crosses it*/
+    for(size_t next = (hole + 1) & BUCKET_MASK; m_buckets[next].m_cell != npos; next = (next + 1) & BUCKET_MASK)
+    {
+        const size_t home = m_buckets[next].m_hash & BUCKET_MASK;
+        if(((next - home) & BUCKET_MASK) >= ((next - hole) & BUCKET_MASK))
+        {
+            m_buckets[hole] = m_buckets[next];
+            hole = next;
+        }
+    }
+    m_buckets[hole] = FIFOHashMapBucket{};
+}
+
+/*Lock*/
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::Lock::Lock(SharedFIFOHashMap &map, bool change) : m_map(map), m_change(change)
+{
+    Header &header = *m_map.m_header;
+    const int result = pthread_mutex_lock(&header.m_mutex);
+    if(result == EOWNERDEAD)
+    {
+        /*The owner died - if it was changing the map, its state is unknown*/
+        if(header.m_changing)
+        {
+            m_map.reset();
+            header.m_changing = 0;
+        }
+        pthread_mutex_consistent(&header.m_mutex);
+    }
+    else if(result != 0)
+    {
+        throw std::system_error(result, std::generic_category(), "SharedFIFOHashMap: can not lock");
+    }
+    if(m_change)
+    {
+        header.m_changing = 1;
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+SharedFIFOHashMap<K, V, N, Hash, KeyEqual>::Lock::~Lock()
+{
+    Header &header = *m_map.m_header;
+    if(m_change)
+    {
+        header.m_changing = 0;
+    }
+    pthread_mutex_unlock(&header.m_mutex);
+}
+
+#endif //FIFOHashMap_SharedFIFOHashMap_HPP
@@ -0,0 +1,688 @@
+#ifndef FIFOHashMap_SingleWriterFIFOHashMap_HPP
+#define FIFOHashMap_SingleWriterFIFOHashMap_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "FifoHashMap.hpp"
+
+/**
+ *Single Writer FIFO Hash Map
+
+A FIFO hash map for one ingest thread and many query threads. The writer thread calls insert, insert_or_assign, pop
+and clear. Any thread may call find and contains at any time - they never take a lock and never write to shared
+memory, so readers do not slow down each other or the writer.
+
+ Sequence Locks:
+
+Every cell has a sequence number that the writer makes odd while it rewrites the cell and even again when it is done.
+A reader copies the key and value out of the cell and keeps the copy only if the sequence was even and did not change
+meanwhile - otherwise it retries. The buckets are split into stripes of 64 with a sequence number each: when an
+eviction moves buckets, the writer bumps the sequences of the stripes it writes to, and a reader retries if a stripe
+it probed through was changed. Inserting into an empty bucket does not move anything and is not guarded.
+So a reader retries only when the writer touched the same cell or the same 64 buckets during the lookup.
+
+Since a reader may copy a cell while it is being rewritten, K and V must be trivially copyable - the copy is
+discarded, but it must be harmless to make. Cells are reused in place and never freed, so no reclamation is needed.
+
+ Order of Eviction:
+
+Elements are kept in a ring, like FIFOHashMapRingOrder - there is no erase of arbitrary elements.
+
+ #include "SingleWriterFifoHashMap.hpp"
+
+SingleWriterFIFOHashMap<uint64_t, Quote, 1 << 20> quotes;
+
+quotes.insert({id, quote});                        // the ingest thread only
+std::optional<Quote> quote = quotes.find(id);      // any thread
+ */
+
+/**
+ * @brief The counters of a SingleWriterFIFOHashMap - none, unless it has the FIFOHashMapStats policy.
+ */
+template<bool Enabled>
+class SingleWriterFIFOHashMapCounters
+{
+protected:
+    void countLookup(bool, size_t) const
+    {
+    }
+
+    void countInsertion()
+    {
+    }
+
+    void countDuplicate()
+    {
+    }
+
+    void countEviction()
+    {
+    }
+
+    void countPop()
+    {
+    }
+};
+
+/*Readers count in slots of their own, one cache line each, and the writer in counters that only it writes -
+ *so counting adds no sharing between the threads. stats() sums them up.*/
+template<>
+class SingleWriterFIFOHashMapCounters<true>
+{
+    /*Reader threads beyond this many share slots - their counts are still exact*/
+    static constexpr size_t READER_SLOTS = 64;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> m_hits{0};
+        std::atomic<uint64_t> m_misses{0};
+        std::atomic<uint64_t> m_probeSteps{0};
+    };
+
+    std::unique_ptr<ReaderSlot[]> m_readers{new ReaderSlot[READER_SLOTS]};
+    alignas(64) std::atomic<uint64_t> m_insertions{0};
+    std::atomic<uint64_t> m_duplicates{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<uint64_t> m_pops{0};
+
+    static size_t readerSlot()
+    {
+        static std::atomic<size_t> nextSlot{0};
+        thread_local const size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+        return slot;
+    }
+
+    /*The writer is the only thread that increments - no read-modify-write needed*/
+    static void increment(std::atomic<uint64_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+protected:
+    void countLookup(bool found, size_t probeSteps) const
+    {
+        ReaderSlot &slot = m_readers[readerSlot()];
+        (found ? slot.m_hits : slot.m_misses).fetch_add(1, std::memory_order_relaxed);
+        slot.m_probeSteps.fetch_add(probeSteps, std::memory_order_relaxed);
+    }
+
+    void countInsertion()
+    {
+        increment(m_insertions);
+    }
+
+    void countDuplicate()
+    {
+        increment(m_duplicates);
+    }
+
+    void countEviction()
+    {
+        increment(m_evictions);
+    }
+
+    void countPop()
+    {
+        increment(m_pops);
+    }
+
+public:
+    /**
+     * @return The counters, summed over the reader slots. Any thread - while the map is in use, a snapshot.
+     * Probe steps are buckets: this map probes one bucket at a time.
+     */
+    FIFOHashMapStatistics stats() const
+    {
+        FIFOHashMapStatistics total;
+        for(size_t i = 0; i < READER_SLOTS; i++)
+        {
+            total.m_hits += m_readers[i].m_hits.load(std::memory_order_relaxed);
+            total.m_misses += m_readers[i].m_misses.load(std::memory_order_relaxed);
+            total.m_probeSteps += m_readers[i].m_probeSteps.load(std::memory_order_relaxed);
+        }
+        total.m_probes = total.m_hits + total.m_misses;
+        total.m_insertions = m_insertions.load(std::memory_order_relaxed);
+        total.m_duplicates = m_duplicates.load(std::memory_order_relaxed);
+        total.m_evictions = m_evictions.load(std::memory_order_relaxed);
+        total.m_pops = m_pops.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    /**
+     * @brief Sets the counters to 0. Writer thread only - lookups that run meanwhile may be counted before or after.
+     */
+    void reset_stats()
+    {
+        for(size_t i = 0; i < READER_SLOTS; i++)
+        {
+            m_readers[i].m_hits.store(0, std::memory_order_relaxed);
+            m_readers[i].m_misses.store(0, std::memory_order_relaxed);
+            m_readers[i].m_probeSteps.store(0, std::memory_order_relaxed);
+        }
+        m_insertions.store(0, std::memory_order_relaxed);
+        m_duplicates.store(0, std::memory_order_relaxed);
+        m_evictions.store(0, std::memory_order_relaxed);
+        m_pops.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ *
+ * @tparam K - key. Trivially copyable and default constructible.
+ * @tparam V - Value. Trivially copyable and default constructible.
+ * @tparam N - The capacity.
+ * @tparam Hash, KeyEqual - Same as FIFOHashMap. Both are called by the readers as well, concurrently.
+ * @tparam Policies - FIFOHashMapStats, for stats() and reset_stats(). Other policies do not apply.
+ */
+template<
+        class K,
+        class V,
+        size_t N,
+        class Hash = std::hash<K>,
+        class KeyEqual = std::equal_to<K>,
+        class... Policies
+>
+class SingleWriterFIFOHashMap : public SingleWriterFIFOHashMapCounters<
+        FIFOHashMapSelectPolicy<FIFOHashMapStatsPolicyTag, FIFOHashMapNoStats, Policies...>::type::enabled> {
+
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "Readers copy elements while they may be rewritten - K and V must be trivially copyable");
+    static_assert((N > 0) && (N < UINT32_MAX), "The capacity must be positive and fit in 32 bits");
+
+    template<class T>
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    static constexpr size_t BUCKETS = FIFOHashMapBucketCount(N);
+    static constexpr size_t BUCKET_MASK = BUCKETS - 1;
+    static constexpr size_t STRIPE_SHIFT = 6;
+    static constexpr size_t STRIPES = (BUCKETS + (size_t(1) << STRIPE_SHIFT) - 1) >> STRIPE_SHIFT;
+    /*A bucket holds the hash in the high half and the cell index in the low half, so it is published in one store*/
+    static constexpr uint64_t EMPTY_BUCKET = UINT64_MAX;
+
+    /*The key and value are kept as atomic words - a reader racing the writer reads stale words, never torn ones*/
+    struct Cell {
+        std::atomic<uint32_t> m_sequence;
+        /*Written and read by the writer only*/
+        uint32_t m_hash;
+        std::atomic<uint64_t> m_key[WORDS<K>];
+        std::atomic<uint64_t> m_value[WORDS<V>];
+    };
+
+    enum class ReadResult { FOUND, NOT_FOUND, RETRY };
+
+    /*Members - read by everyone*/
+    std::unique_ptr<Cell[]> m_cells;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_buckets;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_stripes;
+    Hash m_hasher;
+    KeyEqual m_keyEqual;
+
+    /*Members - written by the writer, on their own cache line so readers do not see it change*/
+    alignas(64) std::atomic<size_t> m_size;
+    size_t m_head;
+
+    /*Private methods*/
+    ReadResult tryFind(const K &key, uint32_t hash, V *value) const;
+    size_t writerFind(const K &key, uint32_t hash) const;
+    void evictHead();
+    void removeBucket(size_t bucket);
+    void writeCell(size_t cellIndex, uint32_t hash, const K &key, const V &value);
+    void writeValue(size_t cellIndex, const V &value);
+
+    static uint64_t bucketEntry(uint32_t hash, size_t cellIndex);
+    static uint32_t entryHash(uint64_t entry);
+    static size_t entryCell(uint64_t entry);
+
+    template<class T>
+    static void storeWords(std::atomic<uint64_t> *words, const T &object);
+    template<class T>
+    static void loadWords(const std::atomic<uint64_t> *words, T &object);
+
+    /*Methods*/
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+    SingleWriterFIFOHashMap();
+    SingleWriterFIFOHashMap(const SingleWriterFIFOHashMap &other) = delete;
+    SingleWriterFIFOHashMap& operator=(const SingleWriterFIFOHashMap &other) = delete;
+
+    /**
+     * @brief Insert new element to the map. If the key is already exist - do nothing.
+     * If the map is full, the oldest element is evicted. Writer thread only.
+     * @param value - (Key,Value) pair.
+     * @return true if insertion happened, false if it did not.
+     */
+    bool insert(const value_type &value);
+
+    /**
+     * @brief If the key exists, assigns obj to its value. Otherwise inserts it like insert does. Writer thread only.
+     * @return true if insertion took place and false if the assignment took place.
+     */
+    template<class M>
+    bool insert_or_assign(const K &key, M &&obj);
+
+    /**
+     * @brief Removes the oldest element. Writer thread only.
+     * @return false if the map was empty.
+     */
+    bool pop();
+
+    /**
+     * @brief Removes all the elements. Writer thread only.
+     */
+    void clear();
+
+    /**
+     * @brief Copies the value mapped to key. Any thread, lock free.
+     * @return false if there is no such element - value is not modified.
+     */
+    bool find(const K &key, V &value) const;
+
+    /**
+     * @return A copy of the value mapped to key, or an empty optional if there is no such element. Any thread.
+     */
+    std::optional<V> find(const K &key) const;
+
+    bool contains(const K &key) const;
+
+    /**
+     * @return Number of elements. From a reader thread it is only a snapshot.
+     */
+    size_t size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+};
+
+/*SingleWriterFIFOHashMap*/
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::SingleWriterFIFOHashMap()
+        : m_cells(new Cell[N]),
+          m_buckets(new std::atomic<uint64_t>[BUCKETS]),
+          m_stripes(new std::atomic<uint32_t>[STRIPES]),
+          m_size(0),
+          m_head(0)
+{
+    for(size_t i = 0; i < N; i++)
+    {
+        m_cells[i].m_sequence.store(0, std::memory_order_relaxed);
+    }
+    for(size_t i = 0; i < BUCKETS; i++)
+    {
+        m_buckets[i].store(EMPTY_BUCKET, std::memory_order_relaxed);
+    }
+    for(size_t i = 0; i < STRIPES; i++)
+    {
+        m_stripes[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+bool SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::insert(const value_type &value)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(value.first));
+    if(writerFind(value.first, hash) != BUCKETS)
+    {
+        this->countDuplicate();
+        return false;
+    }
+    size_t size = m_size.load(std::memory_order_relaxed);
+    if(size == N)
+    {
+        evictHead();
+        this->countEviction();
+        size--;
+    }
+    size_t cellIndex = m_head + size;
+    if(cellIndex >= N)
+    {
+        cellIndex -= N;
+    }
+    writeCell(cellIndex, hash, value.first, value.second);
+
+    size_t bucket = hash & BUCKET_MASK;
+    while(m_buckets[bucket].load(std::memory_order_relaxed) != EMPTY_BUCKET)
+    {
+        bucket = (bucket + 1) & BUCKET_MASK;
+    }
+    /*Publishes the cell - a reader that sees the bucket sees the cell written*/
+    m_buckets[bucket].store(bucketEntry(hash, cellIndex), std::memory_order_release);
+    m_size.store(size + 1, std::memory_order_relaxed);
+    this->countInsertion();
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+template<class M>
+bool SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::insert_or_assign(const K &key, M &&obj)
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    const size_t bucket = writerFind(key, hash);
+    if(bucket == BUCKETS)
+    {
+        return insert(value_type(key, std::forward<M>(obj)));
+    }
+    writeValue(entryCell(m_buckets[bucket].load(std::memory_order_relaxed)), V(std::forward<M>(obj)));
+    return false;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+bool SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::pop()
+{
+    if(empty())
+    {
+        return false;
+    }
+    evictHead();
+    this->countPop();
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::clear()
+{
+    while(!empty())
+    {
+        evictHead();
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+bool SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::find(const K &key, V &value) const
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    ReadResult result;
+    do
+    {
+        result = tryFind(key, hash, &value);
+    } while(result == ReadResult::RETRY);
+    return result == ReadResult::FOUND;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+std::optional<V> SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::find(const K &key) const
+{
+    V value;
+    if(!find(key, value))
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+bool SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::contains(const K &key) const
+{
+    const uint32_t hash = FIFOHashMapMixHash(m_hasher(key));
+    ReadResult result;
+    do
+    {
+        result = tryFind(key, hash, nullptr);
+    } while(result == ReadResult::RETRY);
+    return result == ReadResult::FOUND;
+}
+
+/********************************************************************************/
+/*SingleWriterFIFOHashMap - private*/
+/********************************************************************************/
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+typename SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::ReadResult
+SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::tryFind(const K &key, uint32_t hash, V *value) const
+{
+    /*Stripe sequences only grow, so their sum is unchanged exactly when none of them changed*/
+    const size_t firstStripe = (hash & BUCKET_MASK) >> STRIPE_SHIFT;
+    size_t stripeCount = 0;
+    uint64_t stripeSum = 0;
+    size_t stripe = STRIPES;
+    size_t probeSteps = 0;
+
+    ReadResult result = ReadResult::NOT_FOUND;
+    for(size_t bucket = hash & BUCKET_MASK; ; bucket = (bucket + 1) & BUCKET_MASK)
+    {
+        probeSteps++;
+        if((bucket >> STRIPE_SHIFT) != stripe)
+        {
+            stripe = bucket >> STRIPE_SHIFT;
+            const uint32_t sequence = m_stripes[stripe].load(std::memory_order_acquire);
+            if(sequence & 1)
+            {
+                return ReadResult::RETRY;
+            }
+            stripeSum += sequence;
+            stripeCount++;
+        }
+
+        const uint64_t entry = m_buckets[bucket].load(std::memory_order_acquire);
+        if(entry == EMPTY_BUCKET)
+        {
+            break;
+        }
+        if(entryHash(entry) != hash)
+        {
+            continue;
+        }
+
+        const Cell &cell = m_cells[entryCell(entry)];
+        const uint32_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+        if(sequence & 1)
+        {
+            return ReadResult::RETRY;
+        }
+        /*The key is compared only after the copy is known to be whole*/
+        K candidate;
+        loadWords(cell.m_key, candidate);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(cell.m_sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            return ReadResult::RETRY;
+        }
+        if(!m_keyEqual(candidate, key))
+        {
+            continue;
+        }
+        if(value)
+        {
+            V copy;
+            loadWords(cell.m_value, copy);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(cell.m_sequence.load(std::memory_order_relaxed) != sequence)
+            {
+                return ReadResult::RETRY;
+            }
+            *value = copy;
+        }
+        result = ReadResult::FOUND;
+        break;
+    }
+
+    /*An eviction that moved or removed a bucket we probed - the answer may be wrong*/
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t sum = 0;
+    for(size_t i = 0; i < stripeCount; i++)
+    {
+        sum += m_stripes[(firstStripe + i) % STRIPES].load(std::memory_order_relaxed);
+    }
+    if(sum != stripeSum)
+    {
+        return ReadResult::RETRY;
+    }
+    this->countLookup(result == ReadResult::FOUND, probeSteps);
+    return result;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+size_t SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::writerFind(const K &key, uint32_t hash) const
+{
+    for(size_t bucket = hash & BUCKET_MASK; ; bucket = (bucket + 1) & BUCKET_MASK)
+    {
+        const uint64_t entry = m_buckets[bucket].load(std::memory_order_relaxed);
+        if(entry == EMPTY_BUCKET)
+        {
+            return BUCKETS;
+        }
+        if(entryHash(entry) == hash)
+        {
+            K candidate;
+            loadWords(m_cells[entryCell(entry)].m_key, candidate);
+            if(m_keyEqual(candidate, key))
+            {
+                return bucket;
+            }
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::evictHead()
+{
+    Cell &cell = m_cells[m_head];
+    /*Readers that already copied the evicted element retry when they validate the cell*/
+    const uint32_t sequence = cell.m_sequence.load(std::memory_order_relaxed);
+    cell.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t bucket = cell.m_hash & BUCKET_MASK;
+    while(entryCell(m_buckets[bucket].load(std::memory_order_relaxed)) != m_head)
+    {
+        bucket = (bucket + 1) & BUCKET_MASK;
+    }
+    removeBucket(bucket);
+
+    cell.m_sequence.store(sequence + 2, std::memory_order_release);
+    m_head = (m_head + 1 == N) ? 0 : m_head + 1;
+    m_size.store(m_size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::removeBucket(size_t bucket)
+{
+    /*Backward shift deletion. Every stripe is made odd before its first bucket write, and even after the last one*/
+    const size_t firstStripe = bucket >> STRIPE_SHIFT;
+    size_t lastStripe = firstStripe;
+    m_stripes[firstStripe].store(m_stripes[firstStripe].load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t hole = bucket;
+    for(size_t next = (hole + 1) & BUCKET_MASK; ; next = (next + 1) & BUCKET_MASK)
+    {
+        const uint64_t entry = m_buckets[next].load(std::memory_order_relaxed);
+        if(entry == EMPTY_BUCKET)
+        {
+            break;
+        }
+        const size_t home = entryHash(entry) & BUCKET_MASK;
+        if(((next - home) & BUCKET_MASK) < ((next - hole) & BUCKET_MASK))
+        {
+            continue;
+        }
+        m_buckets[hole].store(entry, std::memory_order_relaxed);
+        hole = next;
+        if((hole >> STRIPE_SHIFT) != lastStripe)
+        {
+            lastStripe = hole >> STRIPE_SHIFT;
+            m_stripes[lastStripe].store(m_stripes[lastStripe].load(std::memory_order_relaxed) + 1,
+                                        std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
+    m_buckets[hole].store(EMPTY_BUCKET, std::memory_order_relaxed);
+
+    for(size_t stripe = firstStripe; ; stripe = (stripe + 1) % STRIPES)
+    {
+        m_stripes[stripe].store(m_stripes[stripe].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if(stripe == lastStripe)
+        {
+            break;
+        }
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::writeCell(size_t cellIndex, uint32_t hash,
+                                                                 const K &key, const V &value)
+{
+    Cell &cell = m_cells[cellIndex];
+    const uint32_t sequence = cell.m_sequence.load(std::memory_order_relaxed);
+    cell.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    cell.m_hash = hash;
+    storeWords(cell.m_key, key);
+    storeWords(cell.m_value, value);
+    cell.m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::writeValue(size_t cellIndex, const V &value)
+{
+    Cell &cell = m_cells[cellIndex];
+    const uint32_t sequence = cell.m_sequence.load(std::memory_order_relaxed);
+    cell.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    storeWords(cell.m_value, value);
+    cell.m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+uint64_t SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::bucketEntry(uint32_t hash, size_t cellIndex)
+{
+    return (static_cast<uint64_t>(hash) << 32) | static_cast<uint32_t>(cellIndex);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+uint32_t SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::entryHash(uint64_t entry)
+{
+    return static_cast<uint32_t>(entry >> 32);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+size_t SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::entryCell(uint64_t entry)
+{
+    return static_cast<uint32_t>(entry);
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+template<class T>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::storeWords(std::atomic<uint64_t> *words, const T &object)
+{
+    uint64_t buffer[WORDS<T>] = {};
+    std::memcpy(buffer, &object, sizeof(T));
+    for(size_t i = 0; i < WORDS<T>; i++)
+    {
+        words[i].store(buffer[i], std::memory_order_relaxed);
+    }
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual, class... Policies>
+template<class T>
+void SingleWriterFIFOHashMap<K, V, N, Hash, KeyEqual, Policies...>::loadWords(const std::atomic<uint64_t> *words, T &object)
+{
+    uint64_t buffer[WORDS<T>];
+    for(size_t i = 0; i < WORDS<T>; i++)
+    {
+        buffer[i] = words[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&object, buffer, sizeof(T));
+}
+
+#endif //FIFOHashMap_SingleWriterFIFOHashMap_HPP